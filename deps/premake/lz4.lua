@@ -0,0 +1,41 @@
+lz4 = {
+	source = path.join(dependencies.basePath, "lz4"),
+}
+
+function lz4.import()
+	links { "lz4" }
+	lz4.includes()
+end
+
+function lz4.includes()
+	includedirs {
+		path.join(lz4.source, "lib"),
+	}
+end
+
+function lz4.project()
+	project "lz4"
+		language "C"
+
+		lz4.includes()
+
+		files {
+			path.join(lz4.source, "lib/lz4.c"),
+			path.join(lz4.source, "lib/lz4.h"),
+			path.join(lz4.source, "lib/lz4frame.c"),
+			path.join(lz4.source, "lib/lz4frame.h"),
+			path.join(lz4.source, "lib/lz4hc.c"),
+			path.join(lz4.source, "lib/lz4hc.h"),
+			path.join(lz4.source, "lib/xxhash.c"),
+			path.join(lz4.source, "lib/xxhash.h"),
+		}
+
+		defines {
+			"XXH_NAMESPACE=LZ4_",
+		}
+
+		warnings "Off"
+		kind "StaticLib"
+end
+
+table.insert(dependencies, lz4)
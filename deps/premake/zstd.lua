@@ -0,0 +1,43 @@
+zstd = {
+	source = path.join(dependencies.basePath, "zstd"),
+}
+
+function zstd.import()
+	links { "zstd" }
+	zstd.includes()
+end
+
+function zstd.includes()
+	includedirs {
+		path.join(zstd.source, "lib"),
+	}
+end
+
+function zstd.project()
+	project "zstd"
+		language "C"
+
+		zstd.includes()
+
+		files {
+			path.join(zstd.source, "lib/common/*.c"),
+			path.join(zstd.source, "lib/common/*.h"),
+			path.join(zstd.source, "lib/compress/*.c"),
+			path.join(zstd.source, "lib/compress/*.h"),
+			path.join(zstd.source, "lib/decompress/*.c"),
+			path.join(zstd.source, "lib/decompress/*.h"),
+			path.join(zstd.source, "lib/dictBuilder/*.c"),
+			path.join(zstd.source, "lib/dictBuilder/*.h"),
+		}
+
+		defines {
+			"ZSTD_MULTITHREAD",
+			"ZSTD_DISABLE_ASM",
+			"XXH_NAMESPACE=ZSTD_",
+		}
+
+		warnings "Off"
+		kind "StaticLib"
+end
+
+table.insert(dependencies, zstd)
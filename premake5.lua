@@ -266,6 +266,9 @@ files {"./src/common/**.hpp", "./src/common/**.cpp"}
 
 includedirs {"./src/common", "%{prj.location}/src"}
 
+-- The MIME type table is built at compile time
+buildoptions {"/constexpr:steps10000000"}
+
 resincludedirs {"$(ProjectDir)src"}
 
 dependencies.imports()
@@ -297,6 +300,30 @@ end
 
 dependencies.imports()
 
+project "asset-packer"
+kind "ConsoleApp"
+language "C++"
+
+files {"./src/asset-packer/**.hpp", "./src/asset-packer/**.cpp"}
+
+includedirs {"./src/asset-packer", "./src/common", "%{prj.location}/src"}
+
+links {"common"}
+
+dependencies.imports()
+
+project "tests"
+kind "ConsoleApp"
+language "C++"
+
+files {"./src/tests/**.hpp", "./src/tests/**.cpp"}
+
+includedirs {"./src/tests", "./src/common", "%{prj.location}/src"}
+
+links {"common"}
+
+dependencies.imports()
+
 group "Dependencies"
 dependencies.projects()
 
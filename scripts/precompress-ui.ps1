@@ -0,0 +1,40 @@
+if ($args.Count -lt 1) {
+    Write-Output "Usage: <ui-folder>"
+    exit 1
+}
+
+$uiPath = $args[0]
+$extensions = @('.html', '.css', '.js', '.json', '.svg', '.txt', '.map')
+
+#-------------------------------------------------
+Write-Output 'Removing old variants...'
+#-------------------------------------------------
+
+Get-ChildItem -Path $uiPath -Recurse -File -Include '*.br', '*.gz' | Remove-Item
+
+#-------------------------------------------------
+Write-Output 'Compressing assets...'
+#-------------------------------------------------
+
+function Write-Variant($file, $extension, $createStream) {
+    $data = [System.IO.File]::ReadAllBytes($file.FullName)
+
+    $buffer = New-Object System.IO.MemoryStream
+    $stream = & $createStream $buffer
+    $stream.Write($data, 0, $data.Length)
+    $stream.Dispose()
+
+    # Variants that do not save anything are left out, the launcher serves the original instead
+    $compressed = $buffer.ToArray()
+    if ($compressed.Length -lt $data.Length) {
+        [System.IO.File]::WriteAllBytes($file.FullName + $extension, $compressed)
+    }
+}
+
+Get-ChildItem -Path $uiPath -Recurse -File | Where-Object { $extensions -contains $_.Extension } | ForEach-Object {
+    Write-Variant $_ '.br' { param($buffer) New-Object System.IO.Compression.BrotliStream($buffer, [System.IO.Compression.CompressionLevel]::SmallestSize) }
+    Write-Variant $_ '.gz' { param($buffer) New-Object System.IO.Compression.GZipStream($buffer, [System.IO.Compression.CompressionLevel]::SmallestSize) }
+}
+
+#-------------------------------------------------
+Write-Output 'Done!'
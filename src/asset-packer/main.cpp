@@ -0,0 +1,39 @@
+#include <utils/asset_pack.hpp>
+#include <utils/io.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string_view>
+
+using namespace std::literals;
+
+int main(const int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("Usage: %s <folder> <output> [--compress]\n", argv[0]);
+		return 1;
+	}
+
+	try
+	{
+		const auto compress = argc > 3 && argv[3] == "--compress"sv;
+		const auto data = utils::asset_pack::build(argv[1], compress);
+
+		// Parsing the result ensures the launcher will be able to read it
+		const utils::asset_pack pack(data);
+
+		if (!utils::io::write_file(argv[2], data))
+		{
+			throw std::runtime_error("Failed to write "s + argv[2]);
+		}
+
+		printf("Packed %zu files into %s (%zu bytes)\n", pack.get_entries().size(), argv[2], data.size());
+		return 0;
+	}
+	catch (const std::exception& e)
+	{
+		fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+}
@@ -0,0 +1,242 @@
+#include "asset_pack.hpp"
+#include "compression.hpp"
+#include "io.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace utils
+{
+	namespace
+	{
+		constexpr uint32_t pack_magic = 0x4B415058; // XPAK
+		constexpr uint32_t pack_version = 1;
+		constexpr size_t data_alignment = 64;
+		constexpr int compression_level = 19;
+
+		struct pack_header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t entry_count;
+			uint32_t path_table_size;
+		};
+
+		struct pack_entry
+		{
+			uint64_t data_offset;
+			uint64_t data_size;
+			uint64_t size;
+			uint32_t path_offset;
+			uint16_t path_length;
+			uint16_t compression;
+		};
+
+		static_assert(sizeof(pack_header) == 16);
+		static_assert(sizeof(pack_entry) == 32);
+
+		size_t align(const size_t offset)
+		{
+			return (offset + data_alignment - 1) & ~(data_alignment - 1);
+		}
+
+		std::string get_key(const std::string& path)
+		{
+			return std::filesystem::path(path).relative_path().lexically_normal().generic_string();
+		}
+
+		template <typename T>
+		T read_struct(const std::string_view data, const size_t offset)
+		{
+			if (offset > data.size() || data.size() - offset < sizeof(T))
+			{
+				throw std::runtime_error("Asset pack is truncated");
+			}
+
+			T value{};
+			std::memcpy(&value, data.data() + offset, sizeof(T));
+			return value;
+		}
+	}
+
+	asset_pack::asset_pack(const std::filesystem::path& file)
+		: file_(std::make_unique<mapped_file>(file))
+	{
+		this->parse(this->file_->get_data());
+	}
+
+	asset_pack::asset_pack(std::string data)
+		: data_(std::move(data))
+	{
+		this->parse(this->data_);
+	}
+
+	std::optional<asset_pack::entry> asset_pack::find(const std::string& path) const
+	{
+		const auto key = get_key(path);
+		const auto entry = std::lower_bound(this->entries_.begin(), this->entries_.end(), key,
+		                                    [](const asset_pack::entry& entry, const std::string& key)
+		                                    {
+			                                    return entry.path < key;
+		                                    });
+
+		if (entry == this->entries_.end() || entry->path != key)
+		{
+			return {};
+		}
+
+		return *entry;
+	}
+
+	const std::vector<asset_pack::entry>& asset_pack::get_entries() const
+	{
+		return this->entries_;
+	}
+
+	std::string asset_pack::read(const entry& entry) const
+	{
+		if (entry.compression == compression_type::none)
+		{
+			return std::string{entry.data};
+		}
+
+		auto data = compression::zstd::decompress(entry.data, entry.size);
+		if (data.size() != entry.size)
+		{
+			throw std::runtime_error("Asset pack entry " + std::string{entry.path} + " is corrupt");
+		}
+
+		return data;
+	}
+
+	std::string asset_pack::build(const std::filesystem::path& folder, const bool compress)
+	{
+		std::vector<std::string> paths{};
+		for (const auto& file : std::filesystem::recursive_directory_iterator(folder))
+		{
+			if (file.is_regular_file())
+			{
+				paths.emplace_back(file.path().lexically_relative(folder).generic_string());
+			}
+		}
+
+		std::sort(paths.begin(), paths.end());
+
+		std::string path_table{};
+		std::vector<pack_entry> entries{};
+		std::vector<std::string> blobs{};
+
+		for (const auto& path : paths)
+		{
+			if (path.size() > std::numeric_limits<uint16_t>::max())
+			{
+				throw std::runtime_error("Path is too long: " + path);
+			}
+
+			std::string data{};
+			if (!io::read_file((folder / path).string(), &data))
+			{
+				throw std::runtime_error("Failed to read " + path);
+			}
+
+			pack_entry entry{};
+			entry.path_offset = static_cast<uint32_t>(path_table.size());
+			entry.path_length = static_cast<uint16_t>(path.size());
+			entry.size = data.size();
+			entry.compression = static_cast<uint16_t>(compression_type::none);
+
+			// Only keep compressed data if it saves a meaningful amount of space
+			if (compress && !data.empty())
+			{
+				auto compressed_data = compression::zstd::compress(data, compression_level);
+				if (compressed_data.size() < data.size() - data.size() / 10)
+				{
+					data = std::move(compressed_data);
+					entry.compression = static_cast<uint16_t>(compression_type::zstd);
+				}
+			}
+
+			entry.data_size = data.size();
+
+			path_table.append(path);
+			entries.push_back(entry);
+			blobs.emplace_back(std::move(data));
+		}
+
+		pack_header header{};
+		header.magic = pack_magic;
+		header.version = pack_version;
+		header.entry_count = static_cast<uint32_t>(entries.size());
+		header.path_table_size = static_cast<uint32_t>(path_table.size());
+
+		auto offset = align(sizeof(header) + sizeof(pack_entry) * entries.size() + path_table.size());
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			entries[i].data_offset = offset;
+			offset = align(offset + blobs[i].size());
+		}
+
+		std::string result{};
+		result.reserve(offset);
+		result.append(reinterpret_cast<const char*>(&header), sizeof(header));
+		result.append(reinterpret_cast<const char*>(entries.data()), sizeof(pack_entry) * entries.size());
+		result.append(path_table);
+
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			result.resize(entries[i].data_offset);
+			result.append(blobs[i]);
+		}
+
+		return result;
+	}
+
+	void asset_pack::parse(const std::string_view data)
+	{
+		const auto header = read_struct<pack_header>(data, 0);
+		if (header.magic != pack_magic || header.version != pack_version)
+		{
+			throw std::runtime_error("Invalid asset pack");
+		}
+
+		const auto path_table_offset = sizeof(header) + sizeof(pack_entry) * static_cast<size_t>(header.entry_count);
+		if (path_table_offset > data.size() || data.size() - path_table_offset < header.path_table_size)
+		{
+			throw std::runtime_error("Asset pack is truncated");
+		}
+
+		const auto path_table = data.substr(path_table_offset, header.path_table_size);
+
+		this->entries_.reserve(header.entry_count);
+
+		for (size_t i = 0; i < header.entry_count; ++i)
+		{
+			const auto stored_entry = read_struct<pack_entry>(data, sizeof(header) + sizeof(pack_entry) * i);
+
+			if (stored_entry.path_offset > path_table.size() ||
+				path_table.size() - stored_entry.path_offset < stored_entry.path_length ||
+				stored_entry.data_offset > data.size() ||
+				data.size() - stored_entry.data_offset < stored_entry.data_size ||
+				stored_entry.compression > static_cast<uint16_t>(compression_type::zstd))
+			{
+				throw std::runtime_error("Asset pack entry is corrupt");
+			}
+
+			entry entry{};
+			entry.path = path_table.substr(stored_entry.path_offset, stored_entry.path_length);
+			entry.data = data.substr(static_cast<size_t>(stored_entry.data_offset),
+			                         static_cast<size_t>(stored_entry.data_size));
+			entry.size = static_cast<size_t>(stored_entry.size);
+			entry.compression = static_cast<compression_type>(stored_entry.compression);
+
+			if (!this->entries_.empty() && this->entries_.back().path >= entry.path)
+			{
+				throw std::runtime_error("Asset pack entries are not sorted");
+			}
+
+			this->entries_.push_back(entry);
+		}
+	}
+}
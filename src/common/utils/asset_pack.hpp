@@ -0,0 +1,55 @@
+#pragma once
+
+#include "mapped_file.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace utils
+{
+	// Single file archive of a folder. The file consists of a header, a table of entries sorted by path,
+	// the path strings and the entry data, each entry starting at a 64 byte boundary.
+	// Entries are either stored or compressed with zstd
+	class asset_pack
+	{
+	public:
+		enum class compression_type : uint16_t
+		{
+			none = 0,
+			zstd = 1,
+		};
+
+		struct entry
+		{
+			std::string_view path{};
+			std::string_view data{};
+			size_t size{};
+			compression_type compression{};
+		};
+
+		explicit asset_pack(const std::filesystem::path& file);
+		explicit asset_pack(std::string data);
+
+		asset_pack(asset_pack&&) = delete;
+		asset_pack(const asset_pack&) = delete;
+		asset_pack& operator=(asset_pack&&) = delete;
+		asset_pack& operator=(const asset_pack&) = delete;
+
+		std::optional<entry> find(const std::string& path) const;
+		const std::vector<entry>& get_entries() const;
+
+		// Returns the uncompressed data of the entry
+		std::string read(const entry& entry) const;
+
+		static std::string build(const std::filesystem::path& folder, bool compress = false);
+
+	private:
+		std::unique_ptr<mapped_file> file_{};
+		std::string data_{};
+		std::vector<entry> entries_{};
+
+		void parse(std::string_view data);
+	};
+}
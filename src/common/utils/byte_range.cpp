@@ -0,0 +1,113 @@
+#include "byte_range.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+namespace utils
+{
+	namespace
+	{
+		std::string_view trim(std::string_view text)
+		{
+			while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+			{
+				text.remove_prefix(1);
+			}
+
+			while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+			{
+				text.remove_suffix(1);
+			}
+
+			return text;
+		}
+
+		bool parse_number(const std::string_view text, uint64_t& value)
+		{
+			if (text.empty())
+			{
+				return false;
+			}
+
+			const auto* end = text.data() + text.size();
+			const auto result = std::from_chars(text.data(), end, value);
+			return result.ec == std::errc{} && result.ptr == end;
+		}
+	}
+
+	range_status parse_range(std::string_view header, const uint64_t size, byte_range& range)
+	{
+		constexpr std::string_view unit = "bytes=";
+
+		header = trim(header);
+		if (header.size() < unit.size() || header.substr(0, unit.size()) != unit)
+		{
+			return range_status::none;
+		}
+
+		const auto spec = trim(header.substr(unit.size()));
+		const auto separator = spec.find('-');
+		if (spec.find(',') != std::string_view::npos || separator == std::string_view::npos)
+		{
+			return range_status::none;
+		}
+
+		const auto first = trim(spec.substr(0, separator));
+		const auto last = trim(spec.substr(separator + 1));
+
+		uint64_t first_byte{};
+		uint64_t last_byte{};
+
+		// Suffix range, the final bytes of the resource
+		if (first.empty())
+		{
+			if (!parse_number(last, last_byte))
+			{
+				return range_status::none;
+			}
+
+			if (!last_byte || !size)
+			{
+				return range_status::unsatisfiable;
+			}
+
+			range.length = std::min(last_byte, size);
+			range.offset = size - range.length;
+			return range_status::satisfiable;
+		}
+
+		if (!parse_number(first, first_byte))
+		{
+			return range_status::none;
+		}
+
+		if (last.empty())
+		{
+			last_byte = size ? size - 1 : 0;
+		}
+		else if (!parse_number(last, last_byte) || last_byte < first_byte)
+		{
+			return range_status::none;
+		}
+
+		if (first_byte >= size)
+		{
+			return range_status::unsatisfiable;
+		}
+
+		range.offset = first_byte;
+		range.length = std::min(last_byte, size - 1) - first_byte + 1;
+		return range_status::satisfiable;
+	}
+
+	std::string get_content_range(const byte_range& range, const uint64_t size)
+	{
+		if (!range.length)
+		{
+			return "bytes */" + std::to_string(size);
+		}
+
+		return "bytes " + std::to_string(range.offset) + "-" + std::to_string(range.offset + range.length - 1) + "/" +
+			std::to_string(size);
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace utils
+{
+	struct byte_range
+	{
+		uint64_t offset{};
+		uint64_t length{};
+	};
+
+	enum class range_status
+	{
+		none,
+		satisfiable,
+		unsatisfiable,
+	};
+
+	// Parses the Range header of a request for a resource of the given size.
+	// Malformed headers and requests for multiple ranges are treated like no header at all
+	range_status parse_range(std::string_view header, uint64_t size, byte_range& range);
+
+	// Content-Range header value, an empty range produces the value used for unsatisfiable requests
+	std::string get_content_range(const byte_range& range, uint64_t size);
+}
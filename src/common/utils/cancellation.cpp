@@ -0,0 +1,178 @@
+#include "cancellation.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace utils::concurrency
+{
+	namespace detail
+	{
+		struct cancellation_state
+		{
+			std::atomic_bool cancelled{false};
+
+			std::mutex mutex{};
+			std::condition_variable condition_variable{};
+			std::map<uint64_t, std::function<void()>> callbacks{};
+			uint64_t next_id{1};
+
+			std::thread::id cancelling_thread{};
+			uint64_t running_id{};
+
+			void cancel()
+			{
+				if (this->cancelled.exchange(true))
+				{
+					return;
+				}
+
+				std::unique_lock<std::mutex> lock{this->mutex};
+				this->cancelling_thread = std::this_thread::get_id();
+
+				while (!this->callbacks.empty())
+				{
+					auto entry = this->callbacks.extract(this->callbacks.begin());
+					this->running_id = entry.key();
+
+					lock.unlock();
+					entry.mapped()();
+					lock.lock();
+
+					this->running_id = 0;
+					this->condition_variable.notify_all();
+				}
+			}
+
+			uint64_t add(std::function<void()>& callback)
+			{
+				{
+					std::lock_guard<std::mutex> _{this->mutex};
+					if (!this->cancelled)
+					{
+						const auto id = this->next_id++;
+						this->callbacks.emplace(id, std::move(callback));
+						return id;
+					}
+				}
+
+				callback();
+				return 0;
+			}
+
+			void remove(const uint64_t id)
+			{
+				std::unique_lock<std::mutex> lock{this->mutex};
+				if (this->callbacks.erase(id))
+				{
+					return;
+				}
+
+				// A callback unregistering itself must not wait for its own return
+				if (this->cancelling_thread == std::this_thread::get_id())
+				{
+					return;
+				}
+
+				this->condition_variable.wait(lock, [this, id]()
+				{
+					return this->running_id != id;
+				});
+			}
+		};
+	}
+
+	cancellation_registration::cancellation_registration(std::shared_ptr<detail::cancellation_state> state,
+	                                                     const uint64_t id)
+		: state_(std::move(state))
+		  , id_(id)
+	{
+	}
+
+	cancellation_registration::~cancellation_registration()
+	{
+		this->reset();
+	}
+
+	cancellation_registration::cancellation_registration(cancellation_registration&& obj) noexcept
+	{
+		this->operator=(std::move(obj));
+	}
+
+	cancellation_registration& cancellation_registration::operator=(cancellation_registration&& obj) noexcept
+	{
+		if (this != &obj)
+		{
+			this->reset();
+			this->state_ = std::move(obj.state_);
+			this->id_ = obj.id_;
+			obj.id_ = 0;
+		}
+
+		return *this;
+	}
+
+	void cancellation_registration::reset()
+	{
+		if (this->state_ && this->id_)
+		{
+			this->state_->remove(this->id_);
+		}
+
+		this->state_ = {};
+		this->id_ = 0;
+	}
+
+	cancellation_token::cancellation_token(std::shared_ptr<detail::cancellation_state> state)
+		: state_(std::move(state))
+	{
+	}
+
+	bool cancellation_token::is_cancelled() const
+	{
+		return this->state_ && this->state_->cancelled.load(std::memory_order_acquire);
+	}
+
+	bool cancellation_token::can_be_cancelled() const
+	{
+		return static_cast<bool>(this->state_);
+	}
+
+	cancellation_registration cancellation_token::register_callback(std::function<void()> callback) const
+	{
+		if (!this->state_)
+		{
+			return {};
+		}
+
+		const auto id = this->state_->add(callback);
+		if (!id)
+		{
+			return {};
+		}
+
+		return {this->state_, id};
+	}
+
+	cancellation_source::cancellation_source()
+		: state_(std::make_shared<detail::cancellation_state>())
+	{
+	}
+
+	cancellation_token cancellation_source::get_token() const
+	{
+		return cancellation_token{this->state_};
+	}
+
+	void cancellation_source::cancel() const
+	{
+		this->state_->cancel();
+	}
+
+	bool cancellation_source::is_cancelled() const
+	{
+		return this->state_->cancelled.load(std::memory_order_acquire);
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace utils::concurrency
+{
+	namespace detail
+	{
+		struct cancellation_state;
+	}
+
+	// Unregisters its callback when destroyed. If the callback is running on another thread at that point,
+	// destruction waits for it to return
+	class cancellation_registration
+	{
+	public:
+		cancellation_registration() = default;
+		~cancellation_registration();
+
+		cancellation_registration(cancellation_registration&& obj) noexcept;
+		cancellation_registration& operator=(cancellation_registration&& obj) noexcept;
+
+		cancellation_registration(const cancellation_registration&) = delete;
+		cancellation_registration& operator=(const cancellation_registration&) = delete;
+
+		void reset();
+
+	private:
+		friend class cancellation_token;
+
+		cancellation_registration(std::shared_ptr<detail::cancellation_state> state, uint64_t id);
+
+		std::shared_ptr<detail::cancellation_state> state_{};
+		uint64_t id_{};
+	};
+
+	// A default constructed token is never cancelled
+	class cancellation_token
+	{
+	public:
+		cancellation_token() = default;
+
+		bool is_cancelled() const;
+		bool can_be_cancelled() const;
+
+		// Runs the callback on the cancelling thread, or right away if the token is already cancelled
+		[[nodiscard]] cancellation_registration register_callback(std::function<void()> callback) const;
+
+	private:
+		friend class cancellation_source;
+
+		explicit cancellation_token(std::shared_ptr<detail::cancellation_state> state);
+
+		std::shared_ptr<detail::cancellation_state> state_{};
+	};
+
+	class cancellation_source
+	{
+	public:
+		cancellation_source();
+
+		cancellation_token get_token() const;
+
+		// Only the first call runs the callbacks
+		void cancel() const;
+		bool is_cancelled() const;
+
+	private:
+		std::shared_ptr<detail::cancellation_state> state_{};
+	};
+}
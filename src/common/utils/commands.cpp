@@ -0,0 +1,132 @@
+#include "commands.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+
+#include <rapidjson/writer.h>
+
+#define CEF_COMMAND "command"
+#define CEF_DATA "data"
+
+namespace utils::commands
+{
+	namespace
+	{
+		// Requests and responses of typical commands fit into this arena without touching the heap
+		constexpr size_t arena_size = 16 * 1024;
+		constexpr size_t parse_stack_size = 1024;
+
+		metrics::counter failed_commands{"command.failures"};
+		metrics::histogram command_time{"command.latency_us"};
+		metrics::histogram queue_time{"command.queued_us"};
+
+		// Lets the writer serialize straight into the response buffer
+		struct string_output_stream
+		{
+			using Ch = char;
+
+			std::string& target;
+
+			void Put(const char c) const
+			{
+				target.push_back(c);
+			}
+
+			void Flush() const
+			{
+			}
+		};
+
+		void run_command(const handlers& handlers, const rapidjson::Value& request, rapidjson::Document& response,
+		                 const std::chrono::steady_clock::time_point start_time)
+		{
+			response.SetObject();
+
+			if (!request.IsObject())
+			{
+				return;
+			}
+
+			const auto command = request.FindMember(CEF_COMMAND);
+			const auto data = request.FindMember(CEF_DATA);
+
+			if (command == request.MemberEnd() || !command->value.IsString())
+			{
+				return;
+			}
+
+			const std::string_view command_name{command->value.GetString(), command->value.GetStringLength()};
+
+			const auto handler = handlers.find(command_name);
+			if (handler == handlers.end())
+			{
+				return;
+			}
+
+			const rapidjson::Value null_value{};
+			const auto& value = data != request.MemberEnd() ? data->value : null_value;
+
+			const auto run_time = std::chrono::steady_clock::now();
+
+			try
+			{
+				handler->second(value, response);
+			}
+			catch (const std::exception& e)
+			{
+				logger::error("Command {} failed: {}", command_name, e.what());
+				failed_commands.increment();
+			}
+
+			const auto end_time = std::chrono::steady_clock::now();
+
+			command_time.record(static_cast<uint64_t>(
+				std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count()));
+			queue_time.record(static_cast<uint64_t>(
+				std::chrono::duration_cast<std::chrono::microseconds>(run_time - start_time).count()));
+
+			const auto total = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+			const auto queued = std::chrono::duration_cast<std::chrono::milliseconds>(run_time - start_time);
+
+			logger::log_deferred<logger::level::debug, "Command {} took {} ms ({} ms queued)">(
+				command_name, total.count(), queued.count());
+		}
+	}
+
+	void execute(const handlers& handlers, std::string& json, const bool batch, std::string& response,
+	             const std::chrono::steady_clock::time_point start_time)
+	{
+		char arena[arena_size];
+		rapidjson::MemoryPoolAllocator<> allocator{arena, sizeof(arena)};
+
+		// Strings of the parsed request point into the json buffer instead of being copied
+		rapidjson::Document doc{&allocator, parse_stack_size};
+		doc.ParseInsitu(json.data());
+
+		response.reserve(response.size() + json.size());
+
+		string_output_stream stream{response};
+		rapidjson::Writer<string_output_stream, rapidjson::Document::EncodingType, rapidjson::ASCII<>> writer(stream);
+
+		if (!batch)
+		{
+			rapidjson::Document command_response{&allocator};
+			run_command(handlers, doc, command_response, start_time);
+			command_response.Accept(writer);
+			return;
+		}
+
+		writer.StartArray();
+
+		if (doc.IsArray())
+		{
+			for (const auto& request : doc.GetArray())
+			{
+				rapidjson::Document command_response{&allocator};
+				run_command(handlers, request, command_response, start_time);
+				command_response.Accept(writer);
+			}
+		}
+
+		writer.EndArray();
+	}
+}
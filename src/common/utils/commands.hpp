@@ -0,0 +1,21 @@
+#pragma once
+
+#include "string.hpp"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include <rapidjson/document.h>
+
+namespace utils::commands
+{
+	using handler = std::function<void(const rapidjson::Value& request, rapidjson::Document& response)>;
+	using handlers = std::unordered_map<std::string, handler, string::transparent_hash, std::equal_to<>>;
+
+	// Parses the request in place, which overwrites json, and appends the serialized response.
+	// Batches are arrays of commands that are answered with an array of their responses in the same order
+	void execute(const handlers& handlers, std::string& json, bool batch, std::string& response,
+	             std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now());
+}
@@ -1,68 +1,1485 @@
 #include "compression.hpp"
-#include "string.hpp"
+#include "cryptography.hpp"
+#include "io.hpp"
+#include "scheduler.hpp"
 
-#include <ShlObj.h>
-#include <atlbase.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#define ZSTD_STATIC_LINKING_ONLY
+#include <zdict.h>
+#include <zstd.h>
+
+#define LZ4F_STATIC_LINKING_ONLY
+#include <lz4frame.h>
 
-// CoInitialize is called already in com.cpp
 namespace utils::compression
 {
-	void decompress(const std::filesystem::path& file, const std::filesystem::path& into)
+	namespace
 	{
-		HRESULT hr{};
+		// Frames declare their own size, so neither that nor the actual output can be trusted with an allocation
+		void check_output_size(const char* codec, const uint64_t size, const size_t max_size)
+		{
+			if (size > max_size)
+			{
+				throw std::runtime_error(std::string(codec) + ": Output exceeds " + std::to_string(max_size) + " bytes");
+			}
+		}
+
+		data_callback append_bounded(std::string& result, const char* codec, const size_t max_size)
+		{
+			return [&result, codec, max_size](const char* data, const size_t length)
+			{
+				check_output_size(codec, result.size() + length, max_size);
+				result.append(data, length);
+			};
+		}
+
+		class bit_reader
+		{
+		public:
+			bit_reader(const uint8_t* data, const size_t size)
+				: data_(data)
+				  , size_(size)
+			{
+			}
+
+			uint32_t peek(const uint32_t count)
+			{
+				if (this->count_ < count)
+				{
+					this->refill();
+				}
+
+				return static_cast<uint32_t>(this->buffer_ & ((1ull << count) - 1));
+			}
+
+			void consume(const uint32_t count)
+			{
+				this->buffer_ >>= count;
+				this->count_ -= count;
+			}
+
+			uint32_t read(const uint32_t count)
+			{
+				if (count == 0)
+				{
+					return 0;
+				}
+
+				const auto value = this->peek(count);
+				this->consume(count);
+				return value;
+			}
+
+			// Drops the remaining bits of the current byte and hands back whole bytes
+			// that were already pulled into the bit buffer, so raw data can follow
+			void align_to_byte()
+			{
+				if (this->is_overrun())
+				{
+					throw std::runtime_error("Unexpected end of deflate stream");
+				}
+
+				this->consume(this->count_ % 8);
+				this->position_ -= (this->count_ - this->padding_) / 8;
+
+				this->buffer_ = 0;
+				this->count_ = 0;
+				this->padding_ = 0;
+			}
+
+			uint16_t read_raw_u16()
+			{
+				uint8_t bytes[2]{};
+				this->copy_raw(bytes, sizeof(bytes));
+				return static_cast<uint16_t>(bytes[0] | bytes[1] << 8);
+			}
+
+			void copy_raw(uint8_t* out, const size_t length)
+			{
+				if (length > this->size_ - this->position_)
+				{
+					throw std::runtime_error("Unexpected end of deflate stream");
+				}
+
+				std::memcpy(out, this->data_ + this->position_, length);
+				this->position_ += length;
+			}
+
+			bool is_overrun() const
+			{
+				return this->padding_ > this->count_;
+			}
+
+		private:
+			const uint8_t* data_{};
+			size_t size_{};
+			size_t position_{};
+
+			uint64_t buffer_{};
+			uint32_t count_{};
+			uint32_t padding_{};
+
+			void refill()
+			{
+				if (this->size_ - this->position_ >= sizeof(uint64_t))
+				{
+					uint64_t value{};
+					std::memcpy(&value, this->data_ + this->position_, sizeof(value));
+
+					this->buffer_ |= value << this->count_;
+					this->position_ += (63 - this->count_) >> 3;
+					this->count_ |= 56;
+					return;
+				}
+
+				// Past the end of the input the buffer is padded with zeroes,
+				// reading any of them is detected through is_overrun
+				while (this->count_ <= 56)
+				{
+					uint64_t value = 0;
+					if (this->position_ < this->size_)
+					{
+						value = this->data_[this->position_++];
+					}
+					else
+					{
+						this->padding_ += 8;
+					}
+
+					this->buffer_ |= value << this->count_;
+					this->count_ += 8;
+				}
+			}
+		};
+
+		class huffman_table
+		{
+		public:
+			static constexpr uint32_t max_bits = 15;
+			static constexpr uint32_t fast_bits = 10;
+			static constexpr uint32_t max_symbols = 288;
+
+			void build(const uint8_t* lengths, const size_t count)
+			{
+				this->counts_.fill(0);
+				for (size_t i = 0; i < count; ++i)
+				{
+					++this->counts_[lengths[i]];
+				}
+
+				this->counts_[0] = 0;
+
+				auto left = 1;
+				for (auto length = 1u; length <= max_bits; ++length)
+				{
+					left <<= 1;
+					left -= this->counts_[length];
+					if (left < 0)
+					{
+						throw std::runtime_error("Over-subscribed huffman code");
+					}
+				}
+
+				std::array<uint16_t, max_bits + 1> offsets{};
+				for (auto length = 1u; length < max_bits; ++length)
+				{
+					offsets[length + 1] = static_cast<uint16_t>(offsets[length] + this->counts_[length]);
+				}
+
+				for (size_t symbol = 0; symbol < count; ++symbol)
+				{
+					if (lengths[symbol])
+					{
+						this->symbols_[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+					}
+				}
+
+				this->fast_.fill(0);
+
+				uint32_t code = 0;
+				uint32_t index = 0;
+				for (auto length = 1u; length <= fast_bits; ++length)
+				{
+					for (auto i = 0u; i < this->counts_[length]; ++i, ++code)
+					{
+						const auto symbol = this->symbols_[index++];
+						const auto entry = static_cast<uint16_t>(symbol << 4 | length);
+
+						// Codes are stored MSB first, but the stream is read LSB first
+						uint32_t reversed = 0;
+						for (auto bit = 0u; bit < length; ++bit)
+						{
+							reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+						}
+
+						for (auto slot = reversed; slot < this->fast_.size(); slot += 1u << length)
+						{
+							this->fast_[slot] = entry;
+						}
+					}
+
+					code <<= 1;
+				}
+			}
+
+			uint32_t decode(bit_reader& reader) const
+			{
+				const auto bits = reader.peek(max_bits);
+
+				const auto entry = this->fast_[bits & (this->fast_.size() - 1)];
+				if (entry)
+				{
+					reader.consume(entry & 0xF);
+					return entry >> 4;
+				}
+
+				int code = 0;
+				int first = 0;
+				int index = 0;
+
+				for (auto length = 1u; length <= max_bits; ++length)
+				{
+					code |= (bits >> (length - 1)) & 1;
+
+					const int count = this->counts_[length];
+					if (code - count < first)
+					{
+						reader.consume(length);
+						return this->symbols_[index + (code - first)];
+					}
+
+					index += count;
+					first += count;
+					first <<= 1;
+					code <<= 1;
+				}
+
+				throw std::runtime_error("Invalid huffman code");
+			}
+
+		private:
+			std::array<uint16_t, max_bits + 1> counts_{};
+			std::array<uint16_t, max_symbols> symbols_{};
+			std::array<uint16_t, 1u << fast_bits> fast_{};
+		};
+
+		constexpr std::array<uint16_t, 29> length_base = {
+			3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+			35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+		};
+
+		constexpr std::array<uint8_t, 29> length_extra = {
+			0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+			3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+		};
+
+		constexpr std::array<uint16_t, 30> distance_base = {
+			1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+			257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+		};
+
+		constexpr std::array<uint8_t, 30> distance_extra = {
+			0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+			7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+		};
+
+		constexpr std::array<uint8_t, 19> code_length_order = {
+			16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+		};
+
+		struct fixed_tables
+		{
+			huffman_table literals{};
+			huffman_table distances{};
+		};
+
+		const fixed_tables& get_fixed_tables()
+		{
+			static const auto tables = []
+			{
+				std::array<uint8_t, huffman_table::max_symbols> lengths{};
+				std::fill(lengths.begin(), lengths.begin() + 144, uint8_t(8));
+				std::fill(lengths.begin() + 144, lengths.begin() + 256, uint8_t(9));
+				std::fill(lengths.begin() + 256, lengths.begin() + 280, uint8_t(7));
+				std::fill(lengths.begin() + 280, lengths.end(), uint8_t(8));
+
+				fixed_tables result{};
+				result.literals.build(lengths.data(), lengths.size());
+
+				lengths.fill(5);
+				result.distances.build(lengths.data(), 30);
+
+				return result;
+			}();
+
+			return tables;
+		}
+
+		void read_dynamic_tables(bit_reader& reader, huffman_table& literals, huffman_table& distances)
+		{
+			const auto literal_count = reader.read(5) + 257;
+			const auto distance_count = reader.read(5) + 1;
+			const auto code_length_count = reader.read(4) + 4;
+
+			if (literal_count > 286 || distance_count > 30)
+			{
+				throw std::runtime_error("Invalid dynamic block header");
+			}
+
+			std::array<uint8_t, code_length_order.size()> code_lengths{};
+			for (auto i = 0u; i < code_length_count; ++i)
+			{
+				code_lengths[code_length_order[i]] = static_cast<uint8_t>(reader.read(3));
+			}
+
+			huffman_table code_length_table{};
+			code_length_table.build(code_lengths.data(), code_lengths.size());
+
+			std::array<uint8_t, 286 + 30> lengths{};
+			const auto total = literal_count + distance_count;
+
+			for (auto index = 0u; index < total;)
+			{
+				const auto symbol = code_length_table.decode(reader);
+				if (symbol < 16)
+				{
+					lengths[index++] = static_cast<uint8_t>(symbol);
+					continue;
+				}
+
+				uint8_t value = 0;
+				uint32_t repeat = 0;
+
+				if (symbol == 16)
+				{
+					if (index == 0)
+					{
+						throw std::runtime_error("Repeated code length without a previous length");
+					}
+
+					value = lengths[index - 1];
+					repeat = 3 + reader.read(2);
+				}
+				else if (symbol == 17)
+				{
+					repeat = 3 + reader.read(3);
+				}
+				else
+				{
+					repeat = 11 + reader.read(7);
+				}
+
+				if (index + repeat > total)
+				{
+					throw std::runtime_error("Too many code lengths");
+				}
+
+				std::fill_n(lengths.begin() + index, repeat, value);
+				index += repeat;
+			}
+
+			if (lengths[256] == 0)
+			{
+				throw std::runtime_error("Missing end of block code");
+			}
+
+			literals.build(lengths.data(), literal_count);
+			distances.build(lengths.data() + literal_count, distance_count);
+		}
+
+		void inflate_block(bit_reader& reader, const huffman_table& literals, const huffman_table& distances,
+		                   uint8_t* out, const size_t out_size, size_t& produced)
+		{
+			while (true)
+			{
+				const auto symbol = literals.decode(reader);
+				if (symbol < 256)
+				{
+					if (produced >= out_size)
+					{
+						throw std::runtime_error("Inflated data exceeds the expected size");
+					}
+
+					out[produced++] = static_cast<uint8_t>(symbol);
+					continue;
+				}
+
+				if (symbol == 256)
+				{
+					return;
+				}
+
+				const auto length_index = symbol - 257;
+				if (length_index >= length_base.size())
+				{
+					throw std::runtime_error("Invalid length symbol");
+				}
+
+				const size_t length = length_base[length_index] + reader.read(length_extra[length_index]);
+
+				const auto distance_index = distances.decode(reader);
+				if (distance_index >= distance_base.size())
+				{
+					throw std::runtime_error("Invalid distance symbol");
+				}
+
+				const size_t distance = distance_base[distance_index] + reader.read(distance_extra[distance_index]);
+
+				if (distance > produced)
+				{
+					throw std::runtime_error("Distance exceeds the inflated data");
+				}
+
+				if (length > out_size - produced)
+				{
+					throw std::runtime_error("Inflated data exceeds the expected size");
+				}
+
+				auto* target = out + produced;
+				const auto* source = target - distance;
+
+				if (distance >= length)
+				{
+					std::memcpy(target, source, length);
+				}
+				else
+				{
+					for (size_t i = 0; i < length; ++i)
+					{
+						target[i] = source[i];
+					}
+				}
 
-		CComPtr<IShellDispatch> shell_dispatch{};
-		if (FAILED(shell_dispatch.CoCreateInstance(CLSID_Shell)))
+				produced += length;
+			}
+		}
+
+		void inflate(const uint8_t* data, const size_t size, uint8_t* out, const size_t out_size)
 		{
-			throw std::runtime_error("Failed to create co instance");
+			bit_reader reader{data, size};
+			size_t produced = 0;
+
+			huffman_table literals{};
+			huffman_table distances{};
+
+			auto last_block = false;
+			while (!last_block)
+			{
+				last_block = reader.read(1) != 0;
+				const auto type = reader.read(2);
+
+				if (type == 0)
+				{
+					reader.align_to_byte();
+
+					const auto length = reader.read_raw_u16();
+					const auto inverse_length = reader.read_raw_u16();
+
+					if (length != static_cast<uint16_t>(~inverse_length))
+					{
+						throw std::runtime_error("Invalid stored block length");
+					}
+
+					if (length > out_size - produced)
+					{
+						throw std::runtime_error("Inflated data exceeds the expected size");
+					}
+
+					reader.copy_raw(out + produced, length);
+					produced += length;
+				}
+				else if (type == 1)
+				{
+					const auto& tables = get_fixed_tables();
+					inflate_block(reader, tables.literals, tables.distances, out, out_size, produced);
+				}
+				else if (type == 2)
+				{
+					read_dynamic_tables(reader, literals, distances);
+					inflate_block(reader, literals, distances, out, out_size, produced);
+				}
+				else
+				{
+					throw std::runtime_error("Invalid deflate block type");
+				}
+
+				if (reader.is_overrun())
+				{
+					throw std::runtime_error("Unexpected end of deflate stream");
+				}
+			}
+
+			if (produced != out_size)
+			{
+				throw std::runtime_error("Inflated data is smaller than expected");
+			}
 		}
+	}
+
+	namespace zip
+	{
+		namespace
+		{
+			constexpr uint32_t local_file_header_signature = 0x04034B50;
+			constexpr uint32_t central_directory_signature = 0x02014B50;
+			constexpr uint32_t end_of_central_directory_signature = 0x06054B50;
+
+			constexpr size_t local_file_header_size = 30;
+			constexpr size_t central_directory_header_size = 46;
+			constexpr size_t end_of_central_directory_size = 22;
+
+			constexpr uint16_t flag_encrypted = 1 << 0;
+			constexpr uint16_t flag_data_descriptor = 1 << 3;
+
+			constexpr uint16_t method_stored = 0;
+			constexpr uint16_t method_deflate = 8;
+
+			// A deflate match emits at most 258 bytes for at least 2 bits of input
+			constexpr size_t max_deflate_ratio = 1032;
+
+			struct file_entry
+			{
+				std::string name{};
+				uint16_t flags{};
+				uint16_t method{};
+				uint32_t crc{};
+				size_t compressed_size{};
+				size_t uncompressed_size{};
+				size_t local_header_offset{};
+			};
+
+			uint16_t read_u16(const std::string& data, const size_t offset)
+			{
+				if (offset > data.size() || data.size() - offset < 2)
+				{
+					throw std::runtime_error("Unexpected end of zip archive");
+				}
+
+				const auto* bytes = reinterpret_cast<const uint8_t*>(data.data() + offset);
+				return static_cast<uint16_t>(bytes[0] | bytes[1] << 8);
+			}
+
+			uint32_t read_u32(const std::string& data, const size_t offset)
+			{
+				return read_u16(data, offset) | static_cast<uint32_t>(read_u16(data, offset + 2)) << 16;
+			}
+
+			size_t find_end_of_central_directory(const std::string& archive)
+			{
+				if (archive.size() < end_of_central_directory_size)
+				{
+					throw std::runtime_error("Invalid zip archive: too small");
+				}
+
+				// The record is followed by a comment of at most 0xFFFF bytes
+				const auto last = archive.size() - end_of_central_directory_size;
+				const auto first = last > 0xFFFF ? last - 0xFFFF : 0;
+
+				for (auto offset = last + 1; offset-- > first;)
+				{
+					if (read_u32(archive, offset) == end_of_central_directory_signature)
+					{
+						return offset;
+					}
+				}
+
+				throw std::runtime_error("Invalid zip archive: end of central directory not found");
+			}
+
+			// The archive may be a tail of the full file starting at base_offset,
+			// entries that start before it are skipped
+			std::vector<file_entry> read_central_directory(const std::string& archive, const size_t base_offset = 0)
+			{
+				const auto end_of_directory = find_end_of_central_directory(archive);
+				const auto entry_count = read_u16(archive, end_of_directory + 10);
+				const auto directory_offset = read_u32(archive, end_of_directory + 16);
+
+				if (entry_count == 0xFFFF || directory_offset == 0xFFFFFFFF)
+				{
+					throw std::runtime_error("ZIP64 archives are not supported");
+				}
+
+				if (directory_offset < base_offset)
+				{
+					throw std::runtime_error("Invalid zip archive: corrupted end of central directory");
+				}
+
+				std::vector<file_entry> entries{};
+				entries.reserve(entry_count);
+
+				size_t offset = directory_offset - base_offset;
+				for (auto i = 0u; i < entry_count; ++i)
+				{
+					if (read_u32(archive, offset) != central_directory_signature)
+					{
+						throw std::runtime_error("Invalid zip archive: corrupted central directory");
+					}
+
+					const auto name_length = read_u16(archive, offset + 28);
+					const auto extra_length = read_u16(archive, offset + 30);
+					const auto comment_length = read_u16(archive, offset + 32);
+
+					const auto name_offset = offset + central_directory_header_size;
+					if (name_offset + name_length > archive.size())
+					{
+						throw std::runtime_error("Unexpected end of zip archive");
+					}
+
+					const auto local_header_offset = read_u32(archive, offset + 42);
+					if (local_header_offset < base_offset)
+					{
+						offset = name_offset + name_length + extra_length + comment_length;
+						continue;
+					}
+
+					file_entry entry{};
+					entry.flags = read_u16(archive, offset + 8);
+					entry.method = read_u16(archive, offset + 10);
+					entry.crc = read_u32(archive, offset + 16);
+					entry.compressed_size = read_u32(archive, offset + 20);
+					entry.uncompressed_size = read_u32(archive, offset + 24);
+					entry.local_header_offset = local_header_offset - base_offset;
+					entry.name.assign(archive.data() + name_offset, name_length);
+
+					entries.emplace_back(std::move(entry));
+
+					offset = name_offset + name_length + extra_length + comment_length;
+				}
+
+				return entries;
+			}
+
+			size_t get_data_offset(const std::string& archive, const file_entry& entry)
+			{
+				const auto offset = entry.local_header_offset;
+				if (read_u32(archive, offset) != local_file_header_signature)
+				{
+					throw std::runtime_error("Invalid zip archive: corrupted local header for " + entry.name);
+				}
+
+				const auto name_length = read_u16(archive, offset + 26);
+				const auto extra_length = read_u16(archive, offset + 28);
+				const auto data_offset = offset + local_file_header_size + name_length + extra_length;
+
+				if (data_offset > archive.size() || entry.compressed_size > archive.size() - data_offset)
+				{
+					throw std::runtime_error("Unexpected end of zip archive in " + entry.name);
+				}
+
+				return data_offset;
+			}
+
+			std::filesystem::path get_target_path(const std::string& name, const std::filesystem::path& into)
+			{
+				auto generic_name = name;
+				std::replace(generic_name.begin(), generic_name.end(), '\\', '/');
+
+				const auto path = std::filesystem::path(generic_name).lexically_normal();
+				if (generic_name.empty() || generic_name.find(':') != std::string::npos || path.has_root_path())
+				{
+					throw std::runtime_error("Refusing to extract zip entry with an absolute path: " + name);
+				}
 
-		CComVariant variant_dir{}, variant_file{}, variant_opt{};
+				for (const auto& part : path)
+				{
+					if (part == "..")
+					{
+						throw std::runtime_error("Refusing to extract zip entry outside of the target folder: " + name);
+					}
+				}
 
-		variant_dir.vt = VT_BSTR;
-		variant_dir.bstrVal = SysAllocString(into.wstring().data());
+				return into / path;
+			}
 
-		// Destination is our zip file
-		CComPtr<Folder> path_to_folder{};
-		hr = shell_dispatch->NameSpace(variant_dir, &path_to_folder);
-		if (FAILED(hr))
+			// data holds the compressed_size bytes following the local header
+			void extract_entry_data(const file_entry& entry, const uint8_t* data, const std::filesystem::path& into)
+			{
+				const auto target = get_target_path(entry.name, into);
+				if (entry.name.ends_with('/') || entry.name.ends_with('\\'))
+				{
+					std::filesystem::create_directories(target);
+					return;
+				}
+
+				if (entry.flags & flag_encrypted)
+				{
+					throw std::runtime_error("Encrypted zip entries are not supported: " + entry.name);
+				}
+
+				if (entry.method != method_stored && entry.method != method_deflate)
+				{
+					throw std::runtime_error(
+						"Unsupported compression method " + std::to_string(entry.method) + " for " + entry.name);
+				}
+
+				// The header's size is allocated upfront, so it may not exceed what the compressed data can expand to
+				if (entry.method == method_stored && entry.compressed_size != entry.uncompressed_size)
+				{
+					throw std::runtime_error("Invalid size for stored zip entry: " + entry.name);
+				}
+
+				if (entry.method == method_deflate && entry.uncompressed_size / max_deflate_ratio > entry.compressed_size)
+				{
+					throw std::runtime_error("Invalid size for deflated zip entry: " + entry.name);
+				}
+
+				std::string buffer{};
+				buffer.resize(entry.uncompressed_size);
+
+				auto* out = reinterpret_cast<uint8_t*>(buffer.data());
+
+				if (entry.method == method_stored)
+				{
+					std::memcpy(out, data, buffer.size());
+				}
+				else
+				{
+					try
+					{
+						inflate(data, entry.compressed_size, out, buffer.size());
+					}
+					catch (const std::exception& e)
+					{
+						throw std::runtime_error("Failed to inflate " + entry.name + ": " + e.what());
+					}
+				}
+
+				if (cryptography::crc32::compute(buffer) != entry.crc)
+				{
+					throw std::runtime_error("CRC mismatch for zip entry " + entry.name);
+				}
+
+				if (!io::write_file(target.string(), buffer))
+				{
+					throw std::runtime_error("Failed to write " + target.string());
+				}
+			}
+
+			void extract_entry(const std::string& archive, const file_entry& entry, const std::filesystem::path& into)
+			{
+				const auto* data = reinterpret_cast<const uint8_t*>(archive.data()) + get_data_offset(archive, entry);
+				extract_entry_data(entry, data, into);
+			}
+
+			void extract_entries(const std::string& archive, const std::vector<file_entry>& entries,
+			                     const std::filesystem::path& into)
+			{
+				// Validate every path before anything is written
+				for (const auto& entry : entries)
+				{
+					get_target_path(entry.name, into);
+				}
+
+				// Entries mostly wait for their writes, the CPU-bound pool would sit idle meanwhile
+				concurrency::parallel_for(concurrency::get_io_scheduler(), 0, entries.size(), [&](const size_t index)
+				{
+					extract_entry(archive, entries[index], into);
+				}, 1);
+			}
+		}
+
+		void extract(const std::string& archive, const std::filesystem::path& into)
 		{
-			throw std::runtime_error("Failed to name space");
+			extract_entries(archive, read_central_directory(archive), into);
 		}
 
-		variant_file.vt = VT_BSTR;
-		variant_file.bstrVal = SysAllocString(file.wstring().data());
+		stream_extractor::stream_extractor(std::filesystem::path into)
+			: into_(std::move(into))
+		{
+		}
 
-		CComPtr<Folder> path_of_origin{};
-		hr = shell_dispatch->NameSpace(variant_file, &path_of_origin);
-		if (FAILED(hr))
+		void stream_extractor::write(const char* data, const size_t length)
 		{
-			throw std::runtime_error("Failed to name space");
+			if (this->streaming_ && this->directory_reached_)
+			{
+				return;
+			}
+
+			this->buffer_.append(data, length);
+			if (!this->streaming_)
+			{
+				return;
+			}
+
+			while (this->extract_next_entry())
+			{
+			}
+
+			if (this->streaming_)
+			{
+				this->compact();
+			}
 		}
 
-		CComPtr<FolderItems> folder_items{};
-		hr = path_of_origin->Items(&folder_items);
-		if (FAILED(hr))
+		void stream_extractor::finish()
 		{
-			throw std::runtime_error("Failed to set folder items");
+			if (this->streaming_)
+			{
+				if (!this->directory_reached_)
+				{
+					throw std::runtime_error("Unexpected end of zip stream");
+				}
+
+				return;
+			}
+
+			// Entries from the first one that could not be streamed on are located through the central directory
+			extract_entries(this->buffer_, read_central_directory(this->buffer_, this->buffer_offset_), this->into_);
 		}
 
-		variant_opt.vt = VT_I4;
-#if _DEBUG
-		variant_opt.lVal = FOF_NOCONFIRMMKDIR | FOF_NOCONFIRMATION | FOF_SIMPLEPROGRESS;
-#else
-		variant_opt.lVal = FOF_NO_UI; // Windows vista and later only
-#endif
+		bool stream_extractor::extract_next_entry()
+		{
+			const auto offset = this->consumed_;
+			const auto available = this->buffer_.size() - offset;
+			if (available < sizeof(uint32_t))
+			{
+				return false;
+			}
+
+			const auto signature = read_u32(this->buffer_, offset);
+			if (signature == central_directory_signature || signature == end_of_central_directory_signature)
+			{
+				this->directory_reached_ = true;
+				return false;
+			}
+
+			if (signature != local_file_header_signature)
+			{
+				throw std::runtime_error("Invalid zip archive: unexpected record in stream");
+			}
+
+			if (available < local_file_header_size)
+			{
+				return false;
+			}
+
+			file_entry entry{};
+			entry.flags = read_u16(this->buffer_, offset + 6);
+			entry.method = read_u16(this->buffer_, offset + 8);
+			entry.crc = read_u32(this->buffer_, offset + 14);
+			entry.compressed_size = read_u32(this->buffer_, offset + 18);
+			entry.uncompressed_size = read_u32(this->buffer_, offset + 22);
+			entry.local_header_offset = this->buffer_offset_ + offset;
+
+			// Sizes are only known upfront without data descriptors and outside of ZIP64
+			if ((entry.flags & flag_data_descriptor) || entry.compressed_size == 0xFFFFFFFF ||
+				entry.uncompressed_size == 0xFFFFFFFF)
+			{
+				this->compact();
+				this->streaming_ = false;
+				return false;
+			}
+
+			const auto name_length = read_u16(this->buffer_, offset + 26);
+			const auto extra_length = read_u16(this->buffer_, offset + 28);
+			const auto header_size = local_file_header_size + name_length + extra_length;
+
+			if (available < header_size || available - header_size < entry.compressed_size)
+			{
+				return false;
+			}
+
+			entry.name.assign(this->buffer_.data() + offset + local_file_header_size, name_length);
+
+			const auto* data = reinterpret_cast<const uint8_t*>(this->buffer_.data()) + offset + header_size;
+			extract_entry_data(entry, data, this->into_);
+
+			this->consumed_ += header_size + entry.compressed_size;
+			return true;
+		}
 
-		// Creating a new Variant with pointer to FolderItems to be copied
-		CComVariant variant_to{};
-		variant_to.vt = VT_DISPATCH;
-		variant_to.pdispVal = folder_items;
+		void stream_extractor::compact()
+		{
+			this->buffer_.erase(0, this->consumed_);
+			this->buffer_offset_ += this->consumed_;
+			this->consumed_ = 0;
+		}
+	}
 
-		hr = path_to_folder->CopyHere(variant_to, variant_opt);
-		if (FAILED(hr))
+	namespace zstd
+	{
+		namespace
 		{
-			throw std::runtime_error("Failed to copy files");
+			constexpr size_t multithread_threshold = 8 * 1024 * 1024;
+
+			size_t check(const size_t result)
+			{
+				if (ZSTD_isError(result))
+				{
+					throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(result));
+				}
+
+				return result;
+			}
+
+			uint32_t get_worker_count(const size_t size)
+			{
+				if (size < multithread_threshold)
+				{
+					return 0;
+				}
+
+				return std::max(1u, std::thread::hardware_concurrency());
+			}
+
+			void set_workers(ZSTD_CCtx* context, const uint32_t workers)
+			{
+				if (workers)
+				{
+					// Fails when the library is built without multithreading, compression then stays single threaded
+					ZSTD_CCtx_setParameter(context, ZSTD_c_nbWorkers, static_cast<int>(workers));
+				}
+			}
+
+			std::string decompress_unknown_size(const std::string_view data, decompress_stream& stream,
+			                                    std::string& result)
+			{
+				stream.write(data.data(), data.size());
+				stream.finish();
+				return std::move(result);
+			}
 		}
+
+		dictionary::dictionary(std::string data, const int level)
+			: data_(std::move(data))
+		{
+			this->compress_dictionary_ = ZSTD_createCDict(this->data_.data(), this->data_.size(), level);
+			this->decompress_dictionary_ = ZSTD_createDDict(this->data_.data(), this->data_.size());
+
+			if (!this->compress_dictionary_ || !this->decompress_dictionary_)
+			{
+				ZSTD_freeCDict(static_cast<ZSTD_CDict*>(this->compress_dictionary_));
+				ZSTD_freeDDict(static_cast<ZSTD_DDict*>(this->decompress_dictionary_));
+				throw std::runtime_error("zstd: Failed to load dictionary");
+			}
+		}
+
+		dictionary::~dictionary()
+		{
+			ZSTD_freeCDict(static_cast<ZSTD_CDict*>(this->compress_dictionary_));
+			ZSTD_freeDDict(static_cast<ZSTD_DDict*>(this->decompress_dictionary_));
+		}
+
+		const std::string& dictionary::get_data() const
+		{
+			return this->data_;
+		}
+
+		std::string dictionary::train(const std::vector<std::string>& samples, const size_t capacity)
+		{
+			std::string buffer{};
+			std::vector<size_t> sizes{};
+			sizes.reserve(samples.size());
+
+			for (const auto& sample : samples)
+			{
+				buffer.append(sample);
+				sizes.push_back(sample.size());
+			}
+
+			std::string result{};
+			result.resize(capacity);
+
+			const auto size = ZDICT_trainFromBuffer(result.data(), result.size(), buffer.data(), sizes.data(),
+			                                        static_cast<unsigned>(sizes.size()));
+			if (ZDICT_isError(size))
+			{
+				throw std::runtime_error(std::string("zstd: ") + ZDICT_getErrorName(size));
+			}
+
+			result.resize(size);
+			return result;
+		}
+
+		std::string compress(const std::string_view data, const int level)
+		{
+			const std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+			if (!context)
+			{
+				throw std::bad_alloc();
+			}
+
+			check(ZSTD_CCtx_setParameter(context.get(), ZSTD_c_compressionLevel, level));
+			set_workers(context.get(), get_worker_count(data.size()));
+
+			std::string result{};
+			result.resize(ZSTD_compressBound(data.size()));
+
+			const auto size = check(ZSTD_compress2(context.get(), result.data(), result.size(), data.data(),
+			                                       data.size()));
+			result.resize(size);
+			return result;
+		}
+
+		std::string compress(const std::string_view data, const dictionary& dictionary)
+		{
+			const std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+			if (!context)
+			{
+				throw std::bad_alloc();
+			}
+
+			std::string result{};
+			result.resize(ZSTD_compressBound(data.size()));
+
+			const auto size = check(ZSTD_compress_usingCDict(context.get(), result.data(), result.size(), data.data(),
+			                                                 data.size(),
+			                                                 static_cast<const ZSTD_CDict*>(dictionary.
+				                                                 compress_dictionary_)));
+			result.resize(size);
+			return result;
+		}
+
+		std::string decompress(const std::string_view data, const size_t max_size)
+		{
+			const auto content_size = ZSTD_findDecompressedSize(data.data(), data.size());
+			if (content_size == ZSTD_CONTENTSIZE_ERROR)
+			{
+				throw std::runtime_error("zstd: Invalid frame");
+			}
+
+			std::string result{};
+
+			if (content_size == ZSTD_CONTENTSIZE_UNKNOWN)
+			{
+				decompress_stream stream(append_bounded(result, "zstd", max_size));
+				return decompress_unknown_size(data, stream, result);
+			}
+
+			check_output_size("zstd", content_size, max_size);
+			result.resize(static_cast<size_t>(content_size));
+
+			const auto size = check(ZSTD_decompress(result.data(), result.size(), data.data(), data.size()));
+			result.resize(size);
+			return result;
+		}
+
+		std::string decompress(const std::string_view data, const dictionary& dictionary, const size_t max_size)
+		{
+			const auto content_size = ZSTD_findDecompressedSize(data.data(), data.size());
+			if (content_size == ZSTD_CONTENTSIZE_ERROR)
+			{
+				throw std::runtime_error("zstd: Invalid frame");
+			}
+
+			std::string result{};
+
+			if (content_size == ZSTD_CONTENTSIZE_UNKNOWN)
+			{
+				decompress_stream stream(append_bounded(result, "zstd", max_size), dictionary);
+				return decompress_unknown_size(data, stream, result);
+			}
+
+			check_output_size("zstd", content_size, max_size);
+
+			const std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(ZSTD_createDCtx(), ZSTD_freeDCtx);
+			if (!context)
+			{
+				throw std::bad_alloc();
+			}
+
+			result.resize(static_cast<size_t>(content_size));
+
+			const auto size = check(ZSTD_decompress_usingDDict(context.get(), result.data(), result.size(), data.data(),
+			                                                   data.size(),
+			                                                   static_cast<const ZSTD_DDict*>(dictionary.
+				                                                   decompress_dictionary_)));
+			result.resize(size);
+			return result;
+		}
+
+		compress_stream::compress_stream(data_callback callback, const int level, const uint32_t workers)
+			: callback_(std::move(callback))
+		{
+			std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+			if (!context)
+			{
+				throw std::bad_alloc();
+			}
+
+			this->buffer_.resize(ZSTD_CStreamOutSize());
+
+			check(ZSTD_CCtx_setParameter(context.get(), ZSTD_c_compressionLevel, level));
+			set_workers(context.get(), workers);
+
+			// The destructor does not run if the constructor throws, so ownership moves only once nothing can fail
+			this->context_ = context.release();
+		}
+
+		compress_stream::compress_stream(data_callback callback, const dictionary& dictionary)
+			: compress_stream(std::move(callback))
+		{
+			check(ZSTD_CCtx_refCDict(static_cast<ZSTD_CCtx*>(this->context_),
+			                         static_cast<const ZSTD_CDict*>(dictionary.compress_dictionary_)));
+		}
+
+		compress_stream::~compress_stream()
+		{
+			ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(this->context_));
+		}
+
+		void compress_stream::write(const char* data, const size_t length)
+		{
+			this->process(data, length, false);
+		}
+
+		void compress_stream::finish()
+		{
+			this->process(nullptr, 0, true);
+		}
+
+		void compress_stream::process(const char* data, const size_t length, const bool end)
+		{
+			auto* context = static_cast<ZSTD_CCtx*>(this->context_);
+			ZSTD_inBuffer input{data, length, 0};
+
+			while (true)
+			{
+				ZSTD_outBuffer output{this->buffer_.data(), this->buffer_.size(), 0};
+				const auto remaining = check(ZSTD_compressStream2(context, &output, &input,
+				                                                  end ? ZSTD_e_end : ZSTD_e_continue));
+
+				if (output.pos)
+				{
+					this->callback_(this->buffer_.data(), output.pos);
+				}
+
+				if (end ? remaining == 0 : input.pos == input.size)
+				{
+					break;
+				}
+			}
+		}
+
+		decompress_stream::decompress_stream(data_callback callback)
+			: callback_(std::move(callback))
+		{
+			std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(ZSTD_createDCtx(), ZSTD_freeDCtx);
+			if (!context)
+			{
+				throw std::bad_alloc();
+			}
+
+			this->buffer_.resize(ZSTD_DStreamOutSize());
+			this->context_ = context.release();
+		}
+
+		decompress_stream::decompress_stream(data_callback callback, const dictionary& dictionary)
+			: decompress_stream(std::move(callback))
+		{
+			check(ZSTD_DCtx_refDDict(static_cast<ZSTD_DCtx*>(this->context_),
+			                         static_cast<const ZSTD_DDict*>(dictionary.decompress_dictionary_)));
+		}
+
+		decompress_stream::~decompress_stream()
+		{
+			ZSTD_freeDCtx(static_cast<ZSTD_DCtx*>(this->context_));
+		}
+
+		void decompress_stream::write(const char* data, const size_t length)
+		{
+			auto* context = static_cast<ZSTD_DCtx*>(this->context_);
+			ZSTD_inBuffer input{data, length, 0};
+
+			// A filled output buffer may leave decoded data inside the context
+			auto flushing = false;
+			while (input.pos < input.size || flushing)
+			{
+				ZSTD_outBuffer output{this->buffer_.data(), this->buffer_.size(), 0};
+				const auto hint = check(ZSTD_decompressStream(context, &output, &input));
+
+				if (output.pos)
+				{
+					this->callback_(this->buffer_.data(), output.pos);
+				}
+
+				// Once the frame ended everything is flushed, another call would start reading the next frame
+				this->frame_complete_ = hint == 0;
+				flushing = !this->frame_complete_ && output.pos == output.size;
+			}
+		}
+
+		void decompress_stream::finish()
+		{
+			if (!this->frame_complete_)
+			{
+				throw std::runtime_error("zstd: Truncated frame");
+			}
+		}
+	}
+
+	namespace lz4
+	{
+		namespace
+		{
+			constexpr size_t chunk_size = 64 * 1024;
+
+			size_t check(const size_t result)
+			{
+				if (LZ4F_isError(result))
+				{
+					throw std::runtime_error(std::string("lz4: ") + LZ4F_getErrorName(result));
+				}
+
+				return result;
+			}
+
+			LZ4F_preferences_t get_preferences(const int level, const size_t content_size = 0)
+			{
+				LZ4F_preferences_t preferences{};
+				preferences.compressionLevel = level;
+				preferences.frameInfo.contentSize = content_size;
+				preferences.frameInfo.blockSizeID = LZ4F_max256KB;
+				return preferences;
+			}
+
+			std::string compress(const std::string_view data, const LZ4F_CDict* dictionary, const int level)
+			{
+				const auto preferences = get_preferences(level, data.size());
+
+				std::string result{};
+				result.resize(LZ4F_compressFrameBound(data.size(), &preferences));
+
+				if (!dictionary)
+				{
+					const auto size = check(LZ4F_compressFrame(result.data(), result.size(), data.data(), data.size(),
+					                                           &preferences));
+					result.resize(size);
+					return result;
+				}
+
+				LZ4F_cctx* context{};
+				check(LZ4F_createCompressionContext(&context, LZ4F_VERSION));
+				const std::unique_ptr<LZ4F_cctx, decltype(&LZ4F_freeCompressionContext)> context_guard(
+					context, LZ4F_freeCompressionContext);
+
+				const auto size = check(LZ4F_compressFrame_usingCDict(context, result.data(), result.size(),
+				                                                      data.data(), data.size(), dictionary,
+				                                                      &preferences));
+				result.resize(size);
+				return result;
+			}
+
+			std::string decompress(const std::string_view data, decompress_stream& stream, std::string& result,
+			                       const size_t max_size)
+			{
+				LZ4F_dctx* context{};
+				check(LZ4F_createDecompressionContext(&context, LZ4F_VERSION));
+				const std::unique_ptr<LZ4F_dctx, decltype(&LZ4F_freeDecompressionContext)> context_guard(
+					context, LZ4F_freeDecompressionContext);
+
+				LZ4F_frameInfo_t info{};
+				auto header_size = data.size();
+				check(LZ4F_getFrameInfo(context, &info, data.data(), &header_size));
+
+				if (info.contentSize)
+				{
+					check_output_size("lz4", info.contentSize, max_size);
+					result.reserve(static_cast<size_t>(info.contentSize));
+				}
+
+				stream.write(data.data(), data.size());
+				stream.finish();
+				return std::move(result);
+			}
+		}
+
+		dictionary::dictionary(std::string data)
+			: data_(std::move(data))
+		{
+			this->compress_dictionary_ = LZ4F_createCDict(this->data_.data(), this->data_.size());
+			if (!this->compress_dictionary_)
+			{
+				throw std::runtime_error("lz4: Failed to load dictionary");
+			}
+		}
+
+		dictionary::~dictionary()
+		{
+			LZ4F_freeCDict(static_cast<LZ4F_CDict*>(this->compress_dictionary_));
+		}
+
+		const std::string& dictionary::get_data() const
+		{
+			return this->data_;
+		}
+
+		std::string compress(const std::string_view data, const int level)
+		{
+			return compress(data, nullptr, level);
+		}
+
+		std::string compress(const std::string_view data, const dictionary& dictionary, const int level)
+		{
+			return compress(data, static_cast<const LZ4F_CDict*>(dictionary.compress_dictionary_), level);
+		}
+
+		std::string decompress(const std::string_view data, const size_t max_size)
+		{
+			std::string result{};
+			decompress_stream stream(append_bounded(result, "lz4", max_size));
+			return decompress(data, stream, result, max_size);
+		}
+
+		std::string decompress(const std::string_view data, const dictionary& dictionary, const size_t max_size)
+		{
+			std::string result{};
+			decompress_stream stream(append_bounded(result, "lz4", max_size), dictionary);
+			return decompress(data, stream, result, max_size);
+		}
+
+		compress_stream::compress_stream(data_callback callback, const int level)
+			: callback_(std::move(callback))
+		{
+			this->begin(nullptr, level);
+		}
+
+		compress_stream::compress_stream(data_callback callback, const dictionary& dictionary, const int level)
+			: callback_(std::move(callback))
+		{
+			this->begin(dictionary.compress_dictionary_, level);
+		}
+
+		compress_stream::~compress_stream()
+		{
+			LZ4F_freeCompressionContext(static_cast<LZ4F_cctx*>(this->context_));
+		}
+
+		void compress_stream::begin(const void* dictionary, const int level)
+		{
+			LZ4F_cctx* context{};
+			check(LZ4F_createCompressionContext(&context, LZ4F_VERSION));
+			std::unique_ptr<LZ4F_cctx, decltype(&LZ4F_freeCompressionContext)> context_guard(
+				context, LZ4F_freeCompressionContext);
+
+			const auto preferences = get_preferences(level);
+			this->buffer_.resize(std::max(size_t(LZ4F_HEADER_SIZE_MAX), LZ4F_compressBound(chunk_size, &preferences)));
+
+			const auto size = check(LZ4F_compressBegin_usingCDict(context, this->buffer_.data(), this->buffer_.size(),
+			                                                      static_cast<const LZ4F_CDict*>(dictionary),
+			                                                      &preferences));
+			this->callback_(this->buffer_.data(), size);
+
+			// Runs from the constructors, the destructor would not free the context if anything above threw
+			this->context_ = context_guard.release();
+		}
+
+		void compress_stream::write(const char* data, const size_t length)
+		{
+			if (this->finished_)
+			{
+				throw std::runtime_error("lz4: Stream already finished");
+			}
+
+			auto* context = static_cast<LZ4F_cctx*>(this->context_);
+
+			for (size_t offset = 0; offset < length; offset += chunk_size)
+			{
+				const auto size = check(LZ4F_compressUpdate(context, this->buffer_.data(), this->buffer_.size(),
+				                                            data + offset, std::min(chunk_size, length - offset),
+				                                            nullptr));
+				if (size)
+				{
+					this->callback_(this->buffer_.data(), size);
+				}
+			}
+		}
+
+		void compress_stream::finish()
+		{
+			if (this->finished_)
+			{
+				return;
+			}
+
+			this->finished_ = true;
+
+			const auto size = check(LZ4F_compressEnd(static_cast<LZ4F_cctx*>(this->context_), this->buffer_.data(),
+			                                         this->buffer_.size(), nullptr));
+			this->callback_(this->buffer_.data(), size);
+		}
+
+		decompress_stream::decompress_stream(data_callback callback)
+			: callback_(std::move(callback))
+		{
+			LZ4F_dctx* context{};
+			check(LZ4F_createDecompressionContext(&context, LZ4F_VERSION));
+			std::unique_ptr<LZ4F_dctx, decltype(&LZ4F_freeDecompressionContext)> context_guard(
+				context, LZ4F_freeDecompressionContext);
+
+			this->buffer_.resize(chunk_size);
+			this->context_ = context_guard.release();
+		}
+
+		decompress_stream::decompress_stream(data_callback callback, const dictionary& dictionary)
+			: decompress_stream(std::move(callback))
+		{
+			this->dictionary_ = &dictionary.get_data();
+		}
+
+		decompress_stream::~decompress_stream()
+		{
+			LZ4F_freeDecompressionContext(static_cast<LZ4F_dctx*>(this->context_));
+		}
+
+		void decompress_stream::write(const char* data, const size_t length)
+		{
+			auto* context = static_cast<LZ4F_dctx*>(this->context_);
+
+			size_t offset = 0;
+			while (true)
+			{
+				auto input_size = length - offset;
+				auto output_size = this->buffer_.size();
+
+				const auto hint = this->dictionary_
+					                  ? LZ4F_decompress_usingDict(context, this->buffer_.data(), &output_size,
+					                                              data + offset, &input_size,
+					                                              this->dictionary_->data(),
+					                                              this->dictionary_->size(), nullptr)
+					                  : LZ4F_decompress(context, this->buffer_.data(), &output_size, data + offset,
+					                                    &input_size, nullptr);
+				check(hint);
+
+				offset += input_size;
+				this->frame_complete_ = hint == 0;
+
+				if (output_size)
+				{
+					this->callback_(this->buffer_.data(), output_size);
+				}
+
+				// An ended frame is fully flushed, even if the last output filled the buffer
+				if (offset >= length && (this->frame_complete_ || output_size < this->buffer_.size()))
+				{
+					break;
+				}
+			}
+		}
+
+		void decompress_stream::finish()
+		{
+			if (!this->frame_complete_)
+			{
+				throw std::runtime_error("lz4: Truncated frame");
+			}
+		}
+	}
+
+	void decompress(const std::filesystem::path& file, const std::filesystem::path& into)
+	{
+		std::string archive{};
+		if (!io::read_file(file.string(), &archive))
+		{
+			throw std::runtime_error("Failed to read " + file.string());
+		}
+
+		zip::extract(archive, into);
 	}
 }
@@ -1,7 +1,209 @@
 #pragma once
 #include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace utils::compression
 {
+	using data_callback = std::function<void(const char* data, size_t length)>;
+
+	// One-shot decompression throws instead of producing more than max_size bytes
+	constexpr size_t default_max_size = 1024 * 1024 * 1024;
+
+	namespace zstd
+	{
+		constexpr int default_level = 3;
+
+		class dictionary
+		{
+		public:
+			explicit dictionary(std::string data, int level = default_level);
+			~dictionary();
+
+			dictionary(dictionary&&) = delete;
+			dictionary(const dictionary&) = delete;
+			dictionary& operator=(dictionary&&) = delete;
+			dictionary& operator=(const dictionary&) = delete;
+
+			const std::string& get_data() const;
+
+			static std::string train(const std::vector<std::string>& samples, size_t capacity = 110 * 1024);
+
+		private:
+			friend class compress_stream;
+			friend class decompress_stream;
+			friend std::string compress(std::string_view data, const dictionary& dictionary);
+			friend std::string decompress(std::string_view data, const dictionary& dictionary, size_t max_size);
+
+			std::string data_{};
+			void* compress_dictionary_{};
+			void* decompress_dictionary_{};
+		};
+
+		// Inputs of at least 8 MB are compressed on all hardware threads
+		std::string compress(std::string_view data, int level = default_level);
+		std::string compress(std::string_view data, const dictionary& dictionary);
+
+		std::string decompress(std::string_view data, size_t max_size = default_max_size);
+		std::string decompress(std::string_view data, const dictionary& dictionary, size_t max_size = default_max_size);
+
+		class compress_stream
+		{
+		public:
+			// A worker count of 0 compresses on the calling thread
+			explicit compress_stream(data_callback callback, int level = default_level, uint32_t workers = 0);
+			compress_stream(data_callback callback, const dictionary& dictionary);
+			~compress_stream();
+
+			compress_stream(compress_stream&&) = delete;
+			compress_stream(const compress_stream&) = delete;
+			compress_stream& operator=(compress_stream&&) = delete;
+			compress_stream& operator=(const compress_stream&) = delete;
+
+			void write(const char* data, size_t length);
+			void finish();
+
+		private:
+			data_callback callback_{};
+			void* context_{};
+			std::string buffer_{};
+
+			void process(const char* data, size_t length, bool end);
+		};
+
+		class decompress_stream
+		{
+		public:
+			explicit decompress_stream(data_callback callback);
+			decompress_stream(data_callback callback, const dictionary& dictionary);
+			~decompress_stream();
+
+			decompress_stream(decompress_stream&&) = delete;
+			decompress_stream(const decompress_stream&) = delete;
+			decompress_stream& operator=(decompress_stream&&) = delete;
+			decompress_stream& operator=(const decompress_stream&) = delete;
+
+			void write(const char* data, size_t length);
+			void finish();
+
+		private:
+			data_callback callback_{};
+			void* context_{};
+			std::string buffer_{};
+			bool frame_complete_{true};
+		};
+	}
+
+	namespace lz4
+	{
+		// Levels of 3 and above use the high compression encoder
+		constexpr int default_level = 0;
+
+		class dictionary
+		{
+		public:
+			explicit dictionary(std::string data);
+			~dictionary();
+
+			dictionary(dictionary&&) = delete;
+			dictionary(const dictionary&) = delete;
+			dictionary& operator=(dictionary&&) = delete;
+			dictionary& operator=(const dictionary&) = delete;
+
+			const std::string& get_data() const;
+
+		private:
+			friend class compress_stream;
+			friend std::string compress(std::string_view data, const dictionary& dictionary, int level);
+
+			std::string data_{};
+			void* compress_dictionary_{};
+		};
+
+		std::string compress(std::string_view data, int level = default_level);
+		std::string compress(std::string_view data, const dictionary& dictionary, int level = default_level);
+
+		std::string decompress(std::string_view data, size_t max_size = default_max_size);
+		std::string decompress(std::string_view data, const dictionary& dictionary, size_t max_size = default_max_size);
+
+		class compress_stream
+		{
+		public:
+			explicit compress_stream(data_callback callback, int level = default_level);
+			compress_stream(data_callback callback, const dictionary& dictionary, int level = default_level);
+			~compress_stream();
+
+			compress_stream(compress_stream&&) = delete;
+			compress_stream(const compress_stream&) = delete;
+			compress_stream& operator=(compress_stream&&) = delete;
+			compress_stream& operator=(const compress_stream&) = delete;
+
+			void write(const char* data, size_t length);
+			void finish();
+
+		private:
+			data_callback callback_{};
+			void* context_{};
+			std::string buffer_{};
+			bool finished_{false};
+
+			void begin(const void* dictionary, int level);
+		};
+
+		class decompress_stream
+		{
+		public:
+			explicit decompress_stream(data_callback callback);
+			decompress_stream(data_callback callback, const dictionary& dictionary);
+			~decompress_stream();
+
+			decompress_stream(decompress_stream&&) = delete;
+			decompress_stream(const decompress_stream&) = delete;
+			decompress_stream& operator=(decompress_stream&&) = delete;
+			decompress_stream& operator=(const decompress_stream&) = delete;
+
+			void write(const char* data, size_t length);
+			void finish();
+
+		private:
+			data_callback callback_{};
+			void* context_{};
+			const std::string* dictionary_{};
+			std::string buffer_{};
+			bool frame_complete_{true};
+		};
+	}
+
+	namespace zip
+	{
+		void extract(const std::string& archive, const std::filesystem::path& into);
+
+		// Extracts entries as soon as they are fully received. Archives using data descriptors
+		// are buffered from the first such entry on and extracted through the central directory in finish
+		class stream_extractor
+		{
+		public:
+			explicit stream_extractor(std::filesystem::path into);
+
+			void write(const char* data, size_t length);
+			void finish();
+
+		private:
+			std::filesystem::path into_{};
+
+			std::string buffer_{};
+			size_t buffer_offset_{};
+			size_t consumed_{};
+
+			bool streaming_{true};
+			bool directory_reached_{false};
+
+			bool extract_next_entry();
+			void compact();
+		};
+	}
+
 	void decompress(const std::filesystem::path& file, const std::filesystem::path& into);
 }
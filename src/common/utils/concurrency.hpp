@@ -1,9 +1,23 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <type_traits>
 
 namespace utils::concurrency
 {
+	template <typename MutexType>
+	concept shared_lockable = requires(MutexType& mutex)
+	{
+		mutex.lock_shared();
+		mutex.unlock_shared();
+	};
+
+	// Const access takes a shared lock if the mutex supports it, so readers do not exclude each other
 	template <typename T, typename MutexType = std::mutex>
 	class container
 	{
@@ -11,8 +25,16 @@ namespace utils::concurrency
 		template <typename R = void, typename F>
 		R access(F&& accessor) const
 		{
-			std::lock_guard<MutexType> _{mutex_};
-			return accessor(object_);
+			if constexpr (shared_lockable<MutexType>)
+			{
+				std::shared_lock<MutexType> _{mutex_};
+				return accessor(object_);
+			}
+			else
+			{
+				std::lock_guard<MutexType> _{mutex_};
+				return accessor(object_);
+			}
 		}
 
 		template <typename R = void, typename F>
@@ -43,4 +65,144 @@ namespace utils::concurrency
 		mutable MutexType mutex_{};
 		T object_{};
 	};
+
+	template <typename T>
+	using shared_container = container<T, std::shared_mutex>;
+
+	// For small trivially copyable values that are read far more often than written.
+	// Readers work on a copy and never block writers, they retry if a write happened while copying
+	template <typename T>
+	class seqlock_container
+	{
+	public:
+		static_assert(std::is_trivially_copyable_v<T>);
+
+		seqlock_container()
+		{
+			this->publish();
+		}
+
+		template <typename R = void, typename F>
+		R access(F&& accessor) const
+		{
+			const auto object = this->read();
+			return accessor(object);
+		}
+
+		template <typename R = void, typename F>
+		R access(F&& accessor)
+		{
+			std::lock_guard<std::mutex> _{this->mutex_};
+
+			if constexpr (std::is_void_v<R>)
+			{
+				accessor(this->object_);
+				this->publish();
+			}
+			else
+			{
+				R result = accessor(this->object_);
+				this->publish();
+				return result;
+			}
+		}
+
+	private:
+		static constexpr size_t word_count = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+		std::mutex mutex_{};
+		T object_{};
+
+		std::atomic<uint64_t> sequence_{0};
+		std::array<std::atomic<uint64_t>, word_count> words_{};
+
+		// Requires the mutex
+		void publish()
+		{
+			std::array<uint64_t, word_count> words{};
+			std::memcpy(words.data(), &this->object_, sizeof(T));
+
+			const auto sequence = this->sequence_.load(std::memory_order_relaxed);
+			this->sequence_.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			for (size_t i = 0; i < word_count; ++i)
+			{
+				this->words_[i].store(words[i], std::memory_order_relaxed);
+			}
+
+			this->sequence_.store(sequence + 2, std::memory_order_release);
+		}
+
+		T read() const
+		{
+			std::array<uint64_t, word_count> words{};
+
+			while (true)
+			{
+				const auto sequence = this->sequence_.load(std::memory_order_acquire);
+				if (sequence & 1)
+				{
+					continue;
+				}
+
+				for (size_t i = 0; i < word_count; ++i)
+				{
+					words[i] = this->words_[i].load(std::memory_order_relaxed);
+				}
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (this->sequence_.load(std::memory_order_relaxed) == sequence)
+				{
+					break;
+				}
+			}
+
+			T object{};
+			std::memcpy(static_cast<void*>(&object), words.data(), sizeof(T));
+			return object;
+		}
+	};
+
+	// Readers get the current immutable version and keep it alive for as long as they use it.
+	// Writers copy the value, modify the copy and publish it, so readers never wait for them
+	template <typename T>
+	class snapshot_container
+	{
+	public:
+		template <typename R = void, typename F>
+		R access(F&& accessor) const
+		{
+			const auto object = this->object_.load(std::memory_order_acquire);
+			return accessor(*object);
+		}
+
+		template <typename R = void, typename F>
+		R access(F&& accessor)
+		{
+			std::lock_guard<std::mutex> _{this->mutex_};
+			auto object = std::make_shared<T>(*this->object_.load(std::memory_order_relaxed));
+
+			if constexpr (std::is_void_v<R>)
+			{
+				accessor(*object);
+				this->object_.store(std::move(object), std::memory_order_release);
+			}
+			else
+			{
+				R result = accessor(*object);
+				this->object_.store(std::move(object), std::memory_order_release);
+				return result;
+			}
+		}
+
+		std::shared_ptr<const T> get_snapshot() const
+		{
+			return this->object_.load(std::memory_order_acquire);
+		}
+
+	private:
+		std::mutex mutex_{};
+		std::atomic<std::shared_ptr<const T>> object_{std::make_shared<const T>()};
+	};
 }
@@ -4,6 +4,8 @@
 
 #include "finally.hpp"
 
+#include <array>
+
 #include <bcrypt.h>
 #pragma comment(lib, "Bcrypt.lib")
 
@@ -81,6 +83,40 @@ namespace utils::cryptography
 
 			return string::dump_hex(hash_data, "");
 		}
+
+		using crc32_tables = std::array<std::array<uint32_t, 256>, 8>;
+
+		const crc32_tables& get_crc32_tables()
+		{
+			static const auto tables = []
+			{
+				crc32_tables result{};
+
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					auto crc = i;
+					for (auto j = 0; j < 8; ++j)
+					{
+						crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+					}
+
+					result[0][i] = crc;
+				}
+
+				for (size_t slice = 1; slice < result.size(); ++slice)
+				{
+					for (size_t i = 0; i < 256; ++i)
+					{
+						const auto previous = result[slice - 1][i];
+						result[slice][i] = (previous >> 8) ^ result[0][previous & 0xFF];
+					}
+				}
+
+				return result;
+			}();
+
+			return tables;
+		}
 	}
 
 	std::string sha1::compute(const std::string& data, const bool hex)
@@ -92,4 +128,37 @@ namespace utils::cryptography
 	{
 		return compute_hash(BCRYPT_SHA1_ALGORITHM, data, length, hex);
 	}
+
+	uint32_t crc32::compute(const std::string& data, const uint32_t crc)
+	{
+		return compute(reinterpret_cast<const uint8_t*>(data.data()), data.size(), crc);
+	}
+
+	uint32_t crc32::compute(const uint8_t* data, size_t length, const uint32_t crc)
+	{
+		const auto& tables = get_crc32_tables();
+		auto value = ~crc;
+
+		// Slicing-by-8, processes 8 bytes per iteration
+		while (length >= 8)
+		{
+			const auto low = value ^ (data[0] | data[1] << 8 | data[2] << 16 | static_cast<uint32_t>(data[3]) << 24);
+			const auto high = data[4] | data[5] << 8 | data[6] << 16 | static_cast<uint32_t>(data[7]) << 24;
+
+			value = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^
+				tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24] ^
+				tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^
+				tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+
+			data += 8;
+			length -= 8;
+		}
+
+		while (length-- > 0)
+		{
+			value = (value >> 8) ^ tables[0][(value ^ *data++) & 0xFF];
+		}
+
+		return ~value;
+	}
 }
@@ -9,4 +9,10 @@ namespace utils::cryptography
 		std::string compute(const std::string& data, bool hex = false);
 		std::string compute(const uint8_t* data, size_t length, bool hex = false);
 	}
+
+	namespace crc32
+	{
+		uint32_t compute(const std::string& data, uint32_t crc = 0);
+		uint32_t compute(const uint8_t* data, size_t length, uint32_t crc = 0);
+	}
 }
@@ -0,0 +1,136 @@
+#include "events.hpp"
+#include "concurrency.hpp"
+
+#include <rapidjson/writer.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace utils::events
+{
+	namespace
+	{
+		using subscriber_list = std::vector<std::weak_ptr<subscriber>>;
+
+		// Publishing happens far more often than subscribing, e.g. for every progress update,
+		// so publishers read the current list without taking a lock
+		concurrency::snapshot_container<subscriber_list>& get_subscribers()
+		{
+			static concurrency::snapshot_container<subscriber_list> subscribers{};
+			return subscribers;
+		}
+	}
+
+	subscriber::subscriber(notify_callback notify, const size_t capacity)
+		: notify_(std::move(notify))
+		  , capacity_(std::max(capacity, static_cast<size_t>(1)))
+	{
+	}
+
+	std::optional<event> subscriber::next()
+	{
+		std::lock_guard<std::mutex> _{this->mutex_};
+		if (this->queue_.empty())
+		{
+			return {};
+		}
+
+		auto& pending = this->queue_.front();
+		auto result = std::move(pending.value);
+
+		this->keys_.erase(pending.key);
+		this->queue_.pop_front();
+
+		return {std::move(result)};
+	}
+
+	size_t subscriber::get_dropped() const
+	{
+		std::lock_guard<std::mutex> _{this->mutex_};
+		return this->dropped_;
+	}
+
+	void subscriber::push(const std::string& key, const event& event)
+	{
+		{
+			std::lock_guard<std::mutex> _{this->mutex_};
+
+			const auto entry = this->keys_.find(key);
+			if (entry != this->keys_.end())
+			{
+				// The consumer has not seen the previous state yet, so it is enough to update it in place
+				entry->second->value = event;
+				return;
+			}
+
+			const auto was_empty = this->queue_.empty();
+
+			if (this->queue_.size() >= this->capacity_)
+			{
+				this->keys_.erase(this->queue_.front().key);
+				this->queue_.pop_front();
+				++this->dropped_;
+			}
+
+			this->queue_.emplace_back(pending_event{key, event});
+			this->keys_[key] = std::prev(this->queue_.end());
+
+			if (!was_empty)
+			{
+				return;
+			}
+		}
+
+		if (this->notify_)
+		{
+			this->notify_();
+		}
+	}
+
+	std::shared_ptr<subscriber> subscribe(subscriber::notify_callback notify, const size_t capacity)
+	{
+		auto result = std::make_shared<subscriber>(std::move(notify), capacity);
+
+		get_subscribers().access([&result](subscriber_list& subscribers)
+		{
+			// Publishers never modify the list, so subscribers that are gone are dropped here
+			std::erase_if(subscribers, [](const std::weak_ptr<subscriber>& entry)
+			{
+				return entry.expired();
+			});
+
+			subscribers.emplace_back(result);
+		});
+
+		return result;
+	}
+
+	void publish(const std::string& name, std::string data, const std::string& key)
+	{
+		const auto subscribers = get_subscribers().get_snapshot();
+
+		const event event{name, std::move(data)};
+		const auto& event_key = key.empty() ? name : key;
+
+		// Notifications work on the snapshot, so subscribers may publish or subscribe from them
+		for (const auto& entry : *subscribers)
+		{
+			const auto subscriber = entry.lock();
+			if (subscriber)
+			{
+				subscriber->push(event_key, event);
+			}
+		}
+	}
+
+	void publish(const std::string& name, const rapidjson::Value& data, const std::string& key)
+	{
+		rapidjson::StringBuffer buffer{};
+		rapidjson::Writer<rapidjson::StringBuffer, rapidjson::Document::EncodingType, rapidjson::ASCII<>>
+			writer(buffer);
+		data.Accept(writer);
+
+		publish(name, std::string{buffer.GetString(), buffer.GetLength()}, key);
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include <rapidjson/document.h>
+
+namespace utils::events
+{
+	struct event
+	{
+		std::string name{};
+		std::string data{};
+	};
+
+	// Events wait here until their consumer is ready for them. An event replaces a still pending event
+	// with the same key, and the oldest event is dropped once the capacity is reached, so consumers
+	// that fall behind only ever see the latest state instead of growing the queue
+	class subscriber
+	{
+	public:
+		using notify_callback = std::function<void()>;
+
+		subscriber(notify_callback notify, size_t capacity);
+
+		subscriber(subscriber&&) = delete;
+		subscriber(const subscriber&) = delete;
+		subscriber& operator=(subscriber&&) = delete;
+		subscriber& operator=(const subscriber&) = delete;
+
+		std::optional<event> next();
+		size_t get_dropped() const;
+
+		void push(const std::string& key, const event& event);
+
+	private:
+		struct pending_event
+		{
+			std::string key{};
+			event value{};
+		};
+
+		notify_callback notify_{};
+		size_t capacity_{};
+
+		mutable std::mutex mutex_{};
+		std::list<pending_event> queue_{};
+		std::unordered_map<std::string, std::list<pending_event>::iterator> keys_{};
+		size_t dropped_{};
+	};
+
+	constexpr size_t default_capacity = 256;
+
+	// The notify callback runs on the publishing thread whenever the queue stops being empty.
+	// Subscriptions end when the returned pointer is released
+	std::shared_ptr<subscriber> subscribe(subscriber::notify_callback notify, size_t capacity = default_capacity);
+
+	// An empty key coalesces by event name
+	void publish(const std::string& name, std::string data, const std::string& key = {});
+	void publish(const std::string& name, const rapidjson::Value& data, const std::string& key = {});
+}
@@ -0,0 +1,253 @@
+#include "file_cache.hpp"
+#include "metrics.hpp"
+
+#include <fstream>
+
+namespace utils
+{
+	namespace
+	{
+		// Reads include the ones of the preload thread, which are also counted as preloads
+		metrics::counter hits{"file_cache.hits"};
+		metrics::counter reads{"file_cache.reads"};
+		metrics::counter preloads{"file_cache.preloads"};
+		metrics::gauge cached_size{"file_cache.size"};
+
+		std::string get_key(const std::string& path)
+		{
+			const auto relative_path = std::filesystem::path(path).relative_path().lexically_normal();
+			if (relative_path.empty() || relative_path.has_root_name() || *relative_path.begin() == "..")
+			{
+				return {};
+			}
+
+			return relative_path.generic_string();
+		}
+
+		file_cache::buffer read_file(const std::filesystem::path& file, const uintmax_t file_size)
+		{
+			std::ifstream stream(file, std::ios::binary);
+			if (!stream.is_open())
+			{
+				return {};
+			}
+
+			auto data = std::make_shared<std::string>();
+			data->resize(static_cast<size_t>(file_size));
+
+			stream.read(data->data(), static_cast<std::streamsize>(data->size()));
+			if (static_cast<size_t>(stream.gcount()) != data->size())
+			{
+				return {};
+			}
+
+			return data;
+		}
+	}
+
+	file_cache::file_cache(std::filesystem::path folder, const size_t capacity)
+		: folder_(std::move(folder))
+		  , capacity_(capacity)
+	{
+	}
+
+	file_cache::~file_cache()
+	{
+		this->stop_preload_ = true;
+
+		if (this->preload_thread_.joinable())
+		{
+			this->preload_thread_.join();
+		}
+	}
+
+	file_cache::buffer file_cache::get(const std::string& path, std::filesystem::file_time_type* write_time)
+	{
+		const auto key = get_key(path);
+		if (key.empty())
+		{
+			return {};
+		}
+
+		std::error_code ec{};
+		const std::filesystem::directory_entry file(this->folder_ / key, ec);
+		if (ec)
+		{
+			return {};
+		}
+
+		return this->get(key, file, write_time);
+	}
+
+	std::optional<std::filesystem::path> file_cache::resolve(const std::string& path) const
+	{
+		const auto key = get_key(path);
+		if (key.empty())
+		{
+			return {};
+		}
+
+		return this->folder_ / key;
+	}
+
+	void file_cache::preload()
+	{
+		if (this->preload_thread_.joinable())
+		{
+			return;
+		}
+
+		this->preload_thread_ = std::thread([this]()
+		{
+			std::error_code ec{};
+			for (std::filesystem::recursive_directory_iterator i(this->folder_, ec), end; !ec && i != end;
+			     i.increment(ec))
+			{
+				if (this->stop_preload_)
+				{
+					break;
+				}
+
+				std::error_code status_code{};
+				if (!i->is_regular_file(status_code))
+				{
+					continue;
+				}
+
+				// Preloading must never push out files that were actually requested
+				const auto file_size = i->file_size(status_code);
+				if (status_code || this->get_size() + file_size > this->capacity_)
+				{
+					continue;
+				}
+
+				const auto key = i->path().lexically_relative(this->folder_).generic_string();
+				preloads.increment();
+				this->get(key, *i, nullptr);
+			}
+		});
+	}
+
+	size_t file_cache::get_size() const
+	{
+		return this->state_.access<size_t>([](const state& state)
+		{
+			return state.size;
+		});
+	}
+
+	file_cache::buffer file_cache::get(const std::string& key, const std::filesystem::directory_entry& file,
+	                                   std::filesystem::file_time_type* write_time)
+	{
+		std::error_code ec{};
+		if (!file.is_regular_file(ec))
+		{
+			return {};
+		}
+
+		const auto file_size = file.file_size(ec);
+		if (ec)
+		{
+			return {};
+		}
+
+		const auto file_write_time = file.last_write_time(ec);
+		if (ec)
+		{
+			return {};
+		}
+
+		if (write_time)
+		{
+			*write_time = file_write_time;
+		}
+
+		auto data = this->find(key, file_write_time, file_size);
+		if (data)
+		{
+			hits.increment();
+			return data;
+		}
+
+		reads.increment();
+		data = read_file(file.path(), file_size);
+		if (!data || data->size() > this->capacity_)
+		{
+			return data;
+		}
+
+		return this->insert(key, std::move(data), file_write_time, file_size);
+	}
+
+	file_cache::buffer file_cache::get(const std::string& key, const std::filesystem::file_time_type write_time,
+	                                   const uintmax_t size, const std::function<buffer()>& load)
+	{
+		auto data = this->find(key, write_time, size);
+		if (data)
+		{
+			hits.increment();
+			return data;
+		}
+
+		reads.increment();
+		data = load();
+		if (!data || data->size() > this->capacity_)
+		{
+			return data;
+		}
+
+		return this->insert(key, std::move(data), write_time, size);
+	}
+
+	file_cache::buffer file_cache::find(const std::string& key, const std::filesystem::file_time_type write_time,
+	                                    const uintmax_t size)
+	{
+		return this->state_.access<buffer>([&](state& state) -> buffer
+		{
+			const auto cached = state.entries.find(key);
+			if (cached == state.entries.end() || !cached->second.is_current(write_time, size))
+			{
+				return {};
+			}
+
+			state.recently_used.splice(state.recently_used.begin(), state.recently_used, cached->second.position);
+			return cached->second.data;
+		});
+	}
+
+	file_cache::buffer file_cache::insert(const std::string& key, buffer data,
+	                                      const std::filesystem::file_time_type write_time, const uintmax_t size)
+	{
+		return this->state_.access<buffer>([&](state& state) -> buffer
+		{
+			auto cached = state.entries.find(key);
+			if (cached != state.entries.end())
+			{
+				// Another thread might have loaded the same file in the meantime
+				if (cached->second.is_current(write_time, size))
+				{
+					return cached->second.data;
+				}
+
+				state.size -= cached->second.data->size();
+				state.recently_used.erase(cached->second.position);
+				state.entries.erase(cached);
+			}
+
+			while (!state.recently_used.empty() && state.size + data->size() > this->capacity_)
+			{
+				const auto evicted = state.entries.find(state.recently_used.back());
+				state.size -= evicted->second.data->size();
+				state.entries.erase(evicted);
+				state.recently_used.pop_back();
+			}
+
+			state.recently_used.push_front(key);
+			state.entries[key] = {data, write_time, size, state.recently_used.begin()};
+			state.size += data->size();
+			cached_size.set(static_cast<int64_t>(state.size));
+
+			return data;
+		});
+	}
+}
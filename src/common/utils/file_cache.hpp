@@ -0,0 +1,83 @@
+#pragma once
+
+#include "concurrency.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace utils
+{
+	// Keeps the contents of files below a folder in memory. Entries are revalidated against
+	// the size and write time of the file on every lookup and evicted least recently used first
+	class file_cache
+	{
+	public:
+		using buffer = std::shared_ptr<const std::string>;
+
+		explicit file_cache(std::filesystem::path folder, size_t capacity = 64 * 1024 * 1024);
+		~file_cache();
+
+		file_cache(file_cache&&) = delete;
+		file_cache(const file_cache&) = delete;
+		file_cache& operator=(file_cache&&) = delete;
+		file_cache& operator=(const file_cache&) = delete;
+
+		// Returns nullptr if the file can not be read or lies outside the folder
+		buffer get(const std::string& path, std::filesystem::file_time_type* write_time = nullptr);
+
+		// Caches data that does not come from a file below the folder, like entries of an archive. Keys must
+		// not be valid relative paths, the write time and size identify the version of the data
+		buffer get(const std::string& key, std::filesystem::file_time_type write_time, uintmax_t size,
+		           const std::function<buffer()>& load);
+
+		// Returns the location of the file, or an empty optional if it lies outside the folder
+		std::optional<std::filesystem::path> resolve(const std::string& path) const;
+
+		// Reads files on a background thread for as long as they fit into the capacity
+		void preload();
+
+		size_t get_size() const;
+
+	private:
+		struct entry
+		{
+			buffer data{};
+			std::filesystem::file_time_type write_time{};
+			uintmax_t file_size{};
+			std::list<std::string>::iterator position{};
+
+			bool is_current(const std::filesystem::file_time_type time, const uintmax_t size) const
+			{
+				return this->file_size == size && this->write_time == time;
+			}
+		};
+
+		struct state
+		{
+			std::unordered_map<std::string, entry> entries{};
+			std::list<std::string> recently_used{};
+			size_t size{};
+		};
+
+		std::filesystem::path folder_{};
+		size_t capacity_{};
+
+		concurrency::container<state> state_{};
+
+		std::atomic_bool stop_preload_{false};
+		std::thread preload_thread_{};
+
+		buffer get(const std::string& key, const std::filesystem::directory_entry& file,
+		           std::filesystem::file_time_type* write_time);
+		buffer find(const std::string& key, std::filesystem::file_time_type write_time, uintmax_t size);
+		buffer insert(const std::string& key, buffer data, std::filesystem::file_time_type write_time,
+		              uintmax_t size);
+	};
+}
@@ -0,0 +1,96 @@
+#include "file_cleanup.hpp"
+
+namespace utils::file_cleanup
+{
+	path_index::path_index(const std::vector<std::string>& files)
+	{
+		this->files_.reserve(files.size());
+
+		for (const auto& file : files)
+		{
+			const auto path = std::filesystem::path(file).lexically_normal();
+			this->files_.emplace(path.generic_string());
+
+			// Every parent folder of a legal file is legal as well
+			for (auto parent = path.parent_path(); !parent.empty(); parent = parent.parent_path())
+			{
+				if (!this->folders_.emplace(parent.generic_string()).second)
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	bool path_index::contains_file(const std::string& key) const
+	{
+		return this->files_.contains(key);
+	}
+
+	bool path_index::contains_folder(const std::string& key) const
+	{
+		return this->folders_.contains(key);
+	}
+
+	std::string path_index::get_key(const std::filesystem::path& path)
+	{
+		return path.lexically_normal().generic_string();
+	}
+
+	std::vector<std::filesystem::path> find_stale_entries(const std::filesystem::path& folder, const path_index& index)
+	{
+		std::vector<std::filesystem::path> stale_entries{};
+
+		std::error_code code{};
+		std::filesystem::recursive_directory_iterator iterator{folder, code};
+		for (const std::filesystem::recursive_directory_iterator end{}; !code && iterator != end; iterator.increment(code))
+		{
+			const auto& entry = *iterator;
+			const auto key = path_index::get_key(entry.path().lexically_relative(folder));
+
+			// Directory entries carry their status from the enumeration, no additional syscalls required
+			std::error_code status_code{};
+			if (entry.is_directory(status_code))
+			{
+				if (index.contains_folder(key))
+				{
+					continue;
+				}
+
+				iterator.disable_recursion_pending();
+			}
+			else if (entry.is_regular_file(status_code) && index.contains_file(key))
+			{
+				continue;
+			}
+
+			stale_entries.emplace_back(entry.path());
+		}
+
+		return stale_entries;
+	}
+
+	void move_to_trash(const std::vector<std::filesystem::path>& entries, const std::filesystem::path& session_folder,
+	                   size_t& trashed_entries)
+	{
+		if (entries.empty())
+		{
+			return;
+		}
+
+		std::error_code code{};
+		std::filesystem::create_directories(session_folder, code);
+
+		for (const auto& entry : entries)
+		{
+			// Entries are renamed by index, as stale files from different folders can share the same name
+			const auto target = session_folder / std::to_string(trashed_entries++);
+
+			std::filesystem::rename(entry, target, code);
+			if (code)
+			{
+				std::filesystem::remove_all(entry, code);
+			}
+		}
+	}
+}
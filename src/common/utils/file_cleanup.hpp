@@ -0,0 +1,36 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace utils::file_cleanup
+{
+	// Hashed sets of the listed files and of every folder above them, which serve as a prefix trie.
+	// Paths are relative, keys are their lexically normal generic form
+	class path_index
+	{
+	public:
+		explicit path_index(const std::vector<std::string>& files);
+
+		bool contains_file(const std::string& key) const;
+		bool contains_folder(const std::string& key) const;
+
+		static std::string get_key(const std::filesystem::path& path);
+
+	private:
+		std::unordered_set<std::string> files_{};
+		std::unordered_set<std::string> folders_{};
+	};
+
+	// Walks the folder once, using the status cached on each directory entry. Returns the entries the index does
+	// not list, stale folders as a whole without descending into them
+	std::vector<std::filesystem::path> find_stale_entries(const std::filesystem::path& folder, const path_index& index);
+
+	// Renames the entries into the session folder, which is purged later. A rename does not need to delete every
+	// file below a stale folder and works on files that are still mapped or open. Entries that cannot be renamed
+	// are removed in place
+	void move_to_trash(const std::vector<std::filesystem::path>& entries, const std::filesystem::path& session_folder,
+	                   size_t& trashed_entries);
+}
@@ -0,0 +1,61 @@
+#include "file_stream.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace utils
+{
+	file_stream::file_stream(const std::filesystem::path& file)
+		: stream_(file, std::ios::binary)
+	{
+		if (!this->stream_.is_open())
+		{
+			throw std::runtime_error("Failed to open " + file.string());
+		}
+
+		this->stream_.seekg(0, std::ios::end);
+		const auto size = static_cast<std::streamoff>(this->stream_.tellg());
+		this->stream_.seekg(0, std::ios::beg);
+
+		if (size < 0)
+		{
+			throw std::runtime_error("Failed to get size of " + file.string());
+		}
+
+		this->size_ = static_cast<uint64_t>(size);
+	}
+
+	uint64_t file_stream::get_size() const
+	{
+		return this->size_;
+	}
+
+	uint64_t file_stream::get_position() const
+	{
+		return this->position_;
+	}
+
+	void file_stream::seek(const uint64_t position)
+	{
+		this->position_ = std::min(position, this->size_);
+
+		this->stream_.clear();
+		this->stream_.seekg(static_cast<std::streamoff>(this->position_), std::ios::beg);
+	}
+
+	size_t file_stream::read(char* buffer, const size_t length)
+	{
+		const auto count = static_cast<size_t>(std::min(static_cast<uint64_t>(length), this->size_ - this->position_));
+		if (!count)
+		{
+			return 0;
+		}
+
+		this->stream_.read(buffer, static_cast<std::streamsize>(count));
+
+		const auto read = static_cast<size_t>(this->stream_.gcount());
+		this->position_ += read;
+
+		return read;
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+
+namespace utils
+{
+	// Reads a file piece by piece into caller provided buffers, so only the stream buffer is kept in memory
+	class file_stream
+	{
+	public:
+		explicit file_stream(const std::filesystem::path& file);
+
+		uint64_t get_size() const;
+		uint64_t get_position() const;
+
+		void seek(uint64_t position);
+		size_t read(char* buffer, size_t length);
+
+	private:
+		std::ifstream stream_{};
+		uint64_t size_{};
+		uint64_t position_{};
+	};
+}
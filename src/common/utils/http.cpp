@@ -1,6 +1,12 @@
 #include "http.hpp"
 #include <curl/curl.h>
 #include "finally.hpp"
+#include "metrics.hpp"
+#include "scheduler.hpp"
+
+#include <array>
+#include <chrono>
+#include <mutex>
 
 #pragma comment(lib, "ws2_32.lib")
 
@@ -8,9 +14,66 @@ namespace utils::http
 {
 	namespace
 	{
+		metrics::counter requests{"http.requests"};
+		metrics::counter failed_requests{"http.failed_requests"};
+		metrics::counter bytes_downloaded{"http.bytes_downloaded"};
+		metrics::counter connections_opened{"http.connections_opened"};
+		metrics::counter connections_reused{"http.connections_reused"};
+		metrics::histogram request_time{"http.request_us"};
+
+		// Easy handles live for one request, so connections are only kept alive across requests
+		// if they share curl's connection cache. DNS and TLS sessions are shared along with it
+		class connection_cache
+		{
+		public:
+			connection_cache()
+				: share_(curl_share_init())
+			{
+				if (!this->share_)
+				{
+					return;
+				}
+
+				curl_share_setopt(this->share_, CURLSHOPT_LOCKFUNC, lock);
+				curl_share_setopt(this->share_, CURLSHOPT_UNLOCKFUNC, unlock);
+				curl_share_setopt(this->share_, CURLSHOPT_USERDATA, this);
+				curl_share_setopt(this->share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+				curl_share_setopt(this->share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+				curl_share_setopt(this->share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+			}
+
+			CURLSH* get() const
+			{
+				return this->share_;
+			}
+
+		private:
+			CURLSH* share_{};
+			std::array<std::mutex, CURL_LOCK_DATA_LAST> mutexes_{};
+
+			static void lock(CURL* /*handle*/, const curl_lock_data data, curl_lock_access /*access*/, void* userptr)
+			{
+				static_cast<connection_cache*>(userptr)->mutexes_[data].lock();
+			}
+
+			static void unlock(CURL* /*handle*/, const curl_lock_data data, void* userptr)
+			{
+				static_cast<connection_cache*>(userptr)->mutexes_[data].unlock();
+			}
+		};
+
+		CURLSH* get_connection_cache()
+		{
+			// Never destroyed: requests on the io scheduler may still be running during static destruction
+			static auto* cache = new connection_cache();
+			return cache->get();
+		}
+
 		struct progress_helper
 		{
 			const std::function<void(size_t)>* callback{};
+			const data_callback* writer{};
+			const concurrency::cancellation_token* token{};
 			std::exception_ptr exception{};
 		};
 
@@ -19,6 +82,12 @@ namespace utils::http
 		{
 			auto* helper = static_cast<progress_helper*>(clientp);
 
+			// Curl calls this at least once per second, even while it waits for data
+			if (helper->token->is_cancelled())
+			{
+				return 1;
+			}
+
 			try
 			{
 				if (*helper->callback)
@@ -37,92 +106,191 @@ namespace utils::http
 
 		size_t write_callback(void* contents, const size_t size, const size_t nmemb, void* userp)
 		{
-			auto* buffer = static_cast<std::string*>(userp);
+			auto* helper = static_cast<progress_helper*>(userp);
 
 			const auto total_size = size * nmemb;
-			buffer->append(static_cast<char*>(contents), total_size);
+			bytes_downloaded.add(total_size);
+
+			try
+			{
+				(*helper->writer)(static_cast<char*>(contents), total_size);
+			}
+			catch (...)
+			{
+				// Anything other than total_size aborts the transfer
+				helper->exception = std::current_exception();
+				return 0;
+			}
+
 			return total_size;
 		}
-	}
 
-	std::optional<std::string> get_data(const std::string& url, const headers& headers,
-	                                    const std::function<void(size_t)>& callback, const uint32_t retries)
-	{
-		curl_slist* header_list = nullptr;
-		auto* curl = curl_easy_init();
-		if (!curl)
+		// Attempts that did not have to connect went over a connection curl kept alive
+		CURLcode perform(CURL* curl)
 		{
-			return {};
-		}
+			const auto result = curl_easy_perform(curl);
 
-		auto _ = utils::finally([&]()
-		{
-			curl_slist_free_all(header_list);
-			curl_easy_cleanup(curl);
-		});
+			long connects = 0;
+			curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
 
-		for (const auto& header : headers)
-		{
-			auto data = header.first + ": " + header.second;
-			header_list = curl_slist_append(header_list, data.data());
-		}
+			if (connects > 0)
+			{
+				connections_opened.add(static_cast<uint64_t>(connects));
+			}
+			else if (result == CURLE_OK)
+			{
+				connections_reused.increment();
+			}
 
-		std::string buffer{};
-		progress_helper helper{};
-		helper.callback = &callback;
+			return result;
+		}
 
-		curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
-		curl_easy_setopt(curl, CURLOPT_URL, url.data());
-		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-		curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buffer);
-		curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progress_callback);
-		curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &helper);
-		curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-		curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-		curl_easy_setopt(curl, CURLOPT_USERAGENT, "xlabs-updater/1.0");
-		curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
-		curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-		curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-
-		for (auto i = 0u; i < retries + 1; ++i)
+		bool perform_request(const std::string& url, const headers& headers, progress_helper& helper,
+		                     const uint32_t retries)
 		{
-			// Due to CURLOPT_FAILONERROR, CURLE_OK will not be met when the server returns 400 or 500
-			if (curl_easy_perform(curl) == CURLE_OK)
+			requests.increment();
+
+			const auto start_time = std::chrono::steady_clock::now();
+			auto succeeded = false;
+
+			auto record_request = utils::finally([&]()
 			{
-				long http_code = 0;
-				curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+				const auto duration = std::chrono::steady_clock::now() - start_time;
+				request_time.record(static_cast<uint64_t>(
+					std::chrono::duration_cast<std::chrono::microseconds>(duration).count()));
 
-				if (http_code >= 200)
+				if (!succeeded)
 				{
-					return {std::move(buffer)};
+					failed_requests.increment();
 				}
+			});
 
-				throw std::runtime_error(
-					"Bad status code " + std::to_string(http_code) + " met while trying to download file " + url);
+			curl_slist* header_list = nullptr;
+			auto* curl = curl_easy_init();
+			if (!curl)
+			{
+				return false;
 			}
 
-			if (helper.exception)
+			auto _ = utils::finally([&]()
+			{
+				curl_slist_free_all(header_list);
+				curl_easy_cleanup(curl);
+			});
+
+			for (const auto& header : headers)
 			{
-				std::rethrow_exception(helper.exception);
+				auto data = header.first + ": " + header.second;
+				header_list = curl_slist_append(header_list, data.data());
 			}
 
-			long http_code = 0;
-			curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+			curl_easy_setopt(curl, CURLOPT_SHARE, get_connection_cache());
+			curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
+			curl_easy_setopt(curl, CURLOPT_URL, url.data());
+			curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+			curl_easy_setopt(curl, CURLOPT_WRITEDATA, &helper);
+			curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progress_callback);
+			curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &helper);
+			curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+			curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+			curl_easy_setopt(curl, CURLOPT_USERAGENT, "xlabs-updater/1.0");
+			curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+			curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+			curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
 
-			if (http_code > 0)
+			for (auto i = 0u; i < retries + 1; ++i)
 			{
-				break;
+				// Due to CURLOPT_FAILONERROR, CURLE_OK will not be met when the server returns 400 or 500
+				if (perform(curl) == CURLE_OK)
+				{
+					long http_code = 0;
+					curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+
+					if (http_code >= 200)
+					{
+						succeeded = true;
+						return true;
+					}
+
+					throw std::runtime_error(
+						"Bad status code " + std::to_string(http_code) + " met while trying to download file " + url);
+				}
+
+				if (helper.exception)
+				{
+					std::rethrow_exception(helper.exception);
+				}
+
+				if (helper.token->is_cancelled())
+				{
+					break;
+				}
+
+				long http_code = 0;
+				curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+
+				if (http_code > 0)
+				{
+					break;
+				}
 			}
+
+			return false;
+		}
+	}
+
+	std::optional<std::string> get_data(const std::string& url, const headers& headers,
+	                                    const std::function<void(size_t)>& callback, const uint32_t retries,
+	                                    const concurrency::cancellation_token& token)
+	{
+		std::string buffer{};
+		const data_callback writer = [&buffer](const char* data, const size_t length)
+		{
+			buffer.append(data, length);
+		};
+
+		progress_helper helper{};
+		helper.callback = &callback;
+		helper.writer = &writer;
+		helper.token = &token;
+
+		if (!perform_request(url, headers, helper, retries))
+		{
+			return {};
 		}
 
-		return {};
+		return {std::move(buffer)};
 	}
 
 	std::future<std::optional<std::string>> get_data_async(const std::string& url, const headers& headers)
 	{
-		return std::async(std::launch::async, [url, headers]()
+		auto promise = std::make_shared<std::promise<std::optional<std::string>>>();
+		auto future = promise->get_future();
+
+		concurrency::get_io_scheduler().post([promise, url, headers]()
 		{
-			return get_data(url, headers);
+			try
+			{
+				promise->set_value(get_data(url, headers));
+			}
+			catch (...)
+			{
+				promise->set_exception(std::current_exception());
+			}
 		});
+
+		return future;
+	}
+
+	bool download(const std::string& url, const data_callback& data_callback, const headers& headers,
+	              const std::function<void(size_t)>& callback, const concurrency::cancellation_token& token)
+	{
+		progress_helper helper{};
+		helper.callback = &callback;
+		helper.writer = &data_callback;
+		helper.token = &token;
+
+		// Data already handed to the callback can't be taken back, so there is no retry
+		return perform_request(url, headers, helper, 0);
 	}
 }
@@ -3,11 +3,18 @@
 #include <string>
 #include <optional>
 #include <future>
+#include <functional>
+
+#include "cancellation.hpp"
 
 namespace utils::http
 {
 	using headers = std::unordered_map<std::string, std::string>;
+	using data_callback = std::function<void(const char* data, size_t length)>;
 
-	std::optional<std::string> get_data(const std::string& url, const headers& headers = {}, const std::function<void(size_t)>& callback = {}, uint32_t retries = 2);
+	// A cancelled token aborts the transfer from curl's progress callback, the request then fails without retrying
+	std::optional<std::string> get_data(const std::string& url, const headers& headers = {}, const std::function<void(size_t)>& callback = {}, uint32_t retries = 2, const concurrency::cancellation_token& token = {});
 	std::future<std::optional<std::string>> get_data_async(const std::string& url, const headers& headers = {});
+
+	bool download(const std::string& url, const data_callback& data_callback, const headers& headers = {}, const std::function<void(size_t)>& callback = {}, const concurrency::cancellation_token& token = {});
 }
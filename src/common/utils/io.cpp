@@ -1,10 +1,37 @@
 #include "io.hpp"
 #include "nt.hpp"
 
+#include <algorithm>
 #include <fstream>
 
 namespace utils::io
 {
+	namespace
+	{
+		// A file that is still open, mapped by another launcher for example, can't be replaced.
+		// It can be renamed though if it was opened with FILE_SHARE_DELETE, so it is moved aside first.
+		// Deleting it then only takes effect once the last handle is closed, leftovers are removed by the next cleanup
+		bool replace_file_in_use(const std::filesystem::path& temp, const std::filesystem::path& target)
+		{
+			auto aside = target;
+			aside += "." + std::to_string(GetCurrentProcessId()) + "-" + std::to_string(GetTickCount64()) + ".old";
+
+			if (!MoveFileExW(target.wstring().data(), aside.wstring().data(), MOVEFILE_WRITE_THROUGH))
+			{
+				return false;
+			}
+
+			if (!MoveFileExW(temp.wstring().data(), target.wstring().data(), MOVEFILE_WRITE_THROUGH))
+			{
+				MoveFileExW(aside.wstring().data(), target.wstring().data(), MOVEFILE_WRITE_THROUGH);
+				return false;
+			}
+
+			DeleteFileW(aside.wstring().data());
+			return true;
+		}
+	}
+
 	bool remove_file(const std::filesystem::path& file)
 	{
 		return DeleteFileW(file.wstring().data()) == TRUE;
@@ -40,6 +67,50 @@ namespace utils::io
 		return false;
 	}
 
+	bool replace_file(const std::string& file, const std::string& data)
+	{
+		const std::filesystem::path target{file};
+		auto temp = target;
+		temp += ".tmp";
+
+		std::error_code ec{};
+		std::filesystem::create_directories(target.parent_path(), ec);
+
+		auto* const handle = CreateFileW(temp.wstring().data(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+		                                 FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		size_t offset = 0;
+		while (offset < data.size())
+		{
+			DWORD written = 0;
+			const auto length = static_cast<DWORD>(std::min(data.size() - offset, static_cast<size_t>(1) << 30));
+			if (!WriteFile(handle, data.data() + offset, length, &written, nullptr) || !written)
+			{
+				break;
+			}
+
+			offset += written;
+		}
+
+		// The data has to be on disk before the rename is, otherwise a crash can leave an empty file behind
+		const auto success = offset == data.size() && FlushFileBuffers(handle);
+		CloseHandle(handle);
+
+		if (!success || (!MoveFileExW(temp.wstring().data(), target.wstring().data(),
+		                              MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) &&
+			!replace_file_in_use(temp, target)))
+		{
+			DeleteFileW(temp.wstring().data());
+			return false;
+		}
+
+		return true;
+	}
+
 	std::string read_file(const std::string& file)
 	{
 		std::string data;
@@ -10,6 +10,9 @@ namespace utils::io
 	bool move_file(const std::filesystem::path& src, const std::filesystem::path& target);
 	bool file_exists(const std::string& file);
 	bool write_file(const std::string& file, const std::string& data, bool append = false);
+	// Writes a temporary file and renames it over the target, so readers see either the old or the new content.
+	// Targets that are open or mapped elsewhere can be replaced too, as long as they were opened with FILE_SHARE_DELETE
+	bool replace_file(const std::string& file, const std::string& data);
 	bool read_file(const std::string& file, std::string* data);
 	std::string read_file(const std::string& file);
 	std::size_t file_size(const std::string& file);
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+namespace utils::json
+{
+	using allocator_type = rapidjson::Document::AllocatorType;
+
+	template <typename Class, typename Type>
+	struct field
+	{
+		using class_type = Class;
+		using value_type = Type;
+
+		std::string_view name;
+		Type Class::* member;
+	};
+
+	template <typename Class, typename Type>
+	constexpr field<Class, Type> make_field(const std::string_view name, Type Class::* member)
+	{
+		return {name, member};
+	}
+
+	// Structs become JSON objects by listing their members in a static constexpr tuple:
+	// static constexpr auto fields = std::make_tuple(utils::json::make_field("name", &type::name), ...);
+	template <typename T>
+	concept described = requires { std::tuple_size<std::remove_cvref_t<decltype(T::fields)>>::value; };
+
+	template <typename T>
+	struct is_optional : std::false_type
+	{
+	};
+
+	template <typename T>
+	struct is_optional<std::optional<T>> : std::true_type
+	{
+	};
+
+	template <typename T>
+	struct is_vector : std::false_type
+	{
+	};
+
+	template <typename T>
+	struct is_vector<std::vector<T>> : std::true_type
+	{
+	};
+
+	template <typename T>
+	struct is_string_map : std::false_type
+	{
+	};
+
+	template <typename T>
+	struct is_string_map<std::map<std::string, T>> : std::true_type
+	{
+	};
+
+	template <typename T>
+	struct is_string_map<std::unordered_map<std::string, T>> : std::true_type
+	{
+	};
+
+	// Returns false if the value does not have the shape of T, in which case out is left partially filled
+	template <typename T>
+	bool decode(const rapidjson::Value& value, T& out)
+	{
+		if constexpr (std::is_same_v<T, std::string>)
+		{
+			if (!value.IsString())
+			{
+				return false;
+			}
+
+			out.assign(value.GetString(), value.GetStringLength());
+			return true;
+		}
+		else if constexpr (std::is_same_v<T, bool>)
+		{
+			if (!value.IsBool())
+			{
+				return false;
+			}
+
+			out = value.GetBool();
+			return true;
+		}
+		else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+		{
+			if (!value.IsInt64())
+			{
+				return false;
+			}
+
+			const auto number = value.GetInt64();
+			if (number < std::numeric_limits<T>::min() || number > std::numeric_limits<T>::max())
+			{
+				return false;
+			}
+
+			out = static_cast<T>(number);
+			return true;
+		}
+		else if constexpr (std::is_integral_v<T>)
+		{
+			if (!value.IsUint64() || value.GetUint64() > std::numeric_limits<T>::max())
+			{
+				return false;
+			}
+
+			out = static_cast<T>(value.GetUint64());
+			return true;
+		}
+		else if constexpr (std::is_floating_point_v<T>)
+		{
+			if (!value.IsNumber())
+			{
+				return false;
+			}
+
+			out = static_cast<T>(value.GetDouble());
+			return true;
+		}
+		else if constexpr (is_optional<T>::value)
+		{
+			if (value.IsNull())
+			{
+				out.reset();
+				return true;
+			}
+
+			return decode(value, out.emplace());
+		}
+		else if constexpr (is_vector<T>::value)
+		{
+			if (!value.IsArray())
+			{
+				return false;
+			}
+
+			out.clear();
+			out.reserve(value.Size());
+
+			for (const auto& element : value.GetArray())
+			{
+				if (!decode(element, out.emplace_back()))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+		else if constexpr (is_string_map<T>::value)
+		{
+			if (!value.IsObject())
+			{
+				return false;
+			}
+
+			out.clear();
+
+			for (const auto& member : value.GetObject())
+			{
+				typename T::mapped_type element{};
+				if (!decode(member.value, element))
+				{
+					return false;
+				}
+
+				out.insert_or_assign(std::string{member.name.GetString(), member.name.GetStringLength()},
+				                     std::move(element));
+			}
+
+			return true;
+		}
+		else if constexpr (described<T>)
+		{
+			if (!value.IsObject())
+			{
+				return false;
+			}
+
+			return std::apply([&value, &out](const auto&... fields)
+			{
+				const auto decode_field = [&value, &out](const auto& field)
+				{
+					using field_type = typename std::remove_cvref_t<decltype(field)>::value_type;
+
+					const rapidjson::Value name(rapidjson::StringRef(field.name.data(), field.name.size()));
+
+					const auto member = value.FindMember(name);
+					if (member == value.MemberEnd())
+					{
+						return is_optional<field_type>::value;
+					}
+
+					return decode(member->value, out.*field.member);
+				};
+
+				return (decode_field(fields) && ...);
+			}, T::fields);
+		}
+		else
+		{
+			static_assert(!sizeof(T), "Type can not be decoded from JSON");
+			return false;
+		}
+	}
+
+	template <typename T>
+	rapidjson::Value encode(const T& value, allocator_type& allocator)
+	{
+		if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+		{
+			return rapidjson::Value{value.data(), static_cast<rapidjson::SizeType>(value.size()), allocator};
+		}
+		else if constexpr (std::is_same_v<T, bool>)
+		{
+			return rapidjson::Value{value};
+		}
+		else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+		{
+			return rapidjson::Value{static_cast<int64_t>(value)};
+		}
+		else if constexpr (std::is_integral_v<T>)
+		{
+			return rapidjson::Value{static_cast<uint64_t>(value)};
+		}
+		else if constexpr (std::is_floating_point_v<T>)
+		{
+			return rapidjson::Value{static_cast<double>(value)};
+		}
+		else if constexpr (is_optional<T>::value)
+		{
+			return value ? encode(*value, allocator) : rapidjson::Value{};
+		}
+		else if constexpr (is_vector<T>::value)
+		{
+			rapidjson::Value result{rapidjson::kArrayType};
+			result.Reserve(static_cast<rapidjson::SizeType>(value.size()), allocator);
+
+			for (const auto& element : value)
+			{
+				result.PushBack(encode(element, allocator), allocator);
+			}
+
+			return result;
+		}
+		else if constexpr (is_string_map<T>::value)
+		{
+			rapidjson::Value result{rapidjson::kObjectType};
+			result.MemberReserve(static_cast<rapidjson::SizeType>(value.size()), allocator);
+
+			for (const auto& [name, element] : value)
+			{
+				result.AddMember(encode(name, allocator), encode(element, allocator), allocator);
+			}
+
+			return result;
+		}
+		else if constexpr (described<T>)
+		{
+			rapidjson::Value result{rapidjson::kObjectType};
+
+			std::apply([&value, &allocator, &result](const auto&... fields)
+			{
+				const auto encode_field = [&value, &allocator, &result](const auto& field)
+				{
+					// Names are compile-time constants, so members reference them instead of copying
+					const rapidjson::Value::StringRefType name(field.name.data(),
+					                                           static_cast<rapidjson::SizeType>(field.name.size()));
+					result.AddMember(name, encode(value.*field.member, allocator), allocator);
+				};
+
+				(encode_field(fields), ...);
+			}, T::fields);
+
+			return result;
+		}
+		else
+		{
+			static_assert(!sizeof(T), "Type can not be encoded to JSON");
+			return {};
+		}
+	}
+
+	template <typename T>
+	void encode(const T& value, rapidjson::Document& document)
+	{
+		static_cast<rapidjson::Value&>(document) = encode(value, document.GetAllocator());
+	}
+}
@@ -1,58 +1,593 @@
 #include "logger.hpp"
 #include "nt.hpp"
+#include "ring_queue.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace utils::logger
 {
 	namespace
 	{
 		constexpr auto* log_file_name = "xlabs.log";
-		std::mutex logger_mutex;
 
-		std::ofstream& get_stream()
+		// Full logs are moved to xlabs.1.log, xlabs.2.log and so on, the oldest one is dropped
+		constexpr size_t max_log_size = 10 * 1024 * 1024;
+		constexpr size_t rotated_log_count = 3;
+
+		constexpr size_t thread_buffer_capacity = 1024;
+		constexpr auto write_interval = std::chrono::milliseconds(50);
+
+		// The writer keeps going without waiting while batches are at least this large
+		constexpr size_t busy_batch_size = 256;
+
+		std::atomic<level> runtime_level{min_level};
+
+		struct record
+		{
+			std::chrono::system_clock::time_point time{};
+			level severity{};
+			std::string text{};
+		};
+
+		// Variable sized records of deferred calls. A header without descriptor, or too little room for a header,
+		// skips to the end of the ring
+		class binary_ring
+		{
+		public:
+			static constexpr size_t capacity = 64 * 1024;
+
+			struct header
+			{
+				uint32_t size{};
+				const detail::descriptor* descriptor{};
+				std::chrono::system_clock::time_point time{};
+			};
+
+			static bool fits(const size_t size)
+			{
+				return get_record_size(size) <= capacity / 2;
+			}
+
+			// Returns nullptr if the ring is full
+			char* reserve(const detail::descriptor& descriptor, const size_t size)
+			{
+				const auto record_size = get_record_size(size);
+
+				const auto tail = this->tail_.load(std::memory_order_relaxed);
+				const auto head = this->head_.load(std::memory_order_acquire);
+
+				const auto offset = tail % capacity;
+				const auto skip = capacity - offset < record_size ? capacity - offset : 0;
+
+				if (capacity - (tail - head) < record_size + skip)
+				{
+					return nullptr;
+				}
+
+				if (skip >= sizeof(header))
+				{
+					*this->get_header(offset) = {static_cast<uint32_t>(skip), nullptr, {}};
+				}
+
+				const auto start = tail + skip;
+				*this->get_header(start % capacity) = {
+					static_cast<uint32_t>(record_size), &descriptor, std::chrono::system_clock::now()
+				};
+
+				this->reserved_tail_ = start + record_size;
+				return this->data_.get() + start % capacity + sizeof(header);
+			}
+
+			void commit()
+			{
+				this->tail_.store(this->reserved_tail_, std::memory_order_release);
+			}
+
+			// Formats everything committed so far
+			template <typename F>
+			void drain(F&& callback)
+			{
+				auto head = this->head_.load(std::memory_order_relaxed);
+				const auto tail = this->tail_.load(std::memory_order_acquire);
+
+				while (head != tail)
+				{
+					const auto offset = head % capacity;
+					if (capacity - offset < sizeof(header))
+					{
+						head += capacity - offset;
+						continue;
+					}
+
+					const auto* record_header = this->get_header(offset);
+					if (record_header->descriptor)
+					{
+						callback(*record_header, this->data_.get() + offset + sizeof(header));
+					}
+
+					head += record_header->size;
+				}
+
+				this->head_.store(head, std::memory_order_release);
+			}
+
+		private:
+			std::unique_ptr<char[]> data_{std::make_unique<char[]>(capacity)};
+			size_t reserved_tail_{};
+
+			alignas(64) std::atomic<size_t> tail_{0};
+			alignas(64) std::atomic<size_t> head_{0};
+
+			static size_t get_record_size(const size_t size)
+			{
+				constexpr auto alignment = alignof(header);
+				return (sizeof(header) + size + alignment - 1) / alignment * alignment;
+			}
+
+			header* get_header(const size_t offset) const
+			{
+				return reinterpret_cast<header*>(this->data_.get() + offset);
+			}
+		};
+
+		// Only the owning thread pushes, consumers are serialized by the writer's file mutex
+		struct thread_buffer
+		{
+			concurrency::spsc_queue<record> records{thread_buffer_capacity};
+			binary_ring binary_records{};
+			std::atomic_bool retired{false};
+		};
+
+		// The deferred call in progress on this thread. Those that do not fit the ring, or come in once
+		// the writer is gone, are encoded into data and formatted right away
+		struct pending_record
+		{
+			const detail::descriptor* descriptor{};
+			bool buffered{};
+			std::string data{};
+		};
+
+		thread_local pending_record current_record{};
+
+		const char* get_level_name(const level level)
 		{
-			static auto log_file_stream =
-				std::ofstream(log_file_name, std::ios_base::out | std::ios_base::trunc);
-			return log_file_stream;
+			switch (level)
+			{
+			case level::trace:
+				return "trace";
+			case level::debug:
+				return "debug";
+			case level::info:
+				return "info";
+			case level::warning:
+				return "warn";
+			case level::error:
+				return "error";
+			}
+
+			return "";
 		}
 
-		void write_to_log(const std::string& line)
+		std::filesystem::path get_rotated_log_name(const size_t index)
 		{
-			std::unique_lock _(logger_mutex);
+			return std::format("xlabs.{}.log", index);
+		}
 
+		std::string format_deferred(const detail::descriptor& descriptor, const char* data)
+		{
 			try
 			{
-				auto& log_file_stream = get_stream();
+				return descriptor.formatter(descriptor, data);
+			}
+			catch (const std::exception& e)
+			{
+				return std::format("Failed to format \"{}\": {}", descriptor.format, e.what());
+			}
+		}
+
+		class log_writer
+		{
+		public:
+			log_writer()
+			{
+				this->stream_ = std::ofstream(log_file_name, std::ios_base::out | std::ios_base::trunc |
+				                              std::ios_base::binary);
+
+				this->thread_ = std::thread([this]()
+				{
+					this->run();
+				});
+			}
+
+			void push(record&& record)
+			{
+				const auto urgent = record.severity >= level::error;
+
+				if (!this->stopped_)
+				{
+					auto& buffer = this->get_thread_buffer();
+
+					// A full buffer waits for the writer rather than dropping lines
+					while (!this->stopped_)
+					{
+						if (buffer.records.try_push(std::move(record)))
+						{
+							if (urgent)
+							{
+								this->condition_variable_.notify_one();
+							}
+
+							return;
+						}
+
+						this->wait_for_writer();
+					}
+				}
+
+				// Once the writer is gone lines are written by the calling thread
+				std::lock_guard<std::mutex> _{this->file_mutex_};
+				this->drain();
+				this->batch_.emplace_back(std::move(record));
+				this->write_batch();
+			}
+
+			char* begin_record(const detail::descriptor& descriptor, const size_t size)
+			{
+				if (!this->stopped_ && binary_ring::fits(size))
+				{
+					auto& ring = this->get_thread_buffer().binary_records;
+
+					while (!this->stopped_)
+					{
+						if (auto* data = ring.reserve(descriptor, size))
+						{
+							current_record.descriptor = &descriptor;
+							current_record.buffered = true;
+							return data;
+						}
+
+						this->wait_for_writer();
+					}
+				}
+
+				current_record.descriptor = &descriptor;
+				current_record.buffered = false;
+				current_record.data.resize(size);
+				return current_record.data.data();
+			}
+
+			void commit_record()
+			{
+				const auto& descriptor = *current_record.descriptor;
+
+				if (current_record.buffered)
+				{
+					this->get_thread_buffer().binary_records.commit();
+
+					if (descriptor.severity >= level::error)
+					{
+						this->condition_variable_.notify_one();
+					}
+
+					return;
+				}
+
+				record record{};
+				record.time = std::chrono::system_clock::now();
+				record.severity = descriptor.severity;
+				record.text = format_deferred(descriptor, current_record.data.data());
+
+				this->push(std::move(record));
+			}
+
+			size_t flush()
+			{
+				std::lock_guard<std::mutex> _{this->file_mutex_};
+				this->drain();
+
+				const auto count = this->batch_.size();
+				this->write_batch();
+				return count;
+			}
+
+			// Never blocks, a crash can happen while the log is being written
+			void flush_after_crash()
+			{
+				std::unique_lock<std::mutex> lock{this->file_mutex_, std::try_to_lock};
+				if (lock.owns_lock())
+				{
+					this->drain();
+					this->write_batch();
+				}
+			}
+
+			void stop()
+			{
+				{
+					std::lock_guard<std::mutex> _{this->mutex_};
+					this->stopping_ = true;
+				}
+
+				this->condition_variable_.notify_all();
+
+				if (this->thread_.joinable())
+				{
+					this->thread_.join();
+				}
+
+				this->stopped_ = true;
+				this->flush();
+			}
+
+		private:
+			std::mutex mutex_{};
+			std::condition_variable condition_variable_{};
+			std::vector<std::shared_ptr<thread_buffer>> buffers_{};
+			bool stopping_{false};
+			std::atomic_bool stopped_{false};
+			std::thread thread_{};
+
+			std::mutex file_mutex_{};
+			std::ofstream stream_{};
+			size_t size_{};
+			std::vector<record> batch_{};
+			std::string text_{};
+
+			time_t local_second_{};
+			tm local_time_{};
+
+			void wait_for_writer()
+			{
+				this->condition_variable_.notify_one();
+				std::this_thread::yield();
+			}
+
+			thread_buffer& get_thread_buffer()
+			{
+				struct holder
+				{
+					std::shared_ptr<thread_buffer> buffer{};
+
+					~holder()
+					{
+						if (this->buffer)
+						{
+							this->buffer->retired = true;
+						}
+					}
+				};
+
+				thread_local holder local{};
+				if (!local.buffer)
+				{
+					local.buffer = std::make_shared<thread_buffer>();
+
+					std::lock_guard<std::mutex> _{this->mutex_};
+					this->buffers_.emplace_back(local.buffer);
+				}
+
+				return *local.buffer;
+			}
+
+			void run()
+			{
+				std::unique_lock<std::mutex> lock{this->mutex_};
+
+				size_t count{};
+
+				while (!this->stopping_)
+				{
+					if (count < busy_batch_size)
+					{
+						this->condition_variable_.wait_for(lock, write_interval);
+					}
+
+					lock.unlock();
+					count = this->flush();
+					lock.lock();
+				}
+			}
+
+			// Requires the file mutex
+			void drain()
+			{
+				std::vector<std::shared_ptr<thread_buffer>> buffers{};
+
+				{
+					std::lock_guard<std::mutex> _{this->mutex_};
+					buffers = this->buffers_;
+				}
+
+				for (const auto& buffer : buffers)
+				{
+					// Checked first, so nothing pushed before the thread exited is missed below
+					const auto retired = buffer->retired.load();
+
+					while (auto record = buffer->records.try_pop())
+					{
+						this->batch_.emplace_back(std::move(*record));
+					}
+
+					buffer->binary_records.drain([this](const binary_ring::header& header, const char* data)
+					{
+						this->batch_.emplace_back(record{
+							header.time, header.descriptor->severity, format_deferred(*header.descriptor, data)
+						});
+					});
+
+					if (retired)
+					{
+						std::lock_guard<std::mutex> _{this->mutex_};
+						std::erase(this->buffers_, buffer);
+					}
+				}
+			}
+
+			// Requires the file mutex
+			void write_batch()
+			{
+				if (this->batch_.empty())
+				{
+					return;
+				}
+
+				// Buffers are drained one after another, this restores the order across threads
+				std::ranges::stable_sort(this->batch_, {}, &record::time);
+
+				this->text_.clear();
+				for (const auto& record : this->batch_)
+				{
+					const auto time = std::chrono::system_clock::to_time_t(record.time);
+					const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+						record.time.time_since_epoch()).count() % 1000;
+
+					// Converting to local time is slow, most lines share their second with the one before
+					if (time != this->local_second_)
+					{
+						this->local_second_ = time;
+						localtime_s(&this->local_time_, &time);
+					}
 
-				if (log_file_stream.is_open())
+					std::format_to(std::back_inserter(this->text_), "{:02}:{:02}:{:02}.{:03} [{}] {}\n",
+					               this->local_time_.tm_hour, this->local_time_.tm_min, this->local_time_.tm_sec,
+					               milliseconds, get_level_name(record.severity), record.text);
+				}
+
+				this->batch_.clear();
+
+				try
+				{
+					if (this->size_ + this->text_.size() > max_log_size && this->size_ > 0)
+					{
+						this->rotate();
+					}
+
+					if (this->stream_.is_open())
+					{
+						this->stream_.write(this->text_.data(), static_cast<std::streamsize>(this->text_.size()));
+						this->stream_.flush();
+						this->size_ += this->text_.size();
+					}
+				}
+				catch (const std::exception&)
 				{
-					log_file_stream << line << std::endl;
+					MessageBoxA(nullptr, "Failed to write to the log file.\nSomething is seriously wrong.",
+						nullptr, MB_ICONERROR);
 				}
 			}
-			catch (const std::exception&)
+
+			void rotate()
 			{
-				MessageBoxA(nullptr, "Failed to write to the log file.\nSomething is seriously wrong.",
-					nullptr, MB_ICONERROR);
+				this->stream_.close();
+
+				std::error_code e{};
+				std::filesystem::remove(get_rotated_log_name(rotated_log_count), e);
+
+				for (auto i = rotated_log_count; i > 1; --i)
+				{
+					std::filesystem::rename(get_rotated_log_name(i - 1), get_rotated_log_name(i), e);
+				}
+
+				std::filesystem::rename(log_file_name, get_rotated_log_name(1), e);
+
+				this->stream_ = std::ofstream(log_file_name, std::ios_base::out | std::ios_base::trunc |
+				                              std::ios_base::binary);
+				this->size_ = 0;
 			}
+		};
+
+		LPTOP_LEVEL_EXCEPTION_FILTER previous_exception_filter{};
+
+		log_writer& get_writer();
+
+		LONG WINAPI exception_filter(EXCEPTION_POINTERS* exception_info)
+		{
+			get_writer().flush_after_crash();
+			return previous_exception_filter
+				       ? previous_exception_filter(exception_info)
+				       : EXCEPTION_CONTINUE_SEARCH;
+		}
+
+		log_writer& get_writer()
+		{
+			// Never destroyed, lines can still be logged from exit callbacks once the writer has stopped
+			static auto* writer = []()
+			{
+				auto* result = new log_writer();
+
+				// Not utils::at_exit, the first line may well be logged from one of its callbacks
+				::atexit([]()
+				{
+					get_writer().stop();
+				});
+
+				previous_exception_filter = SetUnhandledExceptionFilter(exception_filter);
+				return result;
+			}();
+
+			return *writer;
 		}
 	}
 
+	namespace detail
+	{
+		char* begin_record(const descriptor& descriptor, const size_t size)
+		{
+			return get_writer().begin_record(descriptor, size);
+		}
+
+		void commit_record()
+		{
+			get_writer().commit_record();
+		}
+	}
+
+	void set_level(const level level)
+	{
+		runtime_level = level;
+	}
+
+	bool is_enabled(const level level)
+	{
+		return level >= runtime_level.load(std::memory_order_relaxed);
+	}
+
+	void flush()
+	{
+		get_writer().flush();
+	}
+
 #ifdef _DEBUG
-	void log_format(const std::source_location& location, const std::string_view& fmt, std::format_args&& args)
+	void log_format(const level level, const std::source_location& location, const std::string_view& fmt,
+	                std::format_args&& args)
 #else
-	void log_format(const std::string_view& fmt, std::format_args&& args)
+	void log_format(const level level, const std::string_view& fmt, std::format_args&& args)
 #endif
 	{
+		record record{};
+		record.time = std::chrono::system_clock::now();
+		record.severity = level;
+
 #ifdef _DEBUG
-		const auto loc_info = std::format("Debug: {}::{}\n    ", location.file_name(), location.function_name());
-		const auto line = loc_info + std::vformat(fmt, args);
+		record.text = std::format("Debug: {}::{}\n    ", location.file_name(), location.function_name());
+		record.text += std::vformat(fmt, args);
 #else
-		const auto line = std::vformat(fmt, args);
+		record.text = std::vformat(fmt, args);
 #endif
 
-		write_to_log(line);
+		get_writer().push(std::move(record));
 	}
 }
@@ -1,14 +1,47 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <format>
 #include <source_location>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 
 namespace utils::logger
 {
+	enum class level : uint8_t
+	{
+		trace,
+		debug,
+		info,
+		warning,
+		error,
+	};
+
+	// Calls below this level compile to nothing. Builds can override it by defining LOGGER_MIN_LEVEL
+#if defined(LOGGER_MIN_LEVEL)
+	constexpr auto min_level = static_cast<level>(LOGGER_MIN_LEVEL);
+#elif defined(_DEBUG)
+	constexpr auto min_level = level::trace;
+#else
+	constexpr auto min_level = level::info;
+#endif
+
+	// Filters at runtime on top of min_level, before anything is formatted
+	void set_level(level level);
+	bool is_enabled(level level);
+
+	// Returns once every line logged so far has been written to the file
+	void flush();
+
 #ifdef _DEBUG
-	void log_format(const std::source_location& location, const std::string_view& fmt, std::format_args&& args);
+	void log_format(level level, const std::source_location& location, const std::string_view& fmt,
+	                std::format_args&& args);
 #else
-	void log_format(const std::string_view& fmt, std::format_args&& args);
+	void log_format(level level, const std::string_view& fmt, std::format_args&& args);
 #endif
 
 	struct format_with_location
@@ -31,13 +64,188 @@ namespace utils::logger
 		}
 	};
 
-	template <typename... Args>
-	void write(const format_with_location& fmt, const Args&... args)
+	template <level Level, typename... Args>
+	void log(const format_with_location& fmt, const Args&... args)
 	{
+		if constexpr (Level >= min_level)
+		{
+			if (!is_enabled(Level))
+			{
+				return;
+			}
+
 #ifdef _DEBUG
-		log_format(fmt.location, fmt.format, std::make_format_args(args...));
+			log_format(Level, fmt.location, fmt.format, std::make_format_args(args...));
 #else
-		log_format(fmt.format, std::make_format_args(args...));
+			log_format(Level, fmt.format, std::make_format_args(args...));
 #endif
+		}
+	}
+
+	template <typename... Args>
+	void trace(const format_with_location& fmt, const Args&... args)
+	{
+		log<level::trace>(fmt, args...);
+	}
+
+	template <typename... Args>
+	void debug(const format_with_location& fmt, const Args&... args)
+	{
+		log<level::debug>(fmt, args...);
+	}
+
+	template <typename... Args>
+	void warn(const format_with_location& fmt, const Args&... args)
+	{
+		log<level::warning>(fmt, args...);
+	}
+
+	template <typename... Args>
+	void error(const format_with_location& fmt, const Args&... args)
+	{
+		log<level::error>(fmt, args...);
+	}
+
+	template <typename... Args>
+	void write(const format_with_location& fmt, const Args&... args)
+	{
+		log<level::info>(fmt, args...);
+	}
+
+	template <size_t Size>
+	struct format_literal
+	{
+		char value[Size]{};
+
+		constexpr format_literal(const char (&string)[Size])
+		{
+			std::copy_n(string, Size, this->value);
+		}
+
+		constexpr std::string_view get() const
+		{
+			return {this->value, Size - 1};
+		}
+	};
+
+	namespace detail
+	{
+		struct descriptor;
+		using format_function = std::string (*)(const descriptor& descriptor, const char* data);
+
+		// One per call site, its address identifies the format in the binary records
+		struct descriptor
+		{
+			level severity{};
+			std::string_view format{};
+			format_function formatter{};
+		};
+
+		template <typename T>
+		constexpr bool is_text = std::is_convertible_v<const T&, std::string_view>;
+
+		template <typename T>
+		using stored_type = std::conditional_t<is_text<T>, std::string_view, T>;
+
+		template <typename T>
+		size_t get_encoded_size(const T& value)
+		{
+			if constexpr (is_text<T>)
+			{
+				return sizeof(uint32_t) + std::string_view{value}.size();
+			}
+			else
+			{
+				return sizeof(T);
+			}
+		}
+
+		template <typename T>
+		void encode(char*& out, const T& value)
+		{
+			if constexpr (is_text<T>)
+			{
+				const std::string_view text{value};
+				const auto length = static_cast<uint32_t>(text.size());
+
+				std::memcpy(out, &length, sizeof(length));
+				std::memcpy(out + sizeof(length), text.data(), length);
+				out += sizeof(length) + length;
+			}
+			else
+			{
+				std::memcpy(out, &value, sizeof(T));
+				out += sizeof(T);
+			}
+		}
+
+		template <typename T>
+		stored_type<T> decode(const char*& in)
+		{
+			if constexpr (is_text<T>)
+			{
+				uint32_t length{};
+				std::memcpy(&length, in, sizeof(length));
+
+				const std::string_view text{in + sizeof(length), length};
+				in += sizeof(length) + length;
+				return text;
+			}
+			else
+			{
+				T value{};
+				std::memcpy(&value, in, sizeof(T));
+				in += sizeof(T);
+				return value;
+			}
+		}
+
+		template <typename... Args>
+		std::string format_record(const descriptor& descriptor, const char* data)
+		{
+			// Braced initialization decodes the arguments in order
+			const std::tuple<stored_type<Args>...> values{decode<Args>(data)...};
+
+			return std::apply([&descriptor](const auto&... arguments)
+			{
+				return std::vformat(descriptor.format, std::make_format_args(arguments...));
+			}, values);
+		}
+
+		// Returns where the encoded arguments go, commit_record publishes them
+		char* begin_record(const descriptor& descriptor, size_t size);
+		void commit_record();
+	}
+
+	// Only copies the arguments, formatting happens on the writer thread. Strings are copied by value,
+	// everything else has to be trivially copyable. Unlike write, lines carry no source location in debug builds
+	template <level Level, format_literal Format, typename... Args>
+	void log_deferred(const Args&... args)
+	{
+		static_assert(((detail::is_text<Args> || (std::is_trivially_copyable_v<Args> && !std::is_array_v<Args>)) && ...),
+		              "Deferred arguments must be strings or trivially copyable");
+
+		if constexpr (Level >= min_level)
+		{
+			if (!is_enabled(Level))
+			{
+				return;
+			}
+
+			// Checks the format against the arguments at compile time
+			[[maybe_unused]] constexpr std::format_string<detail::stored_type<Args>...> check{Format.get()};
+
+			static constexpr detail::descriptor descriptor{Level, Format.get(), &detail::format_record<Args...>};
+
+			auto* out = detail::begin_record(descriptor, (detail::get_encoded_size(args) + ... + 0));
+			(detail::encode(out, args), ...);
+			detail::commit_record();
+		}
+	}
+
+	template <format_literal Format, typename... Args>
+	void write_deferred(const Args&... args)
+	{
+		log_deferred<level::info, Format>(args...);
 	}
 }
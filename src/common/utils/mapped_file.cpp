@@ -0,0 +1,74 @@
+#include "mapped_file.hpp"
+#include "nt.hpp"
+
+#include <stdexcept>
+
+namespace utils
+{
+	mapped_file::mapped_file(const std::filesystem::path& file)
+	{
+		this->file_ = CreateFileW(file.wstring().data(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+		                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (this->file_ == INVALID_HANDLE_VALUE)
+		{
+			this->file_ = nullptr;
+			throw std::runtime_error("Failed to open " + file.string());
+		}
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(this->file_, &size))
+		{
+			this->close();
+			throw std::runtime_error("Failed to get size of " + file.string());
+		}
+
+		this->size_ = static_cast<size_t>(size.QuadPart);
+		if (!this->size_)
+		{
+			return;
+		}
+
+		this->mapping_ = CreateFileMappingW(this->file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (this->mapping_)
+		{
+			this->data_ = static_cast<const char*>(MapViewOfFile(this->mapping_, FILE_MAP_READ, 0, 0, 0));
+		}
+
+		if (!this->data_)
+		{
+			this->close();
+			throw std::runtime_error("Failed to map " + file.string());
+		}
+	}
+
+	mapped_file::~mapped_file()
+	{
+		this->close();
+	}
+
+	std::string_view mapped_file::get_data() const
+	{
+		return {this->data_, this->data_ ? this->size_ : 0};
+	}
+
+	void mapped_file::close()
+	{
+		if (this->data_)
+		{
+			UnmapViewOfFile(this->data_);
+			this->data_ = nullptr;
+		}
+
+		if (this->mapping_)
+		{
+			CloseHandle(this->mapping_);
+			this->mapping_ = nullptr;
+		}
+
+		if (this->file_)
+		{
+			CloseHandle(this->file_);
+			this->file_ = nullptr;
+		}
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+namespace utils
+{
+	// Read-only view of a whole file. The file can still be replaced through io::replace_file while it is mapped
+	class mapped_file
+	{
+	public:
+		explicit mapped_file(const std::filesystem::path& file);
+		~mapped_file();
+
+		mapped_file(mapped_file&&) = delete;
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(mapped_file&&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		std::string_view get_data() const;
+
+	private:
+		void* file_{};
+		void* mapping_{};
+		const char* data_{};
+		size_t size_{};
+
+		void close();
+	};
+}
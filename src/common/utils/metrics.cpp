@@ -0,0 +1,256 @@
+#include "metrics.hpp"
+
+#include "io.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <mutex>
+#include <vector>
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+namespace utils::metrics
+{
+	namespace
+	{
+		struct registry
+		{
+			std::mutex mutex{};
+			std::vector<const counter*> counters{};
+			std::vector<const gauge*> gauges{};
+			std::vector<const histogram*> histograms{};
+		};
+
+		// Never destroyed, metrics defined at namespace scope unregister during static destruction
+		registry& get_registry()
+		{
+			static auto* instance = new registry();
+			return *instance;
+		}
+
+		template <typename T>
+		void add_metric(std::vector<const T*> registry::* metrics, const T* metric)
+		{
+			auto& instance = get_registry();
+			std::lock_guard<std::mutex> _{instance.mutex};
+			(instance.*metrics).emplace_back(metric);
+		}
+
+		template <typename T>
+		void remove_metric(std::vector<const T*> registry::* metrics, const T* metric)
+		{
+			auto& instance = get_registry();
+			std::lock_guard<std::mutex> _{instance.mutex};
+			std::erase(instance.*metrics, metric);
+		}
+	}
+
+	namespace detail
+	{
+		size_t allocate_shard()
+		{
+			static std::atomic<size_t> next_shard{0};
+			return next_shard++ % counter::shard_count;
+		}
+	}
+
+	counter::counter(std::string name)
+		: name_(std::move(name))
+	{
+		add_metric(&registry::counters, this);
+	}
+
+	counter::~counter()
+	{
+		remove_metric(&registry::counters, this);
+	}
+
+	uint64_t counter::get() const
+	{
+		uint64_t value = 0;
+		for (const auto& shard : this->shards_)
+		{
+			value += shard.value.load(std::memory_order_relaxed);
+		}
+
+		return value;
+	}
+
+	const std::string& counter::get_name() const
+	{
+		return this->name_;
+	}
+
+	gauge::gauge(std::string name)
+		: name_(std::move(name))
+	{
+		add_metric(&registry::gauges, this);
+	}
+
+	gauge::~gauge()
+	{
+		remove_metric(&registry::gauges, this);
+	}
+
+	int64_t gauge::get() const
+	{
+		return this->value_.load(std::memory_order_relaxed);
+	}
+
+	const std::string& gauge::get_name() const
+	{
+		return this->name_;
+	}
+
+	histogram::histogram(std::string name)
+		: name_(std::move(name))
+	{
+		add_metric(&registry::histograms, this);
+	}
+
+	histogram::~histogram()
+	{
+		remove_metric(&registry::histograms, this);
+	}
+
+	void histogram::record(const uint64_t value)
+	{
+		this->buckets_[get_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+		this->sum_.fetch_add(value, std::memory_order_relaxed);
+
+		auto max = this->max_.load(std::memory_order_relaxed);
+		while (value > max && !this->max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	histogram_snapshot histogram::get_snapshot() const
+	{
+		totals totals{};
+		this->add_to(totals);
+		return summarize(totals);
+	}
+
+	void histogram::add_to(totals& totals) const
+	{
+		for (size_t i = 0; i < bucket_count; ++i)
+		{
+			totals.buckets[i] += this->buckets_[i].load(std::memory_order_relaxed);
+		}
+
+		totals.sum += this->sum_.load(std::memory_order_relaxed);
+		totals.max = std::max(totals.max, this->max_.load(std::memory_order_relaxed));
+	}
+
+	histogram_snapshot histogram::summarize(const totals& totals)
+	{
+		histogram_snapshot snapshot{};
+		for (const auto count : totals.buckets)
+		{
+			snapshot.count += count;
+		}
+
+		snapshot.sum = totals.sum;
+		snapshot.max = totals.max;
+
+		const auto get_percentile = [&](const double percentile)
+		{
+			const auto rank = static_cast<uint64_t>(static_cast<double>(snapshot.count) * percentile);
+
+			uint64_t seen = 0;
+			for (size_t i = 0; i < bucket_count; ++i)
+			{
+				seen += totals.buckets[i];
+				if (seen > rank)
+				{
+					return std::min(get_bucket_value(i), snapshot.max);
+				}
+			}
+
+			return snapshot.max;
+		};
+
+		snapshot.p50 = get_percentile(0.5);
+		snapshot.p90 = get_percentile(0.9);
+		snapshot.p99 = get_percentile(0.99);
+		snapshot.p999 = get_percentile(0.999);
+
+		return snapshot;
+	}
+
+	const std::string& histogram::get_name() const
+	{
+		return this->name_;
+	}
+
+	// Values below 32 have their own bucket, above that every power of two is split into 16 buckets
+	size_t histogram::get_bucket(const uint64_t value)
+	{
+		if (value < 2 * sub_bucket_count)
+		{
+			return static_cast<size_t>(value);
+		}
+
+		const auto shift = static_cast<size_t>(std::bit_width(value)) - 1 - sub_bucket_bits;
+		const auto sub_bucket = static_cast<size_t>(value >> shift) - sub_bucket_count;
+		return (shift + 1) * sub_bucket_count + sub_bucket;
+	}
+
+	// The middle of the range the bucket covers
+	uint64_t histogram::get_bucket_value(const size_t bucket)
+	{
+		if (bucket < 2 * sub_bucket_count)
+		{
+			return bucket;
+		}
+
+		const auto shift = bucket / sub_bucket_count - 1;
+		const auto lower = static_cast<uint64_t>(bucket % sub_bucket_count + sub_bucket_count) << shift;
+		return lower + ((1ull << shift) >> 1);
+	}
+
+	snapshot get_snapshot()
+	{
+		auto& instance = get_registry();
+		std::lock_guard<std::mutex> _{instance.mutex};
+
+		snapshot result{};
+
+		for (const auto* counter : instance.counters)
+		{
+			result.counters[counter->get_name()] += counter->get();
+		}
+
+		for (const auto* gauge : instance.gauges)
+		{
+			result.gauges[gauge->get_name()] += gauge->get();
+		}
+
+		std::map<std::string, histogram::totals> histograms{};
+		for (const auto* histogram : instance.histograms)
+		{
+			histogram->add_to(histograms[histogram->get_name()]);
+		}
+
+		for (const auto& [name, totals] : histograms)
+		{
+			result.histograms[name] = histogram::summarize(totals);
+		}
+
+		return result;
+	}
+
+	bool save(const std::filesystem::path& file)
+	{
+		rapidjson::Document doc{};
+		json::encode(get_snapshot(), doc);
+
+		rapidjson::StringBuffer buffer{};
+		rapidjson::PrettyWriter<rapidjson::StringBuffer, rapidjson::Document::EncodingType, rapidjson::ASCII<>>
+			writer(buffer);
+		doc.Accept(writer);
+
+		return io::write_file(file.string(), {buffer.GetString(), buffer.GetSize()});
+	}
+}
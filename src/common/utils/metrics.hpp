@@ -0,0 +1,172 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+
+namespace utils::metrics
+{
+	namespace detail
+	{
+		size_t allocate_shard();
+
+		inline size_t get_shard()
+		{
+			thread_local const auto shard = allocate_shard();
+			return shard;
+		}
+	}
+
+	// Metrics register themselves under their name for as long as they exist, which makes them meant to be
+	// defined at namespace scope. Metrics sharing a name are reported as one. Reading never stops writers
+	class counter
+	{
+	public:
+		explicit counter(std::string name);
+		~counter();
+
+		counter(counter&&) = delete;
+		counter(const counter&) = delete;
+		counter& operator=(counter&&) = delete;
+		counter& operator=(const counter&) = delete;
+
+		void add(const uint64_t value)
+		{
+			this->shards_[detail::get_shard()].value.fetch_add(value, std::memory_order_relaxed);
+		}
+
+		void increment()
+		{
+			this->add(1);
+		}
+
+		uint64_t get() const;
+		const std::string& get_name() const;
+
+		static constexpr size_t shard_count = 16;
+
+	private:
+		// Threads are spread over the shards, so concurrent increments rarely touch the same line
+		struct alignas(64) shard
+		{
+			std::atomic<uint64_t> value{0};
+		};
+
+		std::string name_{};
+		std::array<shard, shard_count> shards_{};
+	};
+
+	class gauge
+	{
+	public:
+		explicit gauge(std::string name);
+		~gauge();
+
+		gauge(gauge&&) = delete;
+		gauge(const gauge&) = delete;
+		gauge& operator=(gauge&&) = delete;
+		gauge& operator=(const gauge&) = delete;
+
+		void set(const int64_t value)
+		{
+			this->value_.store(value, std::memory_order_relaxed);
+		}
+
+		void add(const int64_t value)
+		{
+			this->value_.fetch_add(value, std::memory_order_relaxed);
+		}
+
+		int64_t get() const;
+		const std::string& get_name() const;
+
+	private:
+		std::string name_{};
+		std::atomic<int64_t> value_{0};
+	};
+
+	struct histogram_snapshot
+	{
+		uint64_t count{};
+		uint64_t sum{};
+		uint64_t max{};
+		uint64_t p50{};
+		uint64_t p90{};
+		uint64_t p99{};
+		uint64_t p999{};
+
+		static constexpr auto fields = std::make_tuple(json::make_field("count", &histogram_snapshot::count),
+		                                               json::make_field("sum", &histogram_snapshot::sum),
+		                                               json::make_field("max", &histogram_snapshot::max),
+		                                               json::make_field("p50", &histogram_snapshot::p50),
+		                                               json::make_field("p90", &histogram_snapshot::p90),
+		                                               json::make_field("p99", &histogram_snapshot::p99),
+		                                               json::make_field("p999", &histogram_snapshot::p999));
+	};
+
+	struct snapshot;
+
+	// Log-linear buckets like HdrHistogram. Values keep their five leading bits, so percentiles are
+	// off by less than 1/16, at any magnitude
+	class histogram
+	{
+	public:
+		explicit histogram(std::string name);
+		~histogram();
+
+		histogram(histogram&&) = delete;
+		histogram(const histogram&) = delete;
+		histogram& operator=(histogram&&) = delete;
+		histogram& operator=(const histogram&) = delete;
+
+		void record(uint64_t value);
+
+		histogram_snapshot get_snapshot() const;
+		const std::string& get_name() const;
+
+	private:
+		static constexpr size_t sub_bucket_bits = 4;
+		static constexpr size_t sub_bucket_count = 1ull << sub_bucket_bits;
+		static constexpr size_t bucket_count = (64 - sub_bucket_bits + 1) * sub_bucket_count;
+
+		std::string name_{};
+		std::array<std::atomic<uint64_t>, bucket_count> buckets_{};
+		std::atomic<uint64_t> sum_{0};
+		std::atomic<uint64_t> max_{0};
+
+		friend snapshot get_snapshot();
+
+		// Bucket counts add up, so histograms sharing a name are merged before percentiles are taken
+		struct totals
+		{
+			std::array<uint64_t, bucket_count> buckets{};
+			uint64_t sum{};
+			uint64_t max{};
+		};
+
+		void add_to(totals& totals) const;
+		static histogram_snapshot summarize(const totals& totals);
+
+		static size_t get_bucket(uint64_t value);
+		static uint64_t get_bucket_value(size_t bucket);
+	};
+
+	struct snapshot
+	{
+		std::map<std::string, uint64_t> counters{};
+		std::map<std::string, int64_t> gauges{};
+		std::map<std::string, histogram_snapshot> histograms{};
+
+		static constexpr auto fields = std::make_tuple(json::make_field("counters", &snapshot::counters),
+		                                               json::make_field("gauges", &snapshot::gauges),
+		                                               json::make_field("histograms", &snapshot::histograms));
+	};
+
+	snapshot get_snapshot();
+	bool save(const std::filesystem::path& file);
+}
@@ -0,0 +1,565 @@
+#include "mime_type.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+
+namespace utils::mime_type
+{
+	namespace
+	{
+		constexpr entry mime_types[] =
+		{
+			{"*3gpp", "audio/3gpp"},
+			{"*jpm", "video/jpm"},
+			{"*mp3", "audio/mp3"},
+			{"*rtf", "text/rtf"},
+			{"*wav", "audio/wave"},
+			{"*xml", "text/xml"},
+			{"3g2", "video/3gpp2"},
+			{"3gp", "video/3gpp"},
+			{"3gpp", "video/3gpp"},
+			{"ac", "application/pkix-attr-cert"},
+			{"adp", "audio/adpcm"},
+			{"ai", "application/postscript"},
+			{"apng", "image/apng"},
+			{"appcache", "text/cache-manifest"},
+			{"asc", "application/pgp-signature"},
+			{"atom", "application/atom+xml"},
+			{"atomcat", "application/atomcat+xml"},
+			{"atomsvc", "application/atomsvc+xml"},
+			{"au", "audio/basic"},
+			{"aw", "application/applixware"},
+			{"bdoc", "application/bdoc"},
+			{"bin", "application/octet-stream"},
+			{"bmp", "image/bmp"},
+			{"bpk", "application/octet-stream"},
+			{"buffer", "application/octet-stream"},
+			{"ccxml", "application/ccxml+xml"},
+			{"cdmia", "application/cdmi-capability"},
+			{"cdmic", "application/cdmi-container"},
+			{"cdmid", "application/cdmi-domain"},
+			{"cdmio", "application/cdmi-object"},
+			{"cdmiq", "application/cdmi-queue"},
+			{"cer", "application/pkix-cert"},
+			{"cgm", "image/cgm"},
+			{"class", "application/java-vm"},
+			{"coffee", "text/coffeescript"},
+			{"conf", "text/plain"},
+			{"cpt", "application/mac-compactpro"},
+			{"crl", "application/pkix-crl"},
+			{"css", "text/css"},
+			{"csv", "text/csv"},
+			{"cu", "application/cu-seeme"},
+			{"davmount", "application/davmount+xml"},
+			{"dbk", "application/docbook+xml"},
+			{"deb", "application/octet-stream"},
+			{"def", "text/plain"},
+			{"deploy", "application/octet-stream"},
+			{"disposition-notification", "message/disposition-notification"},
+			{"dist", "application/octet-stream"},
+			{"distz", "application/octet-stream"},
+			{"dll", "application/octet-stream"},
+			{"dmg", "application/octet-stream"},
+			{"dms", "application/octet-stream"},
+			{"doc", "application/msword"},
+			{"dot", "application/msword"},
+			{"drle", "image/dicom-rle"},
+			{"dssc", "application/dssc+der"},
+			{"dtd", "application/xml-dtd"},
+			{"dump", "application/octet-stream"},
+			{"ear", "application/java-archive"},
+			{"ecma", "application/ecmascript"},
+			{"elc", "application/octet-stream"},
+			{"emf", "image/emf"},
+			{"eml", "message/rfc822"},
+			{"emma", "application/emma+xml"},
+			{"eps", "application/postscript"},
+			{"epub", "application/epub+zip"},
+			{"es", "application/ecmascript"},
+			{"exe", "application/octet-stream"},
+			{"exi", "application/exi"},
+			{"exr", "image/aces"},
+			{"ez", "application/andrew-inset"},
+			{"fits", "image/fits"},
+			{"g3", "image/g3fax"},
+			{"gbr", "application/rpki-ghostbusters"},
+			{"geojson", "application/geo+json"},
+			{"gif", "image/gif"},
+			{"glb", "model/gltf-binary"},
+			{"gltf", "model/gltf+json"},
+			{"gml", "application/gml+xml"},
+			{"gpx", "application/gpx+xml"},
+			{"gram", "application/srgs"},
+			{"grxml", "application/srgs+xml"},
+			{"gxf", "application/gxf"},
+			{"gz", "application/gzip"},
+			{"h261", "video/h261"},
+			{"h263", "video/h263"},
+			{"h264", "video/h264"},
+			{"heic", "image/heic"},
+			{"heics", "image/heic-sequence"},
+			{"heif", "image/heif"},
+			{"heifs", "image/heif-sequence"},
+			{"hjson", "application/hjson"},
+			{"hlp", "application/winhlp"},
+			{"hqx", "application/mac-binhex40"},
+			{"htm", "text/html"},
+			{"html", "text/html"},
+			{"ics", "text/calendar"},
+			{"ief", "image/ief"},
+			{"ifb", "text/calendar"},
+			{"iges", "model/iges"},
+			{"igs", "model/iges"},
+			{"img", "application/octet-stream"},
+			{"in", "text/plain"},
+			{"ini", "text/plain"},
+			{"ink", "application/inkml+xml"},
+			{"inkml", "application/inkml+xml"},
+			{"ipfix", "application/ipfix"},
+			{"iso", "application/octet-stream"},
+			{"jade", "text/jade"},
+			{"jar", "application/java-archive"},
+			{"jls", "image/jls"},
+			{"jp2", "image/jp2"},
+			{"jpe", "image/jpeg"},
+			{"jpeg", "image/jpeg"},
+			{"jpf", "image/jpx"},
+			{"jpg", "image/jpeg"},
+			{"jpg2", "image/jp2"},
+			{"jpgm", "video/jpm"},
+			{"jpgv", "video/jpeg"},
+			{"jpm", "image/jpm"},
+			{"jpx", "image/jpx"},
+			{"js", "application/javascript"},
+			//{ "json", "application/json" },
+			{"json5", "application/json5"},
+			{"jsonld", "application/ld+json"},
+			{"jsonml", "application/jsonml+json"},
+			{"jsx", "text/jsx"},
+			{"kar", "audio/midi"},
+			{"ktx", "image/ktx"},
+			{"less", "text/less"},
+			{"list", "text/plain"},
+			{"litcoffee", "text/coffeescript"},
+			{"log", "text/plain"},
+			{"lostxml", "application/lost+xml"},
+			{"lrf", "application/octet-stream"},
+			{"m1v", "video/mpeg"},
+			{"m21", "application/mp21"},
+			{"m2a", "audio/mpeg"},
+			{"m2v", "video/mpeg"},
+			{"m3a", "audio/mpeg"},
+			{"m4a", "audio/mp4"},
+			{"m4p", "application/mp4"},
+			{"ma", "application/mathematica"},
+			{"mads", "application/mads+xml"},
+			{"man", "text/troff"},
+			{"manifest", "text/cache-manifest"},
+			{"map", "application/json"},
+			{"mar", "application/octet-stream"},
+			{"markdown", "text/markdown"},
+			{"mathml", "application/mathml+xml"},
+			{"mb", "application/mathematica"},
+			{"mbox", "application/mbox"},
+			{"md", "text/markdown"},
+			{"me", "text/troff"},
+			{"mesh", "model/mesh"},
+			{"meta4", "application/metalink4+xml"},
+			{"metalink", "application/metalink+xml"},
+			{"mets", "application/mets+xml"},
+			{"mft", "application/rpki-manifest"},
+			{"mid", "audio/midi"},
+			{"midi", "audio/midi"},
+			{"mime", "message/rfc822"},
+			{"mj2", "video/mj2"},
+			{"mjp2", "video/mj2"},
+			{"mjs", "application/javascript"},
+			{"mml", "text/mathml"},
+			{"mods", "application/mods+xml"},
+			{"mov", "video/quicktime"},
+			{"mp2", "audio/mpeg"},
+			{"mp21", "application/mp21"},
+			{"mp2a", "audio/mpeg"},
+			{"mp3", "audio/mpeg"},
+			{"mp4", "video/mp4"},
+			{"mp4a", "audio/mp4"},
+			{"mp4s", "application/mp4"},
+			{"mp4v", "video/mp4"},
+			{"mpd", "application/dash+xml"},
+			{"mpe", "video/mpeg"},
+			{"mpeg", "video/mpeg"},
+			{"mpg", "video/mpeg"},
+			{"mpg4", "video/mp4"},
+			{"mpga", "audio/mpeg"},
+			{"mrc", "application/marc"},
+			{"mrcx", "application/marcxml+xml"},
+			{"ms", "text/troff"},
+			{"mscml", "application/mediaservercontrol+xml"},
+			{"msh", "model/mesh"},
+			{"msi", "application/octet-stream"},
+			{"msm", "application/octet-stream"},
+			{"msp", "application/octet-stream"},
+			{"mxf", "application/mxf"},
+			{"mxml", "application/xv+xml"},
+			{"n3", "text/n3"},
+			{"nb", "application/mathematica"},
+			{"oda", "application/oda"},
+			{"oga", "audio/ogg"},
+			{"ogg", "audio/ogg"},
+			{"ogv", "video/ogg"},
+			{"ogx", "application/ogg"},
+			{"omdoc", "application/omdoc+xml"},
+			{"onepkg", "application/onenote"},
+			{"onetmp", "application/onenote"},
+			{"onetoc", "application/onenote"},
+			{"onetoc2", "application/onenote"},
+			{"opf", "application/oebps-package+xml"},
+			{"otf", "font/otf"},
+			{"owl", "application/rdf+xml"},
+			{"oxps", "application/oxps"},
+			{"p10", "application/pkcs10"},
+			{"p7c", "application/pkcs7-mime"},
+			{"p7m", "application/pkcs7-mime"},
+			{"p7s", "application/pkcs7-signature"},
+			{"p8", "application/pkcs8"},
+			{"pdf", "application/pdf"},
+			{"pfr", "application/font-tdpfr"},
+			{"pgp", "application/pgp-encrypted"},
+			{"pkg", "application/octet-stream"},
+			{"pki", "application/pkixcmp"},
+			{"pkipath", "application/pkix-pkipath"},
+			{"pls", "application/pls+xml"},
+			{"png", "image/png"},
+			{"prf", "application/pics-rules"},
+			{"ps", "application/postscript"},
+			{"pskcxml", "application/pskc+xml"},
+			{"qt", "video/quicktime"},
+			{"raml", "application/raml+yaml"},
+			{"rdf", "application/rdf+xml"},
+			{"rif", "application/reginfo+xml"},
+			{"rl", "application/resource-lists+xml"},
+			{"rld", "application/resource-lists-diff+xml"},
+			{"rmi", "audio/midi"},
+			{"rnc", "application/relax-ng-compact-syntax"},
+			{"rng", "application/xml"},
+			{"roa", "application/rpki-roa"},
+			{"roff", "text/troff"},
+			{"rq", "application/sparql-query"},
+			{"rs", "application/rls-services+xml"},
+			{"rsd", "application/rsd+xml"},
+			{"rss", "application/rss+xml"},
+			{"rtf", "application/rtf"},
+			{"rtx", "text/richtext"},
+			{"s3m", "audio/s3m"},
+			{"sbml", "application/sbml+xml"},
+			{"scq", "application/scvp-cv-request"},
+			{"scs", "application/scvp-cv-response"},
+			{"sdp", "application/sdp"},
+			{"ser", "application/java-serialized-object"},
+			{"setpay", "application/set-payment-initiation"},
+			{"setreg", "application/set-registration-initiation"},
+			{"sgi", "image/sgi"},
+			{"sgm", "text/sgml"},
+			{"sgml", "text/sgml"},
+			{"shex", "text/shex"},
+			{"shf", "application/shf+xml"},
+			{"shtml", "text/html"},
+			{"sig", "application/pgp-signature"},
+			{"sil", "audio/silk"},
+			{"silo", "model/mesh"},
+			{"slim", "text/slim"},
+			{"slm", "text/slim"},
+			{"smi", "application/smil+xml"},
+			{"smil", "application/smil+xml"},
+			{"snd", "audio/basic"},
+			{"so", "application/octet-stream"},
+			{"spp", "application/scvp-vp-response"},
+			{"spq", "application/scvp-vp-request"},
+			{"spx", "audio/ogg"},
+			{"sru", "application/sru+xml"},
+			{"srx", "application/sparql-results+xml"},
+			{"ssdl", "application/ssdl+xml"},
+			{"ssml", "application/ssml+xml"},
+			{"stk", "application/hyperstudio"},
+			{"styl", "text/stylus"},
+			{"stylus", "text/stylus"},
+			{"svg", "image/svg+xml"},
+			{"svgz", "image/svg+xml"},
+			{"t", "text/troff"},
+			{"t38", "image/t38"},
+			{"tei", "application/tei+xml"},
+			{"teicorpus", "application/tei+xml"},
+			{"text", "text/plain"},
+			{"tfi", "application/thraud+xml"},
+			{"tfx", "image/tiff-fx"},
+			{"tif", "image/tiff"},
+			{"tiff", "image/tiff"},
+			{"tr", "text/troff"},
+			{"ts", "video/mp2t"},
+			{"tsd", "application/timestamped-data"},
+			{"tsv", "text/tab-separated-values"},
+			{"ttc", "font/collection"},
+			{"ttf", "font/ttf"},
+			{"ttl", "text/turtle"},
+			{"txt", "text/plain"},
+			{"u8dsn", "message/global-delivery-status"},
+			{"u8hdr", "message/global-headers"},
+			{"u8mdn", "message/global-disposition-notification"},
+			{"u8msg", "message/global"},
+			{"uri", "text/uri-list"},
+			{"uris", "text/uri-list"},
+			{"urls", "text/uri-list"},
+			{"vcard", "text/vcard"},
+			{"vrml", "model/vrml"},
+			{"vtt", "text/vtt"},
+			{"vxml", "application/voicexml+xml"},
+			{"war", "application/java-archive"},
+			{"wasm", "application/wasm"},
+			{"wav", "audio/wav"},
+			{"weba", "audio/webm"},
+			{"webm", "video/webm"},
+			{"webmanifest", "application/manifest+json"},
+			{"webp", "image/webp"},
+			{"wgt", "application/widget"},
+			{"wmf", "image/wmf"},
+			{"woff", "font/woff"},
+			{"woff2", "font/woff2"},
+			{"wrl", "model/vrml"},
+			{"wsdl", "application/wsdl+xml"},
+			{"wspolicy", "application/wspolicy+xml"},
+			{"x3d", "model/x3d+xml"},
+			{"x3db", "model/x3d+binary"},
+			{"x3dbz", "model/x3d+binary"},
+			{"x3dv", "model/x3d+vrml"},
+			{"x3dvz", "model/x3d+vrml"},
+			{"x3dz", "model/x3d+xml"},
+			{"xaml", "application/xaml+xml"},
+			{"xdf", "application/xcap-diff+xml"},
+			{"xdssc", "application/dssc+xml"},
+			{"xenc", "application/xenc+xml"},
+			{"xer", "application/patch-ops-error+xml"},
+			{"xht", "application/xhtml+xml"},
+			{"xhtml", "application/xhtml+xml"},
+			{"xhvml", "application/xv+xml"},
+			{"xm", "audio/xm"},
+			{"xml", "application/xml"},
+			{"xop", "application/xop+xml"},
+			{"xpl", "application/xproc+xml"},
+			{"xsd", "application/xml"},
+			{"xsl", "application/xml"},
+			{"xslt", "application/xslt+xml"},
+			{"xspf", "application/xspf+xml"},
+			{"xvm", "application/xv+xml"},
+			{"xvml", "application/xv+xml"},
+			{"yaml", "text/yaml"},
+			{"yang", "application/yang"},
+			{"yin", "application/yin+xml"},
+			{"yml", "text/yaml"},
+			{"zip", "application/zip"},
+		};
+
+		constexpr char to_lower(const char c)
+		{
+			return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+		}
+
+		constexpr uint64_t hash_extension(const std::string_view extension, const uint64_t seed)
+		{
+			auto hash = 0xCBF29CE484222325ull ^ (seed * 0x9E3779B97F4A7C15ull);
+			for (const auto c : extension)
+			{
+				hash ^= static_cast<uint8_t>(to_lower(c));
+				hash *= 0x100000001B3ull;
+			}
+
+			return hash ^ (hash >> 32);
+		}
+
+		constexpr bool equals_extension(const std::string_view key, const std::string_view extension)
+		{
+			if (key.size() != extension.size())
+			{
+				return false;
+			}
+
+			for (size_t i = 0; i < key.size(); ++i)
+			{
+				if (key[i] != to_lower(extension[i]))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// Perfect hash table built with hash and displace. A first hash distributes the keys into buckets,
+		// then each bucket, largest first, is assigned the first seed that moves all of its keys into free slots
+		template <size_t Size>
+		class mime_type_table
+		{
+		public:
+			static constexpr size_t bucket_count = Size / 4 + 1;
+			static constexpr size_t slot_count = std::bit_ceil(Size + Size / 4);
+			static constexpr size_t max_bucket_size = 16;
+
+			constexpr explicit mime_type_table(const entry (&entries)[Size])
+			{
+				std::array<size_t, bucket_count + 1> bucket_offsets{};
+				for (const auto& entry : entries)
+				{
+					++bucket_offsets[get_bucket(entry.first) + 1];
+				}
+
+				size_t largest_bucket = 0;
+				for (size_t bucket = 0; bucket < bucket_count; ++bucket)
+				{
+					largest_bucket = std::max(largest_bucket, bucket_offsets[bucket + 1]);
+					bucket_offsets[bucket + 1] += bucket_offsets[bucket];
+				}
+
+				if (largest_bucket > max_bucket_size)
+				{
+					throw std::logic_error("MIME type bucket is too large");
+				}
+
+				std::array<size_t, Size> bucket_entries{};
+				std::array<size_t, bucket_count> bucket_fill{};
+				for (size_t i = 0; i < Size; ++i)
+				{
+					const auto bucket = get_bucket(entries[i].first);
+					bucket_entries[bucket_offsets[bucket] + bucket_fill[bucket]++] = i;
+				}
+
+				for (auto size = largest_bucket; size > 0; --size)
+				{
+					for (size_t bucket = 0; bucket < bucket_count; ++bucket)
+					{
+						if (bucket_offsets[bucket + 1] - bucket_offsets[bucket] != size)
+						{
+							continue;
+						}
+
+						const auto* indices = bucket_entries.data() + bucket_offsets[bucket];
+						this->seeds_[bucket] = this->place_bucket(entries, indices, size);
+					}
+				}
+			}
+
+			constexpr std::string_view find(const std::string_view extension) const
+			{
+				const auto& slot = this->slots_[get_slot(extension, this->seeds_[get_bucket(extension)])];
+				if (slot.first.empty() || !equals_extension(slot.first, extension))
+				{
+					return {};
+				}
+
+				return slot.second;
+			}
+
+			constexpr bool verify(const entry (&entries)[Size]) const
+			{
+				for (const auto& entry : entries)
+				{
+					std::array<char, 32> upper_case{};
+					if (entry.first.size() > upper_case.size())
+					{
+						return false;
+					}
+
+					for (size_t i = 0; i < entry.first.size(); ++i)
+					{
+						const auto c = entry.first[i];
+						upper_case[i] = c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+					}
+
+					if (this->find(entry.first) != entry.second ||
+						this->find({upper_case.data(), entry.first.size()}) != entry.second)
+					{
+						return false;
+					}
+				}
+
+				return true;
+			}
+
+		private:
+			std::array<uint32_t, bucket_count> seeds_{};
+			std::array<entry, slot_count> slots_{};
+
+			static constexpr size_t get_bucket(const std::string_view extension)
+			{
+				return hash_extension(extension, 0) % bucket_count;
+			}
+
+			static constexpr size_t get_slot(const std::string_view extension, const uint32_t seed)
+			{
+				return hash_extension(extension, seed) & (slot_count - 1);
+			}
+
+			constexpr uint32_t place_bucket(const entry (&entries)[Size], const size_t* indices,
+			                                const size_t size)
+			{
+				for (uint32_t seed = 1; seed < 0x10000; ++seed)
+				{
+					std::array<size_t, max_bucket_size> slots{};
+					auto placed = true;
+
+					for (size_t i = 0; i < size && placed; ++i)
+					{
+						slots[i] = get_slot(entries[indices[i]].first, seed);
+						placed = this->slots_[slots[i]].first.empty();
+
+						for (size_t j = 0; j < i && placed; ++j)
+						{
+							placed = slots[j] != slots[i];
+						}
+					}
+
+					if (!placed)
+					{
+						continue;
+					}
+
+					for (size_t i = 0; i < size; ++i)
+					{
+						this->slots_[slots[i]] = entries[indices[i]];
+					}
+
+					return seed;
+				}
+
+				throw std::logic_error("No seed found for MIME type bucket");
+			}
+		};
+
+		constexpr mime_type_table mime_type_map{mime_types};
+		static_assert(mime_type_map.verify(mime_types), "MIME type table does not resolve every extension");
+	}
+
+	std::span<const entry> get_entries()
+	{
+		return mime_types;
+	}
+
+	std::string_view get(const std::string_view path)
+	{
+		const auto file_name = path.substr(path.find_last_of("/\\") + 1);
+		const auto extension = file_name.find_last_of('.');
+
+		// Names like .htaccess have no extension
+		if (extension != std::string_view::npos && extension != 0)
+		{
+			const auto mime_type = mime_type_map.find(file_name.substr(extension + 1));
+			if (!mime_type.empty())
+			{
+				return mime_type;
+			}
+		}
+
+		return "application/octet-stream";
+	}
+}
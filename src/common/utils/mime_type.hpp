@@ -0,0 +1,17 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace utils::mime_type
+{
+	// Extension without the dot in lower case, and its MIME type
+	using entry = std::pair<std::string_view, std::string_view>;
+
+	std::span<const entry> get_entries();
+
+	// Looks up the extension of the path's file name, ignoring case.
+	// Returns application/octet-stream for unknown extensions and names without one
+	std::string_view get(std::string_view path);
+}
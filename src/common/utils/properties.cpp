@@ -6,20 +6,120 @@
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/stringbuffer.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <thread>
+
 #include "io.hpp"
 #include "com.hpp"
+#include "events.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
 #include "string.hpp"
+#include "record_log.hpp"
+#include "shared_snapshot.hpp"
+#include "exit_callback.hpp"
 
 namespace utils::properties
 {
 	namespace
 	{
+		// Stores within this window end up in a single write
+		constexpr auto write_delay = std::chrono::milliseconds(250);
+
+		constexpr size_t snapshot_capacity = 256 * 1024;
+
+		metrics::counter cache_hits{"properties.cache_hits"};
+		metrics::counter snapshot_hits{"properties.snapshot_hits"};
+		metrics::counter reloads{"properties.reloads"};
+
+		std::filesystem::path appdata_override{};
+
+		struct file_identity
+		{
+			uint32_t volume{};
+			uint64_t index{};
+			uint64_t size{};
+			uint64_t write_time{};
+
+			bool operator==(const file_identity&) const = default;
+		};
+
+		struct properties_cache
+		{
+			std::mutex mutex{};
+			std::condition_variable condition_variable{};
+
+			bool loaded{false};
+			std::optional<file_identity> identity{};
+			rapidjson::Document doc{};
+
+			std::map<std::string, std::string> pending{};
+			std::chrono::steady_clock::time_point flush_time{};
+
+			// Makes pending values durable until they are part of the properties file
+			std::unique_ptr<record_log> log{};
+
+			// Version of the last snapshot this process published
+			std::atomic<uint64_t> published_version{0};
+
+			std::thread writer{};
+			bool stopping{false};
+		};
+
+		properties_cache& get_cache()
+		{
+			// Never destroyed, as the writer is only stopped by an exit callback
+			static auto* cache = new properties_cache();
+			return *cache;
+		}
+
 		std::filesystem::path get_properties_file()
 		{
 			static auto props = get_appdata_path() / "user" / "properties.json";
 			return props;
 		}
 
+		std::filesystem::path get_properties_log()
+		{
+			static auto log = get_appdata_path() / "user" / "properties.log";
+			return log;
+		}
+
+		// Identifies the file and its version without reading it, which is enough to tell
+		// whether another process replaced or modified it since it was loaded
+		std::optional<file_identity> get_file_identity(const std::filesystem::path& file)
+		{
+			auto* const handle = CreateFileW(file.c_str(), FILE_READ_ATTRIBUTES,
+			                                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+			                                 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (handle == INVALID_HANDLE_VALUE)
+			{
+				return {};
+			}
+
+			const auto _ = finally([handle]
+			{
+				CloseHandle(handle);
+			});
+
+			BY_HANDLE_FILE_INFORMATION info{};
+			if (!GetFileInformationByHandle(handle, &info))
+			{
+				return {};
+			}
+
+			file_identity identity{};
+			identity.volume = info.dwVolumeSerialNumber;
+			identity.index = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+			identity.size = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+			identity.write_time = (static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32) | info.
+				ftLastWriteTime.dwLowDateTime;
+
+			return {identity};
+		}
+
 		rapidjson::Document load_properties()
 		{
 			rapidjson::Document default_doc{};
@@ -43,7 +143,7 @@ namespace utils::properties
 			return doc;
 		}
 
-		void store_properties(const rapidjson::Document& doc)
+		bool store_properties(const rapidjson::Document& doc)
 		{
 			rapidjson::StringBuffer buffer{};
 			rapidjson::Writer<rapidjson::StringBuffer, rapidjson::Document::EncodingType, rapidjson::ASCII<>>
@@ -53,12 +153,287 @@ namespace utils::properties
 			const std::string json{ buffer.GetString(), buffer.GetLength() };
 
 			const auto& props = get_properties_file();
-			io::write_file(props.string(), json);
+			return io::replace_file(props.string(), json);
+		}
+
+		void set_property(rapidjson::Document& doc, const std::string& name, const std::string& value)
+		{
+			while (doc.HasMember(name))
+			{
+				doc.RemoveMember(name);
+			}
+
+			rapidjson::Value key{};
+			key.SetString(name, doc.GetAllocator());
+
+			rapidjson::Value entry{};
+			entry.SetString(value, doc.GetAllocator());
+
+			doc.AddMember(key, entry, doc.GetAllocator());
+		}
+
+		bool is_current(const properties_cache& cache)
+		{
+			return cache.loaded && cache.identity == get_file_identity(get_properties_file());
+		}
+
+		// Shared by all processes, so they can read properties without taking the lock or parsing the file
+		shared_snapshot* get_snapshot()
+		{
+			static auto* snapshot = []() -> shared_snapshot*
+			{
+				try
+				{
+					return new shared_snapshot("xlabs-properties-snapshot", snapshot_capacity);
+				}
+				catch (const std::exception& e)
+				{
+					logger::error("Failed to open properties snapshot: {}", e.what());
+					return nullptr;
+				}
+			}();
+
+			return snapshot;
+		}
+
+		// The snapshot starts with the identity of the file it reflects, followed by
+		// the key and value sizes and data of every property
+		void append_uint32(std::string& data, const uint32_t value)
+		{
+			data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+
+		uint32_t read_uint32(const std::string_view data, const size_t offset)
+		{
+			uint32_t value{};
+			std::memcpy(&value, data.data() + offset, sizeof(value));
+			return value;
+		}
+
+		// Requires the properties lock, which serializes writers across processes
+		void publish_snapshot(const properties_cache& cache)
+		{
+			auto* const snapshot = get_snapshot();
+			if (!snapshot)
+			{
+				return;
+			}
+
+			file_identity identity{};
+			if (cache.identity)
+			{
+				identity = *cache.identity;
+			}
+
+			std::string data{};
+			append_uint32(data, cache.identity ? 1 : 0);
+			data.append(reinterpret_cast<const char*>(&identity), sizeof(identity));
+
+			for (const auto& member : cache.doc.GetObject())
+			{
+				if (member.value.IsString())
+				{
+					append_uint32(data, member.name.GetStringLength());
+					append_uint32(data, member.value.GetStringLength());
+					data.append(member.name.GetString(), member.name.GetStringLength());
+					data.append(member.value.GetString(), member.value.GetStringLength());
+				}
+			}
+
+			// An empty snapshot is never used, so readers fall back to the file
+			if (!snapshot->publish(data))
+			{
+				snapshot->publish({});
+			}
+
+			get_cache().published_version = snapshot->get_version();
+		}
+
+		// Returns false if the snapshot does not reflect the current file
+		bool find_in_snapshot(const std::string& name, std::optional<std::string>& value)
+		{
+			const auto* const snapshot = get_snapshot();
+			if (!snapshot)
+			{
+				return false;
+			}
+
+			// Only a snapshot published by another launcher can be newer than the cache. In the usual single
+			// launcher this skips the copy, the snapshot serves the overlap when the launcher relaunches itself
+			if (snapshot->get_version() == get_cache().published_version)
+			{
+				return false;
+			}
+
+			thread_local std::string buffer{};
+			if (!snapshot->read(buffer))
+			{
+				return false;
+			}
+
+			const std::string_view data{buffer};
+			constexpr auto header_size = sizeof(uint32_t) + sizeof(file_identity);
+			if (data.size() < header_size)
+			{
+				return false;
+			}
+
+			std::optional<file_identity> identity{};
+			if (read_uint32(data, 0))
+			{
+				std::memcpy(&identity.emplace(), data.data() + sizeof(uint32_t), sizeof(file_identity));
+			}
+
+			if (identity != get_file_identity(get_properties_file()))
+			{
+				return false;
+			}
+
+			value.reset();
+
+			size_t offset = header_size;
+			while (data.size() - offset >= sizeof(uint32_t) * 2)
+			{
+				const auto key_size = read_uint32(data, offset);
+				const auto value_size = read_uint32(data, offset + sizeof(uint32_t));
+				offset += sizeof(uint32_t) * 2;
+
+				if (data.size() - offset < static_cast<uint64_t>(key_size) + value_size)
+				{
+					return false;
+				}
+
+				if (data.substr(offset, key_size) == name)
+				{
+					value.emplace(data.substr(offset + key_size, value_size));
+					return true;
+				}
+
+				offset += key_size + value_size;
+			}
+
+			return true;
+		}
+
+		void run_writer()
+		{
+			auto& cache = get_cache();
+			std::unique_lock<std::mutex> lock{cache.mutex};
+
+			while (true)
+			{
+				cache.condition_variable.wait(lock, [&cache]
+				{
+					return cache.stopping || !cache.pending.empty();
+				});
+
+				if (cache.stopping)
+				{
+					break;
+				}
+
+				cache.condition_variable.wait_until(lock, cache.flush_time, [&cache]
+				{
+					return cache.stopping;
+				});
+
+				// The properties lock has to be taken first
+				lock.unlock();
+				flush();
+				lock.lock();
+			}
+		}
+
+		void stop_writer()
+		{
+			auto& cache = get_cache();
+
+			{
+				std::lock_guard<std::mutex> _{cache.mutex};
+				cache.stopping = true;
+			}
+
+			cache.condition_variable.notify_all();
+
+			if (cache.writer.joinable())
+			{
+				cache.writer.join();
+			}
+
+			flush();
+		}
+
+		// Requires the cache lock
+		void schedule_write(properties_cache& cache)
+		{
+			if (!cache.stopping && !cache.writer.joinable())
+			{
+				cache.writer = std::thread(run_writer);
+				at_exit(stop_writer);
+			}
+
+			cache.condition_variable.notify_all();
+		}
+
+		// Requires the properties lock. A launcher that relaunched itself might still hold the log open
+		// while it exits, so opening is retried on every reload and store until it works
+		void open_log(properties_cache& cache)
+		{
+			if (cache.log)
+			{
+				return;
+			}
+
+			try
+			{
+				// Values stored before a crash that never made it into the properties file
+				cache.log = std::make_unique<record_log>(get_properties_log());
+				for (const auto& [name, value] : cache.log->get_entries())
+				{
+					if (cache.pending.try_emplace(name, value).second)
+					{
+						set_property(cache.doc, name, value);
+					}
+				}
+			}
+			catch (const std::exception& e)
+			{
+				logger::warn("Failed to open properties log, retrying with the next store: {}", e.what());
+			}
+		}
+
+		// Requires the properties lock. Values that are not written yet take precedence over the file
+		void reload(properties_cache& cache)
+		{
+			open_log(cache);
+
+			reloads.increment();
+
+			cache.identity = get_file_identity(get_properties_file());
+			cache.doc = load_properties();
+			cache.loaded = true;
+
+			for (const auto& [name, value] : cache.pending)
+			{
+				set_property(cache.doc, name, value);
+			}
+
+			publish_snapshot(cache);
+
+			if (!cache.pending.empty())
+			{
+				schedule_write(cache);
+			}
 		}
 	}
 
 	std::filesystem::path get_appdata_path()
 	{
+		if (!appdata_override.empty())
+		{
+			return appdata_override;
+		}
+
 		PWSTR path;
 		if (!SUCCEEDED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &path)))
 		{
@@ -74,6 +449,11 @@ namespace utils::properties
 		return appdata;
 	}
 
+	void set_appdata_path(std::filesystem::path path)
+	{
+		appdata_override = std::move(path);
+	}
+
 	std::unique_lock<named_mutex> lock()
 	{
 		static named_mutex mutex{"xlabs-properties-lock"};
@@ -83,41 +463,162 @@ namespace utils::properties
 
 	std::optional<std::string> load(const std::string& name)
 	{
-		const auto _ = lock();
-		const auto doc = load_properties();
+		auto& cache = get_cache();
+
+		const auto find_property = [&cache, &name]() -> std::optional<std::string>
+		{
+			const auto member = cache.doc.FindMember(name);
+			if (member == cache.doc.MemberEnd() || !member->value.IsString())
+			{
+				return {};
+			}
+
+			return { std::string{ member->value.GetString(), member->value.GetStringLength() } };
+		};
 
-		if (!doc.HasMember(name))
 		{
-			return {};
+			std::lock_guard<std::mutex> _{cache.mutex};
+			if (is_current(cache))
+			{
+				cache_hits.increment();
+				return find_property();
+			}
 		}
 
-		const auto& value = doc[name];
-		if (!value.IsString())
+		std::optional<std::string> value{};
+		if (find_in_snapshot(name, value))
 		{
-			return {};
+			snapshot_hits.increment();
+			return value;
 		}
 
-		return { std::string{ value.GetString() } };
+		const auto properties_lock = lock();
+		std::lock_guard<std::mutex> cache_lock{cache.mutex};
+
+		if (!is_current(cache))
+		{
+			reload(cache);
+		}
+
+		return find_property();
 	}
 
 	void store(const std::string& name, const std::string& value)
 	{
-		const auto _ = lock();
-		auto doc = load_properties();
+		store_many({{name, value}});
+	}
 
-		while (doc.HasMember(name))
+	void store_many(const std::map<std::string, std::string>& values)
+	{
+		if (values.empty())
 		{
-			doc.RemoveMember(name);
+			return;
 		}
 
-		rapidjson::Value key{};
-		key.SetString(name, doc.GetAllocator());
+		auto& cache = get_cache();
+		auto write_now = false;
 
-		rapidjson::Value member{};
-		member.SetString(value, doc.GetAllocator());
+		{
+			const auto properties_lock = lock();
+			std::lock_guard<std::mutex> cache_lock{cache.mutex};
 
-		doc.AddMember(key, member, doc.GetAllocator());
+			if (!is_current(cache))
+			{
+				reload(cache);
+			}
+			else
+			{
+				open_log(cache);
+			}
 
-		store_properties(doc);
+			if (cache.pending.empty())
+			{
+				cache.flush_time = std::chrono::steady_clock::now() + write_delay;
+			}
+
+			if (cache.log)
+			{
+				try
+				{
+					cache.log->append(values);
+				}
+				catch (const std::exception& e)
+				{
+					logger::error("Failed to log properties: {}", e.what());
+				}
+			}
+
+			for (const auto& [name, value] : values)
+			{
+				set_property(cache.doc, name, value);
+				cache.pending.insert_or_assign(name, value);
+			}
+
+			// Other processes see the values before they are written
+			publish_snapshot(cache);
+
+			// Stores made while exiting are written right away
+			write_now = cache.stopping;
+			schedule_write(cache);
+		}
+
+		if (write_now)
+		{
+			flush();
+		}
+
+		for (const auto& [name, value] : values)
+		{
+			rapidjson::Document event{};
+			event.SetObject();
+			event.AddMember("name", rapidjson::Value(name, event.GetAllocator()), event.GetAllocator());
+			event.AddMember("value", rapidjson::Value(value, event.GetAllocator()), event.GetAllocator());
+
+			events::publish("property", event, "property:" + name);
+		}
+	}
+
+	void flush()
+	{
+		auto& cache = get_cache();
+
+		const auto properties_lock = lock();
+		std::lock_guard<std::mutex> cache_lock{cache.mutex};
+
+		if (cache.pending.empty())
+		{
+			return;
+		}
+
+		// Keeps what other processes wrote in the meantime
+		if (!is_current(cache))
+		{
+			reload(cache);
+		}
+
+		if (!store_properties(cache.doc))
+		{
+			// Retried by the writer, the log keeps the values safe until then
+			cache.flush_time = std::chrono::steady_clock::now() + write_delay;
+			return;
+		}
+
+		cache.identity = get_file_identity(get_properties_file());
+		cache.pending.clear();
+
+		publish_snapshot(cache);
+
+		// Everything in the log is part of the properties file now
+		if (cache.log)
+		{
+			try
+			{
+				cache.log->clear();
+			}
+			catch (const std::exception& e)
+			{
+				logger::error("Failed to compact properties log: {}", e.what());
+			}
+		}
 	}
 }
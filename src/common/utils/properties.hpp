@@ -1,6 +1,7 @@
 #pragma once
 
 #include "named_mutex.hpp"
+#include <map>
 #include <mutex>
 #include <optional>
 #include <filesystem>
@@ -9,8 +10,19 @@ namespace utils::properties
 {
 	std::filesystem::path get_appdata_path();
 
+	// Replaces the %LOCALAPPDATA%\xlabs folder, e.g. so tests do not touch the user's properties.
+	// Has to be called before anything uses the path
+	void set_appdata_path(std::filesystem::path path);
+
 	std::unique_lock<named_mutex> lock();
 
 	std::optional<std::string> load(const std::string& name);
 	void store(const std::string& name, const std::string& value);
+
+	// Stored values are visible to load right away. Writes to disk are coalesced and happen shortly after,
+	// or at the latest when the process exits
+	void store_many(const std::map<std::string, std::string>& values);
+
+	// Writes pending values now, e.g. before starting a process that reads them
+	void flush();
 }
@@ -0,0 +1,260 @@
+#include "record_log.hpp"
+#include "cryptography.hpp"
+#include "nt.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace utils
+{
+	namespace
+	{
+		// Batches start with the size of their payload and its CRC32, followed by the payload.
+		// The payload is a sequence of records, each made of the key and value sizes and the data
+		constexpr size_t batch_header_size = sizeof(uint32_t) * 2;
+		constexpr size_t record_header_size = sizeof(uint32_t) * 2;
+
+		uint32_t read_uint32(const char* data)
+		{
+			uint32_t value{};
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		void append_uint32(std::string& data, const uint32_t value)
+		{
+			data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+
+		bool parse_batch(const std::string_view payload, record_log::entries& entries, size_t& record_count)
+		{
+			record_log::entries batch{};
+			size_t batch_records = 0;
+
+			size_t offset = 0;
+			while (offset < payload.size())
+			{
+				if (payload.size() - offset < record_header_size)
+				{
+					return false;
+				}
+
+				const auto key_size = read_uint32(payload.data() + offset);
+				const auto value_size = read_uint32(payload.data() + offset + sizeof(uint32_t));
+				offset += record_header_size;
+
+				if (payload.size() - offset < static_cast<uint64_t>(key_size) + value_size)
+				{
+					return false;
+				}
+
+				std::string key{payload.substr(offset, key_size)};
+				offset += key_size;
+
+				batch.insert_or_assign(std::move(key), std::string{payload.substr(offset, value_size)});
+				offset += value_size;
+
+				++batch_records;
+			}
+
+			// Batches are applied as a whole, never partially
+			for (auto& [key, value] : batch)
+			{
+				entries.insert_or_assign(key, std::move(value));
+			}
+
+			record_count += batch_records;
+			return true;
+		}
+	}
+
+	record_log::record_log(const std::filesystem::path& file)
+	{
+		std::error_code ec{};
+		std::filesystem::create_directories(file.parent_path(), ec);
+
+		this->file_ = CreateFileW(file.wstring().data(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+		                          OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (this->file_ == INVALID_HANDLE_VALUE)
+		{
+			this->file_ = nullptr;
+			throw std::runtime_error("Failed to open " + file.string());
+		}
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(this->file_, &size))
+		{
+			this->close();
+			throw std::runtime_error("Failed to get size of " + file.string());
+		}
+
+		std::string data{};
+		data.resize(static_cast<size_t>(size.QuadPart));
+
+		size_t offset = 0;
+		while (offset < data.size())
+		{
+			DWORD read = 0;
+			const auto length = static_cast<DWORD>(std::min(data.size() - offset, static_cast<size_t>(1) << 30));
+			if (!ReadFile(this->file_, data.data() + offset, length, &read, nullptr) || !read)
+			{
+				break;
+			}
+
+			offset += read;
+		}
+
+		data.resize(offset);
+
+		// Cuts off a torn batch, so new batches directly follow the last intact one
+		try
+		{
+			this->truncate(replay(data, this->entries_, this->record_count_));
+		}
+		catch (...)
+		{
+			this->close();
+			throw;
+		}
+	}
+
+	record_log::~record_log()
+	{
+		this->close();
+	}
+
+	const record_log::entries& record_log::get_entries() const
+	{
+		return this->entries_;
+	}
+
+	size_t record_log::get_dead_records() const
+	{
+		return this->record_count_ - this->entries_.size();
+	}
+
+	void record_log::append(const entries& values)
+	{
+		if (values.empty())
+		{
+			return;
+		}
+
+		const auto batch = serialize(values);
+
+		size_t offset = 0;
+		while (offset < batch.size())
+		{
+			DWORD written = 0;
+			if (!WriteFile(this->file_, batch.data() + offset, static_cast<DWORD>(batch.size() - offset), &written,
+			               nullptr) || !written)
+			{
+				// Never leave a partial batch in front of later ones
+				this->truncate(this->size_);
+				throw std::runtime_error("Failed to append to record log");
+			}
+
+			offset += written;
+		}
+
+		if (!FlushFileBuffers(this->file_))
+		{
+			this->truncate(this->size_);
+			throw std::runtime_error("Failed to flush record log");
+		}
+
+		this->size_ += batch.size();
+		this->record_count_ += values.size();
+
+		for (const auto& [key, value] : values)
+		{
+			this->entries_.insert_or_assign(key, value);
+		}
+	}
+
+	void record_log::clear()
+	{
+		this->truncate(0);
+		FlushFileBuffers(this->file_);
+
+		this->entries_.clear();
+		this->record_count_ = 0;
+	}
+
+	size_t record_log::replay(const std::string_view data, entries& entries, size_t& record_count)
+	{
+		size_t offset = 0;
+		while (data.size() - offset >= batch_header_size)
+		{
+			const auto payload_size = read_uint32(data.data() + offset);
+			const auto checksum = read_uint32(data.data() + offset + sizeof(uint32_t));
+
+			if (data.size() - offset - batch_header_size < payload_size)
+			{
+				break;
+			}
+
+			const auto payload = data.substr(offset + batch_header_size, payload_size);
+			if (cryptography::crc32::compute(reinterpret_cast<const uint8_t*>(payload.data()), payload.size())
+				!= checksum)
+			{
+				break;
+			}
+
+			if (!parse_batch(payload, entries, record_count))
+			{
+				break;
+			}
+
+			offset += batch_header_size + payload_size;
+		}
+
+		return offset;
+	}
+
+	std::string record_log::serialize(const entries& values)
+	{
+		std::string batch{};
+		batch.resize(batch_header_size);
+
+		for (const auto& [key, value] : values)
+		{
+			append_uint32(batch, static_cast<uint32_t>(key.size()));
+			append_uint32(batch, static_cast<uint32_t>(value.size()));
+			batch.append(key);
+			batch.append(value);
+		}
+
+		const auto payload_size = static_cast<uint32_t>(batch.size() - batch_header_size);
+		const auto checksum = cryptography::crc32::compute(
+			reinterpret_cast<const uint8_t*>(batch.data() + batch_header_size), payload_size);
+
+		std::memcpy(batch.data(), &payload_size, sizeof(payload_size));
+		std::memcpy(batch.data() + sizeof(uint32_t), &checksum, sizeof(checksum));
+
+		return batch;
+	}
+
+	void record_log::truncate(const uint64_t size)
+	{
+		LARGE_INTEGER position{};
+		position.QuadPart = static_cast<LONGLONG>(size);
+
+		if (!SetFilePointerEx(this->file_, position, nullptr, FILE_BEGIN) || !SetEndOfFile(this->file_))
+		{
+			throw std::runtime_error("Failed to truncate record log");
+		}
+
+		this->size_ = size;
+	}
+
+	void record_log::close()
+	{
+		if (this->file_)
+		{
+			CloseHandle(this->file_);
+			this->file_ = nullptr;
+		}
+	}
+}
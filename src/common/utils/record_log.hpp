@@ -0,0 +1,51 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace utils
+{
+	// Append-only log of key/value batches. Every batch is checksummed and written with a single write,
+	// so a batch torn by a crash or power loss is detected and cut off when the log is opened again
+	class record_log
+	{
+	public:
+		using entries = std::map<std::string, std::string>;
+
+		explicit record_log(const std::filesystem::path& file);
+		~record_log();
+
+		record_log(record_log&&) = delete;
+		record_log(const record_log&) = delete;
+		record_log& operator=(record_log&&) = delete;
+		record_log& operator=(const record_log&) = delete;
+
+		// Latest value of every key in the log
+		const entries& get_entries() const;
+
+		// Number of records that were overwritten by later ones
+		size_t get_dead_records() const;
+
+		// Returns once the batch reached the disk
+		void append(const entries& values);
+
+		// Drops all records, e.g. once they are part of a snapshot
+		void clear();
+
+		// Replays all intact batches and returns the size of the valid prefix
+		static size_t replay(std::string_view data, entries& entries, size_t& record_count);
+		static std::string serialize(const entries& values);
+
+	private:
+		void* file_{};
+		uint64_t size_{};
+
+		entries entries_{};
+		size_t record_count_{};
+
+		void truncate(uint64_t size);
+		void close();
+	};
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+namespace utils::concurrency
+{
+	// Bounded queue over a ring of slots that carry a sequence number each. The side that may have several
+	// threads claims positions with a CAS, a single producer or consumer only ever stores its position
+	template <typename T, bool MultiProducer, bool MultiConsumer>
+	class ring_queue
+	{
+	public:
+		static_assert(std::is_default_constructible_v<T> && std::is_move_assignable_v<T>);
+
+		// The capacity is rounded up to a power of two
+		explicit ring_queue(const size_t capacity)
+		{
+			size_t size = 2;
+			while (size < capacity)
+			{
+				size <<= 1;
+			}
+
+			this->mask_ = size - 1;
+			this->slots_ = std::make_unique<slot[]>(size);
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				this->slots_[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		ring_queue(ring_queue&&) = delete;
+		ring_queue(const ring_queue&) = delete;
+		ring_queue& operator=(ring_queue&&) = delete;
+		ring_queue& operator=(const ring_queue&) = delete;
+
+		// Returns false if the queue is full, the value is left untouched then
+		template <typename U>
+		bool try_push(U&& value)
+		{
+			auto position = this->tail_.load(std::memory_order_relaxed);
+			slot* target{};
+
+			while (true)
+			{
+				target = &this->slots_[position & this->mask_];
+				const auto sequence = target->sequence.load(std::memory_order_acquire);
+				const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+				if (difference < 0)
+				{
+					return false;
+				}
+
+				if (difference > 0)
+				{
+					position = this->tail_.load(std::memory_order_relaxed);
+				}
+				else if constexpr (MultiProducer)
+				{
+					if (this->tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else
+				{
+					this->tail_.store(position + 1, std::memory_order_relaxed);
+					break;
+				}
+			}
+
+			target->value = std::forward<U>(value);
+			target->sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		std::optional<T> try_pop()
+		{
+			auto position = this->head_.load(std::memory_order_relaxed);
+			slot* source{};
+
+			while (true)
+			{
+				source = &this->slots_[position & this->mask_];
+				const auto sequence = source->sequence.load(std::memory_order_acquire);
+				const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+				if (difference < 0)
+				{
+					return {};
+				}
+
+				if (difference > 0)
+				{
+					position = this->head_.load(std::memory_order_relaxed);
+				}
+				else if constexpr (MultiConsumer)
+				{
+					if (this->head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else
+				{
+					this->head_.store(position + 1, std::memory_order_relaxed);
+					break;
+				}
+			}
+
+			std::optional<T> value{std::move(source->value)};
+			source->sequence.store(position + this->mask_ + 1, std::memory_order_release);
+			return value;
+		}
+
+		size_t get_capacity() const
+		{
+			return this->mask_ + 1;
+		}
+
+	private:
+		static constexpr size_t cache_line_size = 64;
+
+		struct slot
+		{
+			std::atomic<size_t> sequence{};
+			T value{};
+		};
+
+		size_t mask_{};
+		std::unique_ptr<slot[]> slots_{};
+
+		// Producers and consumers write different lines
+		alignas(cache_line_size) std::atomic<size_t> tail_{0};
+		alignas(cache_line_size) std::atomic<size_t> head_{0};
+	};
+
+	template <typename T>
+	using mpsc_queue = ring_queue<T, true, false>;
+
+	template <typename T>
+	using spmc_queue = ring_queue<T, false, true>;
+
+	template <typename T>
+	using spsc_queue = ring_queue<T, false, false>;
+}
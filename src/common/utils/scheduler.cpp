@@ -0,0 +1,270 @@
+#include "scheduler.hpp"
+
+namespace utils::concurrency
+{
+	namespace
+	{
+		// Lets tasks posted from a worker go to that worker's own queue
+		thread_local scheduler* current_scheduler{};
+		thread_local size_t current_worker{};
+
+		// Waiting threads look for new tasks to help with at this interval
+		constexpr auto help_interval = std::chrono::milliseconds(1);
+
+		constexpr size_t io_thread_count = 8;
+	}
+
+	scheduler::scheduler(size_t thread_count)
+	{
+		if (!thread_count)
+		{
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		this->queues_.reserve(thread_count);
+		for (size_t i = 0; i < thread_count; ++i)
+		{
+			this->queues_.emplace_back(std::make_unique<task_queue>());
+		}
+
+		this->threads_.reserve(thread_count);
+		for (size_t i = 0; i < thread_count; ++i)
+		{
+			this->threads_.emplace_back([this, i]()
+			{
+				this->run_worker(i);
+			});
+		}
+	}
+
+	scheduler::~scheduler()
+	{
+		{
+			std::lock_guard<std::mutex> _{this->mutex_};
+			this->stopping_ = true;
+		}
+
+		this->condition_variable_.notify_all();
+
+		for (auto& thread : this->threads_)
+		{
+			if (thread.joinable())
+			{
+				thread.join();
+			}
+		}
+	}
+
+	size_t scheduler::get_thread_count() const
+	{
+		return this->threads_.size();
+	}
+
+	void scheduler::post(task task)
+	{
+		auto& queue = current_scheduler == this ? *this->queues_[current_worker] : this->global_queue_;
+
+		{
+			std::lock_guard<std::mutex> _{queue.mutex};
+			queue.tasks.emplace_back(std::move(task));
+		}
+
+		{
+			// Taking the lock makes sure a worker about to sleep sees the task
+			std::lock_guard<std::mutex> _{this->mutex_};
+			++this->queued_;
+		}
+
+		this->condition_variable_.notify_one();
+	}
+
+	bool scheduler::run_one()
+	{
+		task task{};
+		const auto index = current_scheduler == this ? current_worker : this->queues_.size();
+		if (!this->pop_task(task, index))
+		{
+			return false;
+		}
+
+		task();
+		return true;
+	}
+
+	bool scheduler::pop_task(task& task, const size_t index)
+	{
+		const auto take = [this, &task](task_queue& queue, const bool back)
+		{
+			std::lock_guard<std::mutex> _{queue.mutex};
+			if (queue.tasks.empty())
+			{
+				return false;
+			}
+
+			if (back)
+			{
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+			}
+			else
+			{
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+			}
+
+			--this->queued_;
+			return true;
+		};
+
+		if (index < this->queues_.size() && take(*this->queues_[index], true))
+		{
+			return true;
+		}
+
+		if (take(this->global_queue_, false))
+		{
+			return true;
+		}
+
+		const auto count = this->queues_.size();
+		for (size_t i = 1; i <= count; ++i)
+		{
+			const auto victim = (index + i) % count;
+			if (victim != index && take(*this->queues_[victim], false))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void scheduler::run_worker(const size_t index)
+	{
+		current_scheduler = this;
+		current_worker = index;
+
+		while (true)
+		{
+			task task{};
+			if (this->pop_task(task, index))
+			{
+				task();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock{this->mutex_};
+			this->condition_variable_.wait(lock, [this]()
+			{
+				return this->stopping_ || this->queued_ > 0;
+			});
+
+			// Queued tasks are still run when stopping
+			if (this->stopping_ && this->queued_ == 0)
+			{
+				break;
+			}
+		}
+	}
+
+	scheduler& get_scheduler()
+	{
+		static scheduler scheduler{};
+		return scheduler;
+	}
+
+	scheduler& get_io_scheduler()
+	{
+		static scheduler scheduler{io_thread_count};
+		return scheduler;
+	}
+
+	task_group::task_group(scheduler& scheduler)
+		: scheduler_(scheduler)
+	{
+	}
+
+	task_group::~task_group()
+	{
+		this->wait_for_tasks();
+	}
+
+	void task_group::run(std::function<void()> task)
+	{
+		++this->pending_;
+
+		this->scheduler_.post([this, task = std::move(task)]()
+		{
+			if (!this->cancelled_)
+			{
+				try
+				{
+					task();
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> _{this->mutex_};
+					if (!this->exception_)
+					{
+						this->exception_ = std::current_exception();
+					}
+
+					this->cancelled_ = true;
+				}
+			}
+
+			std::lock_guard<std::mutex> _{this->mutex_};
+			if (--this->pending_ == 0)
+			{
+				this->condition_variable_.notify_all();
+			}
+		});
+	}
+
+	void task_group::wait()
+	{
+		this->wait_for_tasks();
+
+		std::exception_ptr exception{};
+
+		{
+			std::lock_guard<std::mutex> _{this->mutex_};
+			std::swap(exception, this->exception_);
+		}
+
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+
+	void task_group::cancel()
+	{
+		this->cancelled_ = true;
+	}
+
+	bool task_group::is_cancelled() const
+	{
+		return this->cancelled_;
+	}
+
+	void task_group::wait_for_tasks()
+	{
+		while (this->pending_ > 0)
+		{
+			if (this->scheduler_.run_one())
+			{
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock{this->mutex_};
+			this->condition_variable_.wait_for(lock, help_interval, [this]()
+			{
+				return this->pending_ == 0;
+			});
+		}
+
+		// The last task notifies while holding the mutex, so the group must not go away before it released it
+		std::lock_guard<std::mutex> _{this->mutex_};
+	}
+}
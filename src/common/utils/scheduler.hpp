@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils::concurrency
+{
+	// Every worker owns a deque it pushes to and pops from at the back. Idle workers steal from
+	// the front of the others, so nested work stays on the thread that created it while it can
+	class scheduler
+	{
+	public:
+		using task = std::function<void()>;
+
+		// A thread count of 0 uses one worker per hardware thread
+		explicit scheduler(size_t thread_count = 0);
+		~scheduler();
+
+		scheduler(scheduler&&) = delete;
+		scheduler(const scheduler&) = delete;
+		scheduler& operator=(scheduler&&) = delete;
+		scheduler& operator=(const scheduler&) = delete;
+
+		size_t get_thread_count() const;
+
+		void post(task task);
+
+		// Runs one pending task on the calling thread. Returns false if there was none
+		bool run_one();
+
+	private:
+		struct task_queue
+		{
+			std::mutex mutex{};
+			std::deque<task> tasks{};
+		};
+
+		std::vector<std::unique_ptr<task_queue>> queues_{};
+		task_queue global_queue_{};
+
+		std::mutex mutex_{};
+		std::condition_variable condition_variable_{};
+		std::atomic<size_t> queued_{0};
+		bool stopping_{false};
+
+		std::vector<std::thread> threads_{};
+
+		bool pop_task(task& task, size_t index);
+		void run_worker(size_t index);
+	};
+
+	// For CPU-bound work, with one worker per hardware thread
+	scheduler& get_scheduler();
+
+	// For work that mostly waits, like transfers and file reads, so it can never starve the CPU-bound tasks.
+	// Its size caps how many of them are in flight
+	scheduler& get_io_scheduler();
+
+	// Tasks of a group are skipped once it is cancelled, which also happens when one of them throws.
+	// Waiting runs pending tasks instead of blocking, so groups can be waited on from within tasks
+	class task_group
+	{
+	public:
+		explicit task_group(scheduler& scheduler = get_scheduler());
+		~task_group();
+
+		task_group(task_group&&) = delete;
+		task_group(const task_group&) = delete;
+		task_group& operator=(task_group&&) = delete;
+		task_group& operator=(const task_group&) = delete;
+
+		void run(std::function<void()> task);
+
+		// Rethrows the first exception thrown by a task
+		void wait();
+
+		void cancel();
+		bool is_cancelled() const;
+
+	private:
+		scheduler& scheduler_;
+
+		std::atomic<size_t> pending_{0};
+		std::atomic_bool cancelled_{false};
+
+		std::mutex mutex_{};
+		std::condition_variable condition_variable_{};
+		std::exception_ptr exception_{};
+
+		void wait_for_tasks();
+	};
+
+	// Splits the range into chunks of grain indices, by default about four per worker
+	template <typename F>
+	void parallel_for(scheduler& scheduler, const size_t begin, const size_t end, F&& body, size_t grain = 0)
+	{
+		if (begin >= end)
+		{
+			return;
+		}
+
+		const auto count = end - begin;
+		if (!grain)
+		{
+			grain = std::max(static_cast<size_t>(1), count / (scheduler.get_thread_count() * 4));
+		}
+
+		task_group group{scheduler};
+
+		for (auto chunk_begin = begin; chunk_begin < end; chunk_begin += std::min(grain, end - chunk_begin))
+		{
+			const auto chunk_end = chunk_begin + std::min(grain, end - chunk_begin);
+
+			group.run([&body, &group, chunk_begin, chunk_end]()
+			{
+				for (auto i = chunk_begin; i < chunk_end && !group.is_cancelled(); ++i)
+				{
+					body(i);
+				}
+			});
+		}
+
+		group.wait();
+	}
+
+	template <typename F>
+	void parallel_for(const size_t begin, const size_t end, F&& body, const size_t grain = 0)
+	{
+		parallel_for(get_scheduler(), begin, end, std::forward<F>(body), grain);
+	}
+}
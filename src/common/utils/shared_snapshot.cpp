@@ -0,0 +1,176 @@
+#include "shared_snapshot.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#include "nt.hpp"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace utils
+{
+	namespace
+	{
+		// A reader that sees this many writes in a row gives up instead of spinning forever
+		constexpr size_t max_read_attempts = 1000;
+	}
+
+	shared_snapshot::shared_snapshot(const std::string& name, const size_t capacity)
+		: capacity_(capacity)
+	{
+		const auto size = sizeof(header) + capacity;
+
+#ifdef _WIN32
+		const auto mapping_name = "Local\\" + name;
+		this->mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		                                    static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+		                                    static_cast<DWORD>(size), mapping_name.data());
+		if (!this->mapping_)
+		{
+			throw std::runtime_error("Failed to create shared memory " + name);
+		}
+
+		this->view_ = MapViewOfFile(this->mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+		const auto mapping_name = "/" + name;
+		const auto fd = shm_open(mapping_name.data(), O_CREAT | O_RDWR, 0600);
+		if (fd < 0)
+		{
+			throw std::runtime_error("Failed to create shared memory " + name);
+		}
+
+		this->mapping_ = reinterpret_cast<void*>(static_cast<intptr_t>(fd) + 1);
+
+		void* view{};
+		if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+		{
+			view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		}
+
+		this->view_ = view == MAP_FAILED ? nullptr : view;
+#endif
+
+		if (!this->view_)
+		{
+			this->close();
+			throw std::runtime_error("Failed to map shared memory " + name);
+		}
+	}
+
+	shared_snapshot::~shared_snapshot()
+	{
+		this->close();
+	}
+
+	size_t shared_snapshot::get_capacity() const
+	{
+		return this->capacity_;
+	}
+
+	bool shared_snapshot::publish(const std::string_view data)
+	{
+		if (data.size() > this->capacity_)
+		{
+			return false;
+		}
+
+		auto* const header = this->get_header();
+
+		// An odd sequence means a write is in progress, which is also the state a crashed writer leaves behind
+		const auto sequence = header->sequence.load(std::memory_order_relaxed) | 1;
+		header->sequence.store(sequence, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		header->size.store(data.size(), std::memory_order_relaxed);
+		std::memcpy(this->get_data(), data.data(), data.size());
+
+		header->sequence.store(sequence + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool shared_snapshot::read(std::string& data) const
+	{
+		const auto* const header = this->get_header();
+
+		for (size_t attempt = 0; attempt < max_read_attempts; ++attempt)
+		{
+			const auto sequence = header->sequence.load(std::memory_order_acquire);
+			if (sequence == 0)
+			{
+				return false;
+			}
+
+			if (sequence & 1)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			const auto size = header->size.load(std::memory_order_relaxed);
+			if (size > this->capacity_)
+			{
+				continue;
+			}
+
+			data.resize(static_cast<size_t>(size));
+			std::memcpy(data.data(), this->get_data(), data.size());
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (header->sequence.load(std::memory_order_relaxed) == sequence)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	uint64_t shared_snapshot::get_version() const
+	{
+		return this->get_header()->sequence.load(std::memory_order_acquire);
+	}
+
+	shared_snapshot::header* shared_snapshot::get_header() const
+	{
+		return static_cast<header*>(this->view_);
+	}
+
+	char* shared_snapshot::get_data() const
+	{
+		return static_cast<char*>(this->view_) + sizeof(header);
+	}
+
+	void shared_snapshot::close()
+	{
+#ifdef _WIN32
+		if (this->view_)
+		{
+			UnmapViewOfFile(this->view_);
+			this->view_ = nullptr;
+		}
+
+		if (this->mapping_)
+		{
+			CloseHandle(this->mapping_);
+			this->mapping_ = nullptr;
+		}
+#else
+		if (this->view_)
+		{
+			munmap(this->view_, sizeof(header) + this->capacity_);
+			this->view_ = nullptr;
+		}
+
+		if (this->mapping_)
+		{
+			::close(static_cast<int>(reinterpret_cast<intptr_t>(this->mapping_) - 1));
+			this->mapping_ = nullptr;
+		}
+#endif
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <string_view>
+
+namespace utils
+{
+	// A blob in named shared memory that many processes read without locks. Readers retry while a write
+	// is in progress (seqlock), so they never block writers and never see a torn blob.
+	// Writers have to be serialized by the caller, e.g. through a named mutex
+	class shared_snapshot
+	{
+	public:
+		shared_snapshot(const std::string& name, size_t capacity);
+		~shared_snapshot();
+
+		shared_snapshot(shared_snapshot&&) = delete;
+		shared_snapshot(const shared_snapshot&) = delete;
+		shared_snapshot& operator=(shared_snapshot&&) = delete;
+		shared_snapshot& operator=(const shared_snapshot&) = delete;
+
+		size_t get_capacity() const;
+
+		// Returns false if the data does not fit
+		bool publish(std::string_view data);
+
+		// Returns false if nothing was published yet or a writer stayed in the middle of a write,
+		// e.g. because its process died
+		bool read(std::string& data) const;
+
+		// Changes with every publish and is 0 before the first one. Cheap enough to check before every read
+		uint64_t get_version() const;
+
+	private:
+		struct header
+		{
+			std::atomic<uint64_t> sequence;
+			std::atomic<uint64_t> size;
+		};
+
+		static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+		void* mapping_{};
+		void* view_{};
+		size_t capacity_{};
+
+		header* get_header() const;
+		char* get_data() const;
+
+		void close();
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "memory.hpp"
 #include <cstdint>
+#include <string_view>
 
 #ifndef ARRAYSIZE
 template <class Type, size_t n>
@@ -78,6 +79,17 @@ namespace utils::string
 		entry string_pool_[Buffers];
 	};
 
+	// Lets unordered containers keyed by std::string be searched with string views without allocating
+	struct transparent_hash
+	{
+		using is_transparent = void;
+
+		size_t operator()(const std::string_view text) const
+		{
+			return std::hash<std::string_view>{}(text);
+		}
+	};
+
 	const char* va(const char* fmt, ...);
 
 	std::vector<std::string> split(const std::string& s, char delim);
@@ -0,0 +1,75 @@
+#include "thread_pool.hpp"
+
+namespace utils
+{
+	thread_pool::thread_pool(const size_t thread_count, std::function<void()> thread_start,
+	                         std::function<void()> thread_exit)
+	{
+		this->threads_.reserve(thread_count);
+
+		for (size_t i = 0; i < thread_count; ++i)
+		{
+			this->threads_.emplace_back([this, thread_start, thread_exit]()
+			{
+				if (thread_start)
+				{
+					thread_start();
+				}
+
+				while (true)
+				{
+					std::unique_lock<std::mutex> lock{this->mutex_};
+					this->condition_variable_.wait(lock, [this]()
+					{
+						return this->stopping_ || !this->tasks_.empty();
+					});
+
+					// Queued tasks are still run when stopping
+					if (this->tasks_.empty())
+					{
+						break;
+					}
+
+					auto task = std::move(this->tasks_.front());
+					this->tasks_.pop_front();
+					lock.unlock();
+
+					task();
+				}
+
+				if (thread_exit)
+				{
+					thread_exit();
+				}
+			});
+		}
+	}
+
+	thread_pool::~thread_pool()
+	{
+		{
+			std::lock_guard<std::mutex> _{this->mutex_};
+			this->stopping_ = true;
+		}
+
+		this->condition_variable_.notify_all();
+
+		for (auto& thread : this->threads_)
+		{
+			if (thread.joinable())
+			{
+				thread.join();
+			}
+		}
+	}
+
+	void thread_pool::post(task task)
+	{
+		{
+			std::lock_guard<std::mutex> _{this->mutex_};
+			this->tasks_.emplace_back(std::move(task));
+		}
+
+		this->condition_variable_.notify_one();
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils
+{
+	class thread_pool
+	{
+	public:
+		using task = std::function<void()>;
+
+		// The hooks run on every worker thread when it starts and before it exits
+		explicit thread_pool(size_t thread_count, std::function<void()> thread_start = {},
+		                     std::function<void()> thread_exit = {});
+		~thread_pool();
+
+		thread_pool(thread_pool&&) = delete;
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(thread_pool&&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		void post(task task);
+
+	private:
+		std::mutex mutex_{};
+		std::condition_variable condition_variable_{};
+		std::deque<task> tasks_{};
+		bool stopping_{false};
+
+		std::vector<std::thread> threads_{};
+	};
+}
@@ -0,0 +1,237 @@
+#include "tracing.hpp"
+
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace utils::tracing
+{
+	namespace
+	{
+		struct event
+		{
+			const char* name{};
+			uint64_t start{};
+			uint64_t duration{};
+		};
+
+		// Only the owning thread appends, readers see every event below the published size
+		struct chunk
+		{
+			static constexpr size_t capacity = 1024;
+
+			std::array<event, capacity> events{};
+			std::atomic<size_t> size{0};
+			std::atomic<chunk*> next{};
+		};
+
+		struct thread_buffer
+		{
+			uint32_t id{};
+			std::atomic<const char*> name{};
+
+			chunk first{};
+			chunk* last{&first};
+			std::vector<std::unique_ptr<chunk>> chunks{};
+
+			void append(const event& event)
+			{
+				auto size = this->last->size.load(std::memory_order_relaxed);
+				if (size == chunk::capacity)
+				{
+					auto& next = this->chunks.emplace_back(std::make_unique<chunk>());
+					this->last->next.store(next.get(), std::memory_order_release);
+					this->last = next.get();
+					size = 0;
+				}
+
+				this->last->events[size] = event;
+				this->last->size.store(size + 1, std::memory_order_release);
+			}
+		};
+
+		std::atomic_bool enabled{false};
+		const auto origin = std::chrono::steady_clock::now();
+
+		// Buffers of finished threads are kept, their spans are still part of the trace
+		std::mutex buffers_mutex{};
+		std::vector<std::shared_ptr<thread_buffer>> buffers{};
+
+		uint64_t get_time()
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - origin).count());
+		}
+
+		thread_buffer& get_thread_buffer()
+		{
+			thread_local const auto buffer = []()
+			{
+				auto result = std::make_shared<thread_buffer>();
+
+				std::lock_guard<std::mutex> _{buffers_mutex};
+				result->id = static_cast<uint32_t>(buffers.size() + 1);
+				buffers.emplace_back(result);
+
+				return result;
+			}();
+
+			return *buffer;
+		}
+
+		void append_escaped(std::string& out, const char* text)
+		{
+			for (; *text; ++text)
+			{
+				const auto c = *text;
+				if (c == '"' || c == '\\')
+				{
+					out += '\\';
+					out += c;
+				}
+				else if (static_cast<unsigned char>(c) < 0x20)
+				{
+					out += ' ';
+				}
+				else
+				{
+					out += c;
+				}
+			}
+		}
+
+		template <typename T>
+		void append_number(std::string& out, const T value)
+		{
+			std::array<char, 32> buffer{};
+			const auto result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+			out.append(buffer.data(), result.ptr);
+		}
+
+		// Chrome expects microseconds, the fraction keeps the nanoseconds
+		void append_microseconds(std::string& out, const uint64_t nanoseconds)
+		{
+			append_number(out, nanoseconds / 1000);
+			out += '.';
+
+			const auto fraction = nanoseconds % 1000;
+			out += static_cast<char>('0' + fraction / 100);
+			out += static_cast<char>('0' + fraction / 10 % 10);
+			out += static_cast<char>('0' + fraction % 10);
+		}
+	}
+
+	void enable()
+	{
+		enabled = true;
+	}
+
+	bool is_enabled()
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	void set_thread_name(const char* name)
+	{
+		if (!is_enabled())
+		{
+			return;
+		}
+
+		get_thread_buffer().name.store(name, std::memory_order_release);
+	}
+
+	span::span(const char* name)
+	{
+		if (is_enabled())
+		{
+			this->name_ = name;
+			this->start_ = get_time();
+		}
+	}
+
+	span::~span()
+	{
+		this->end();
+	}
+
+	void span::end()
+	{
+		if (!this->name_)
+		{
+			return;
+		}
+
+		get_thread_buffer().append({this->name_, this->start_, get_time() - this->start_});
+		this->name_ = nullptr;
+	}
+
+	std::string export_chrome_trace()
+	{
+		std::vector<std::shared_ptr<thread_buffer>> thread_buffers{};
+
+		{
+			std::lock_guard<std::mutex> _{buffers_mutex};
+			thread_buffers = buffers;
+		}
+
+		std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		auto first = true;
+
+		const auto begin_event = [&out, &first]()
+		{
+			out += first ? "\n" : ",\n";
+			first = false;
+		};
+
+		for (const auto& buffer : thread_buffers)
+		{
+			if (const auto* name = buffer->name.load(std::memory_order_acquire))
+			{
+				begin_event();
+				out += R"({"ph":"M","name":"thread_name","pid":1,"tid":)";
+				append_number(out, buffer->id);
+				out += R"(,"args":{"name":")";
+				append_escaped(out, name);
+				out += "\"}}";
+			}
+
+			for (auto* current = &buffer->first; current; current = current->next.load(std::memory_order_acquire))
+			{
+				const auto size = current->size.load(std::memory_order_acquire);
+				for (size_t i = 0; i < size; ++i)
+				{
+					const auto& event = current->events[i];
+
+					begin_event();
+					out += R"({"ph":"X","pid":1,"tid":)";
+					append_number(out, buffer->id);
+					out += R"(,"name":")";
+					append_escaped(out, event.name);
+					out += R"(","ts":)";
+					append_microseconds(out, event.start);
+					out += R"(,"dur":)";
+					append_microseconds(out, event.duration);
+					out += '}';
+				}
+			}
+		}
+
+		out += "\n]}\n";
+		return out;
+	}
+
+	bool save(const std::filesystem::path& file)
+	{
+		const auto trace = export_chrome_trace();
+
+		std::ofstream stream(file, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+		stream.write(trace.data(), static_cast<std::streamsize>(trace.size()));
+		return static_cast<bool>(stream);
+	}
+}
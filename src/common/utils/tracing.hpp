@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace utils::tracing
+{
+	// Nothing is recorded until tracing is enabled, a span then costs a single relaxed load
+	void enable();
+	bool is_enabled();
+
+	// Shows up as the name of the calling thread's track, ignored while tracing is disabled
+	void set_thread_name(const char* name);
+
+	// Records the time between construction and end or destruction. Spans on the same thread nest by time.
+	// Names are not copied, they have to outlive the trace, which string literals do
+	class span
+	{
+	public:
+		explicit span(const char* name);
+		~span();
+
+		span(span&&) = delete;
+		span(const span&) = delete;
+		span& operator=(span&&) = delete;
+		span& operator=(const span&) = delete;
+
+		void end();
+
+	private:
+		const char* name_{};
+		uint64_t start_{};
+	};
+
+	// Chrome trace_event JSON, viewable in chrome://tracing or Perfetto. Threads can keep recording meanwhile
+	std::string export_chrome_trace();
+	bool save(const std::filesystem::path& file);
+}
@@ -13,4 +13,33 @@ window.executeCommand = function(command, data) {
         },
         body: JSON.stringify(object)
     }).then(data => data.json());
-};
\ No newline at end of file
+};
+
+// Runs several commands in one request, e.g. [["get-property", "aw-install"], ["get-channel"]]
+window.executeCommands = function(commands) {
+
+    var objects = commands.map(command => ({
+        command: command[0],
+        data: command[1] || null,
+    }));
+
+    return fetch("/commands", {
+        method: 'POST',
+        headers: {
+            'Accept': 'application/json',
+            'Content-Type': 'application/json'
+        },
+        body: JSON.stringify(objects)
+    }).then(data => data.json());
+};
+
+window.nativeEvents = null;
+
+window.addNativeEventListener = function(name, callback) {
+    if (!window.nativeEvents) {
+        // The launcher pushes progress, launch state and property changes through a single stream
+        window.nativeEvents = new EventSource("/events");
+    }
+
+    window.nativeEvents.addEventListener(name, event => callback(JSON.parse(event.data)));
+};
@@ -8,6 +8,7 @@
 #include <utils/nt.hpp>
 #include <utils/string.hpp>
 #include <utils/finally.hpp>
+#include <utils/tracing.hpp>
 
 #include "../updater/updater.hpp"
 
@@ -24,6 +25,8 @@ namespace cef
 				return;
 			}
 
+			const utils::tracing::span span{"delay_load_cef"};
+
 			const auto old_directory = utils::nt::library::get_dll_directory();
 			utils::nt::library::set_dll_directory(path);
 			auto _ = utils::finally([&]()
@@ -91,7 +94,11 @@ namespace cef
 		CefString(&settings.cache_path) = this->path_ / "user" / "cef-data" / "cache";
 		CefString(&settings.locale) = "en-US";
 
-		this->initialized_ = CefInitialize(args, settings, new cef_ui_app(), nullptr);
+		{
+			const utils::tracing::span span{"CefInitialize"};
+			this->initialized_ = CefInitialize(args, settings, new cef_ui_app(), nullptr);
+		}
+
 		CefRegisterSchemeHandlerFactory("http", "xlabs", new cef_ui_scheme_handler_factory(folder, this->command_handlers_));
 
 		CefBrowserSettings browser_settings;
@@ -111,6 +118,8 @@ namespace cef
 		}
 
 		const auto url = "http://xlabs/" + file;
+
+		const utils::tracing::span span{"CreateBrowserSync"};
 		this->browser_ = CefBrowserHost::CreateBrowserSync(window_info, this->ui_handler_, url, browser_settings,
 		                                                   nullptr, nullptr);
 	}
@@ -127,8 +136,27 @@ namespace cef
 		browser->GetHost()->CloseBrowser(true);
 	}
 
+	void cef_ui::invoke_callback(const std::function<void()>& callback)
+	{
+		callback();
+	}
+
+	void cef_ui::post_to_ui(std::function<void()> callback)
+	{
+		CefPostTask(TID_UI, base::BindOnce(&cef_ui::invoke_callback, std::move(callback)));
+	}
+
 	void cef_ui::close_browser()
 	{
+		if (!CefCurrentlyOn(TID_UI))
+		{
+			post_to_ui([this]()
+			{
+				this->close_browser();
+			});
+			return;
+		}
+
 		if (!this->browser_) return;
 		CefPostTask(TID_UI, base::BindOnce(&cef_ui::invoke_close_browser, this->browser_));
 		this->browser_ = nullptr;
@@ -136,6 +164,15 @@ namespace cef
 
 	void cef_ui::reload_browser() const
 	{
+		if (!CefCurrentlyOn(TID_UI))
+		{
+			post_to_ui([this]()
+			{
+				this->reload_browser();
+			});
+			return;
+		}
+
 		if (!this->browser_) return;
 		this->browser_->Reload();
 	}
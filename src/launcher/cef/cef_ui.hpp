@@ -1,6 +1,8 @@
 #pragma once
 
+#include <utils/json.hpp>
 #include <utils/nt.hpp>
+#include <utils/string.hpp>
 #include "cef_ui_handler.hpp"
 
 namespace cef
@@ -9,16 +11,22 @@ namespace cef
 	{
 	public:
 		using command_handler = std::function<void(const rapidjson::Value& request, rapidjson::Document& response)>;
-		using command_handlers = std::unordered_map<std::string, command_handler>;
+		using command_handlers = std::unordered_map<std::string, command_handler, utils::string::transparent_hash,
+		                                            std::equal_to<>>;
 
 		cef_ui(utils::nt::library process, std::filesystem::path path);
 		~cef_ui();
 
+		// Only valid on the UI thread, which is the one running work()
 		HWND get_window() const;
 
+		// Can be called from any thread, the browser itself is only touched on the UI thread
 		void close_browser();
 		void reload_browser() const;
 
+		// Commands run on worker threads, so whatever they do with the window has to go through here
+		static void post_to_ui(std::function<void()> callback);
+
 		int run_process() const;
 		void create(const std::filesystem::path& folder, const std::string& file);
 		static void work_once();
@@ -26,6 +34,32 @@ namespace cef
 
 		void add_command(std::string command, command_handler handler);
 
+		// Decodes the request data as Request and encodes whatever the handler returns as the response.
+		// Requests of the wrong shape are answered with null without running the handler
+		template <typename Request, typename Handler>
+		void add_command(std::string command, Handler handler)
+		{
+			this->add_command(std::move(command), [handler = std::move(handler)](const rapidjson::Value& value,
+			                                                                     rapidjson::Document& response)
+			{
+				Request request{};
+				if (!utils::json::decode(value, request))
+				{
+					response.SetNull();
+					return;
+				}
+
+				if constexpr (std::is_void_v<std::invoke_result_t<const Handler&, const Request&>>)
+				{
+					handler(request);
+				}
+				else
+				{
+					utils::json::encode(handler(request), response);
+				}
+			});
+		}
+
 	private:
 		utils::nt::library process_;
 		bool initialized_ = false;
@@ -36,5 +70,6 @@ namespace cef
 		CefRefPtr<cef_ui_handler> ui_handler_;
 
 		static void invoke_close_browser(CefRefPtr<CefBrowser> browser);
+		static void invoke_callback(const std::function<void()>& callback);
 	};
 }
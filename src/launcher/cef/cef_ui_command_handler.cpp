@@ -0,0 +1,76 @@
+#include <std_include.hpp>
+
+#include "cef/cef_ui_command_handler.hpp"
+
+namespace cef
+{
+	cef_ui_command_handler::cef_ui_command_handler(const command_handlers& command_handlers,
+	                                               utils::thread_pool& workers, const bool batch)
+		: command_handlers_(command_handlers)
+		  , workers_(workers)
+		  , batch_(batch)
+	{
+	}
+
+	bool cef_ui_command_handler::Open(CefRefPtr<CefRequest> request, bool& handle_request,
+	                                  CefRefPtr<CefCallback> callback)
+	{
+		const auto start_time = std::chrono::steady_clock::now();
+
+		CefPostData::ElementVector vector{};
+		const auto post_data = request->GetPostData();
+		if (post_data)
+		{
+			post_data->GetElements(vector);
+		}
+
+		std::string json{};
+		if (vector.size() == 1)
+		{
+			const auto& element = vector.front();
+			json.resize(element->GetBytesCount());
+			element->GetBytes(json.size(), json.data());
+		}
+
+		handle_request = false;
+
+		CefRefPtr<cef_ui_command_handler> self{this};
+		this->workers_.post([self, callback, json = std::move(json), start_time]() mutable
+		{
+			utils::commands::execute(self->command_handlers_, json, self->batch_, self->response_, start_time);
+
+			if (!self->cancelled_)
+			{
+				callback->Continue();
+			}
+		});
+
+		return true;
+	}
+
+	void cef_ui_command_handler::GetResponseHeaders(CefRefPtr<CefResponse> response, int64& response_length,
+	                                                CefString& /*redirect_url*/)
+	{
+		response->SetStatus(200);
+		response->SetStatusText("OK");
+		response->SetMimeType("application/json");
+		response_length = static_cast<int64>(this->response_.size());
+	}
+
+	bool cef_ui_command_handler::Read(void* data_out, const int bytes_to_read, int& bytes_read,
+	                                  CefRefPtr<CefResourceReadCallback> /*callback*/)
+	{
+		const auto length = std::min(static_cast<size_t>(bytes_to_read), this->response_.size() - this->offset_);
+		std::memcpy(data_out, this->response_.data() + this->offset_, length);
+
+		this->offset_ += length;
+		bytes_read = static_cast<int>(length);
+
+		return length > 0;
+	}
+
+	void cef_ui_command_handler::Cancel()
+	{
+		this->cancelled_ = true;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <utils/commands.hpp>
+#include <utils/thread_pool.hpp>
+
+namespace cef
+{
+	// Runs a command on the worker pool and responds once it finished, so the IO thread never waits for it.
+	// Batches are arrays of commands that are answered with an array of their responses in the same order.
+	// Several commands can run at once, so handlers reach the browser and the window through cef_ui::post_to_ui
+	class cef_ui_command_handler : public CefResourceHandler
+	{
+	public:
+		using command_handler = utils::commands::handler;
+		using command_handlers = utils::commands::handlers;
+
+		cef_ui_command_handler(const command_handlers& command_handlers, utils::thread_pool& workers, bool batch);
+
+		bool Open(CefRefPtr<CefRequest> request, bool& handle_request, CefRefPtr<CefCallback> callback) override;
+
+		void GetResponseHeaders(CefRefPtr<CefResponse> response, int64& response_length,
+		                        CefString& redirect_url) override;
+
+		bool Read(void* data_out, int bytes_to_read, int& bytes_read,
+		          CefRefPtr<CefResourceReadCallback> callback) override;
+
+		void Cancel() override;
+
+	private:
+		const command_handlers& command_handlers_;
+		utils::thread_pool& workers_;
+		bool batch_{};
+
+		std::atomic_bool cancelled_{false};
+		std::string response_{};
+		size_t offset_{};
+
+		IMPLEMENT_REFCOUNTING(cef_ui_command_handler);
+		DISALLOW_COPY_AND_ASSIGN(cef_ui_command_handler);
+	};
+}
@@ -0,0 +1,157 @@
+#include <std_include.hpp>
+
+#include "cef/cef_ui_event_handler.hpp"
+
+namespace cef
+{
+	namespace
+	{
+		// Slow renderers get the latest state per key instead of an ever growing backlog
+		constexpr size_t event_capacity = 64;
+
+		void append_event(std::string& buffer, const utils::events::event& event)
+		{
+			buffer.append("event: ");
+			buffer.append(event.name);
+			buffer.push_back('\n');
+
+			size_t start = 0;
+			while (true)
+			{
+				const auto end = event.data.find('\n', start);
+
+				buffer.append("data: ");
+				buffer.append(event.data, start, end == std::string::npos ? std::string::npos : end - start);
+				buffer.push_back('\n');
+
+				if (end == std::string::npos)
+				{
+					break;
+				}
+
+				start = end + 1;
+			}
+
+			buffer.push_back('\n');
+		}
+	}
+
+	bool cef_ui_event_handler::Open(CefRefPtr<CefRequest> /*request*/, bool& handle_request,
+	                                CefRefPtr<CefCallback> /*callback*/)
+	{
+		handle_request = true;
+
+		// Lets EventSource reconnect quickly if the stream ever breaks
+		this->buffer_ = "retry: 1000\n\n";
+
+		// The subscription keeps the handler alive until Cancel releases it
+		CefRefPtr<cef_ui_event_handler> self{this};
+		this->subscriber_ = utils::events::subscribe([self]()
+		{
+			self->notify();
+		}, event_capacity);
+
+		return true;
+	}
+
+	void cef_ui_event_handler::GetResponseHeaders(CefRefPtr<CefResponse> response, int64& response_length,
+	                                              CefString& /*redirect_url*/)
+	{
+		response->SetStatus(200);
+		response->SetStatusText("OK");
+		response->SetMimeType("text/event-stream");
+		response->SetHeaderByName("Cache-Control", "no-cache", true);
+		response_length = -1;
+	}
+
+	bool cef_ui_event_handler::Read(void* data_out, const int bytes_to_read, int& bytes_read,
+	                                CefRefPtr<CefResourceReadCallback> callback)
+	{
+		std::lock_guard<std::mutex> _{this->mutex_};
+
+		bytes_read = 0;
+		if (this->cancelled_)
+		{
+			return false;
+		}
+
+		const auto length = this->fill(data_out, static_cast<size_t>(bytes_to_read));
+		if (length > 0)
+		{
+			bytes_read = static_cast<int>(length);
+			return true;
+		}
+
+		// Completed by notify once the next event is published
+		this->pending_data_ = data_out;
+		this->pending_size_ = bytes_to_read;
+		this->pending_callback_ = callback;
+
+		return true;
+	}
+
+	void cef_ui_event_handler::Cancel()
+	{
+		// Released outside the lock, as the subscription may hold the last reference to this handler
+		std::shared_ptr<utils::events::subscriber> subscriber{};
+
+		{
+			std::lock_guard<std::mutex> _{this->mutex_};
+			this->cancelled_ = true;
+			this->pending_callback_ = nullptr;
+			subscriber = std::move(this->subscriber_);
+		}
+	}
+
+	size_t cef_ui_event_handler::fill(void* data_out, const size_t size)
+	{
+		if (this->offset_ == this->buffer_.size())
+		{
+			this->buffer_.clear();
+			this->offset_ = 0;
+
+			while (this->subscriber_ && this->buffer_.size() < size)
+			{
+				const auto event = this->subscriber_->next();
+				if (!event)
+				{
+					break;
+				}
+
+				append_event(this->buffer_, *event);
+			}
+		}
+
+		const auto length = std::min(size, this->buffer_.size() - this->offset_);
+		std::memcpy(data_out, this->buffer_.data() + this->offset_, length);
+		this->offset_ += length;
+
+		return length;
+	}
+
+	void cef_ui_event_handler::notify()
+	{
+		CefRefPtr<CefResourceReadCallback> callback{};
+		size_t length{};
+
+		{
+			std::lock_guard<std::mutex> _{this->mutex_};
+			if (!this->pending_callback_)
+			{
+				return;
+			}
+
+			length = this->fill(this->pending_data_, static_cast<size_t>(this->pending_size_));
+			if (length == 0)
+			{
+				return;
+			}
+
+			callback = std::move(this->pending_callback_);
+			this->pending_data_ = nullptr;
+			this->pending_size_ = 0;
+		}
+
+		callback->Continue(static_cast<int>(length));
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <utils/events.hpp>
+
+namespace cef
+{
+	// Streams published events to the UI as Server-Sent Events. Reads are completed asynchronously
+	// once an event arrives, so the connection stays open without blocking a thread
+	class cef_ui_event_handler : public CefResourceHandler
+	{
+	public:
+		cef_ui_event_handler() = default;
+
+		bool Open(CefRefPtr<CefRequest> request, bool& handle_request, CefRefPtr<CefCallback> callback) override;
+
+		void GetResponseHeaders(CefRefPtr<CefResponse> response, int64& response_length,
+		                        CefString& redirect_url) override;
+
+		bool Read(void* data_out, int bytes_to_read, int& bytes_read,
+		          CefRefPtr<CefResourceReadCallback> callback) override;
+
+		void Cancel() override;
+
+	private:
+		std::mutex mutex_{};
+		std::shared_ptr<utils::events::subscriber> subscriber_{};
+		bool cancelled_{false};
+
+		std::string buffer_{};
+		size_t offset_{};
+
+		void* pending_data_{};
+		int pending_size_{};
+		CefRefPtr<CefResourceReadCallback> pending_callback_{};
+
+		size_t fill(void* data_out, size_t size);
+		void notify();
+
+		IMPLEMENT_REFCOUNTING(cef_ui_event_handler);
+		DISALLOW_COPY_AND_ASSIGN(cef_ui_event_handler);
+	};
+}
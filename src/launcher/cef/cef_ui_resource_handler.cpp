@@ -0,0 +1,176 @@
+#include <std_include.hpp>
+
+#include "cef/cef_ui_resource_handler.hpp"
+
+#include <utils/byte_range.hpp>
+
+namespace cef
+{
+	cef_ui_resource_handler::cef_ui_resource_handler(std::string mime_type, const std::string_view data,
+	                                                 std::shared_ptr<const void> owner)
+		: mime_type_(std::move(mime_type))
+		  , data_(data)
+		  , owner_(std::move(owner))
+	{
+	}
+
+	cef_ui_resource_handler::cef_ui_resource_handler(std::string mime_type, std::unique_ptr<utils::file_stream> stream)
+		: mime_type_(std::move(mime_type))
+		  , stream_(std::move(stream))
+	{
+	}
+
+	void cef_ui_resource_handler::set_status(const int status)
+	{
+		this->status_ = status;
+	}
+
+	void cef_ui_resource_handler::set_header(const std::string& name, const std::string& value)
+	{
+		this->headers_.emplace(name, value);
+	}
+
+	bool cef_ui_resource_handler::Open(CefRefPtr<CefRequest> request, bool& handle_request,
+	                                   CefRefPtr<CefCallback> /*callback*/)
+	{
+		handle_request = true;
+
+		const auto size = this->get_size();
+		this->end_ = size;
+
+		if (this->status_ != 200)
+		{
+			return true;
+		}
+
+		this->set_header("Accept-Ranges", "bytes");
+
+		utils::byte_range range{};
+		const auto status = utils::parse_range(request->GetHeaderByName("Range").ToString(), size, range);
+
+		if (status == utils::range_status::satisfiable)
+		{
+			this->status_ = 206;
+			this->set_header("Content-Range", utils::get_content_range(range, size));
+
+			this->begin_ = range.offset;
+			this->end_ = range.offset + range.length;
+			this->position_ = this->begin_;
+		}
+		else if (status == utils::range_status::unsatisfiable)
+		{
+			this->status_ = 416;
+			this->set_header("Content-Range", utils::get_content_range({}, size));
+
+			this->end_ = 0;
+		}
+
+		return true;
+	}
+
+	void cef_ui_resource_handler::GetResponseHeaders(CefRefPtr<CefResponse> response, int64& response_length,
+	                                                 CefString& /*redirect_url*/)
+	{
+		const char* status_text = "OK";
+		switch (this->status_)
+		{
+		case 206:
+			status_text = "Partial Content";
+			break;
+		case 304:
+			status_text = "Not Modified";
+			break;
+		case 416:
+			status_text = "Range Not Satisfiable";
+			break;
+		default:
+			break;
+		}
+
+		response->SetStatus(this->status_);
+		response->SetStatusText(status_text);
+		response->SetMimeType(this->mime_type_);
+		response->SetHeaderMap(this->headers_);
+
+		response_length = this->status_ == 304 ? 0 : static_cast<int64>(this->end_ - this->begin_);
+	}
+
+	bool cef_ui_resource_handler::Skip(const int64 bytes_to_skip, int64& bytes_skipped,
+	                                   CefRefPtr<CefResourceSkipCallback> /*callback*/)
+	{
+		if (bytes_to_skip < 0)
+		{
+			bytes_skipped = ERR_FAILED;
+			return false;
+		}
+
+		// CEF 113 (StreamReaderURLLoader) parses the Range header on its own. Before the first read it skips
+		// until it reached the first requested byte, counting from the start of the resource. Responses to
+		// ranges already start at that byte, so those skips only move the position once they pass it
+		if (!this->reading_)
+		{
+			const auto target = std::min(this->skipped_ + static_cast<uint64_t>(bytes_to_skip), this->end_);
+
+			bytes_skipped = static_cast<int64>(target - this->skipped_);
+			this->skipped_ = target;
+			this->position_ = std::max(this->position_, target);
+		}
+		else
+		{
+			const auto target = std::min(this->position_ + static_cast<uint64_t>(bytes_to_skip), this->end_);
+
+			bytes_skipped = static_cast<int64>(target - this->position_);
+			this->position_ = target;
+		}
+
+		return bytes_skipped > 0;
+	}
+
+	bool cef_ui_resource_handler::Read(void* data_out, const int bytes_to_read, int& bytes_read,
+	                                   CefRefPtr<CefResourceReadCallback> /*callback*/)
+	{
+		bytes_read = 0;
+		this->reading_ = true;
+
+		const auto available = this->end_ > this->position_ ? this->end_ - this->position_ : 0;
+		const auto length = static_cast<size_t>(std::min(static_cast<uint64_t>(bytes_to_read), available));
+		if (!length)
+		{
+			return false;
+		}
+
+		size_t read{};
+		if (this->stream_)
+		{
+			if (this->stream_->get_position() != this->position_)
+			{
+				this->stream_->seek(this->position_);
+			}
+
+			read = this->stream_->read(static_cast<char*>(data_out), length);
+		}
+		else
+		{
+			read = length;
+			std::memcpy(data_out, this->data_.data() + this->position_, length);
+		}
+
+		this->position_ += read;
+		bytes_read = static_cast<int>(read);
+
+		return read > 0;
+	}
+
+	void cef_ui_resource_handler::Cancel()
+	{
+		this->owner_ = {};
+		this->data_ = {};
+		this->stream_ = {};
+		this->end_ = this->position_;
+	}
+
+	uint64_t cef_ui_resource_handler::get_size() const
+	{
+		return this->stream_ ? this->stream_->get_size() : this->data_.size();
+	}
+}
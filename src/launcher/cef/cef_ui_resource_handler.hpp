@@ -0,0 +1,52 @@
+#pragma once
+
+#include <utils/file_stream.hpp>
+
+namespace cef
+{
+	// Serves a response either from memory that is kept alive by the owner or by streaming a file.
+	// Single byte ranges are answered with 206 Partial Content
+	class cef_ui_resource_handler : public CefResourceHandler
+	{
+	public:
+		cef_ui_resource_handler(std::string mime_type, std::string_view data, std::shared_ptr<const void> owner);
+		cef_ui_resource_handler(std::string mime_type, std::unique_ptr<utils::file_stream> stream);
+
+		void set_status(int status);
+		void set_header(const std::string& name, const std::string& value);
+
+		bool Open(CefRefPtr<CefRequest> request, bool& handle_request, CefRefPtr<CefCallback> callback) override;
+
+		void GetResponseHeaders(CefRefPtr<CefResponse> response, int64& response_length,
+		                        CefString& redirect_url) override;
+
+		bool Skip(int64 bytes_to_skip, int64& bytes_skipped, CefRefPtr<CefResourceSkipCallback> callback) override;
+
+		bool Read(void* data_out, int bytes_to_read, int& bytes_read,
+		          CefRefPtr<CefResourceReadCallback> callback) override;
+
+		void Cancel() override;
+
+	private:
+		std::string mime_type_{};
+		int status_{200};
+		CefResponse::HeaderMap headers_{};
+
+		std::string_view data_{};
+		std::shared_ptr<const void> owner_{};
+		std::unique_ptr<utils::file_stream> stream_{};
+
+		uint64_t begin_{};
+		uint64_t end_{};
+		uint64_t position_{};
+
+		// Bytes CEF skipped before the first read, counted from the start of the resource
+		uint64_t skipped_{};
+		bool reading_{false};
+
+		uint64_t get_size() const;
+
+		IMPLEMENT_REFCOUNTING(cef_ui_resource_handler);
+		DISALLOW_COPY_AND_ASSIGN(cef_ui_resource_handler);
+	};
+}
@@ -1,12 +1,19 @@
 #pragma once
 
+#include <utils/asset_pack.hpp>
+#include <utils/file_cache.hpp>
+#include <utils/file_stream.hpp>
+#include <utils/string.hpp>
+#include <utils/thread_pool.hpp>
+
 namespace cef
 {
 	class cef_ui_scheme_handler_factory : public CefSchemeHandlerFactory
 	{
 	public:
 		using command_handler = std::function<void(const rapidjson::Value& request, rapidjson::Document& response)>;
-		using command_handlers = std::unordered_map<std::string, command_handler>;
+		using command_handlers = std::unordered_map<std::string, command_handler, utils::string::transparent_hash,
+		                                            std::equal_to<>>;
 
 		cef_ui_scheme_handler_factory(std::filesystem::path folder, const command_handlers& command_handlers);
 
@@ -18,10 +25,23 @@ namespace cef
 	private:
 		std::filesystem::path folder_;
 		const command_handlers& command_handlers_;
+		utils::file_cache file_cache_;
+		std::shared_ptr<utils::asset_pack> asset_pack_{};
+		std::filesystem::file_time_type asset_pack_time_{};
+		utils::thread_pool command_workers_;
 
 		IMPLEMENT_REFCOUNTING(cef_ui_scheme_handler_factory);
 		DISALLOW_COPY_AND_ASSIGN(cef_ui_scheme_handler_factory);
 
-		CefResourceHandler* handle_command(const CefRefPtr<CefRequest>& request, const std::string& path) const;
+		struct asset
+		{
+			std::string_view data{};
+			std::shared_ptr<const void> owner{};
+			std::unique_ptr<utils::file_stream> stream{};
+			std::string etag{};
+		};
+
+		std::optional<asset> find_asset(const std::string& path, bool stream);
+		CefResourceHandler* handle_command(const std::string& path);
 	};
 }
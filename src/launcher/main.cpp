@@ -5,10 +5,14 @@
 #include <utils/com.hpp>
 #include <utils/flags.hpp>
 #include <utils/named_mutex.hpp>
+#include <utils/events.hpp>
 #include <utils/exit_callback.hpp>
 #include <utils/properties.hpp>
 #include <utils/io.hpp>
+#include <utils/json.hpp>
+#include <utils/metrics.hpp>
 #include <utils/string.hpp>
+#include <utils/tracing.hpp>
 
 namespace
 {
@@ -26,8 +30,36 @@ namespace
 		std::filesystem::current_path(appdata);
 	}
 
+	// Startup phases are traced with -trace, the trace is written when the launcher exits
+	void enable_tracing()
+	{
+		if (!utils::flags::has_flag("trace"))
+		{
+			return;
+		}
+
+		utils::tracing::enable();
+		utils::tracing::set_thread_name("main");
+
+		utils::at_exit([]()
+		{
+			utils::tracing::save("xlabs-trace.json");
+		});
+	}
+
+	// Whatever the metrics counted is kept for inspection after the launcher exits
+	void save_metrics_on_exit()
+	{
+		utils::at_exit([]()
+		{
+			utils::metrics::save("xlabs-metrics.json");
+		});
+	}
+
 	void enable_dpi_awareness()
 	{
+		const utils::tracing::span span{"enable_dpi_awareness"};
+
 		const utils::nt::library user32{"user32.dll"};
 
 		const auto set_dpi_awareness_context = user32
@@ -60,6 +92,8 @@ namespace
 
 	void run_as_singleton()
 	{
+		const utils::tracing::span span{"run_as_singleton"};
+
 		static utils::named_mutex mutex{"xlabs-launcher"};
 		if (!mutex.try_lock(3s))
 		{
@@ -107,17 +141,27 @@ namespace
 		return std::format("{} {}", arg, options.value());
 	}
 
-	void add_commands(cef::cef_ui& cef_ui)
+	struct launch_state
 	{
-		cef_ui.add_command("launch-aw", [&cef_ui](const rapidjson::Value& value, auto&)
-		{
-			if (!value.IsString())
-			{
-				return;
-			}
+		std::string mode{};
+		std::string state{};
+
+		static constexpr auto fields = std::make_tuple(utils::json::make_field("mode", &launch_state::mode),
+		                                               utils::json::make_field("state", &launch_state::state));
+	};
 
-			const auto arg = std::string{ value.GetString() };
+	void publish_launch_state(const std::string& mode, const std::string& state)
+	{
+		rapidjson::Document event{};
+		utils::json::encode(launch_state{mode, state}, event);
+
+		utils::events::publish("launch", event);
+	}
 
+	void add_commands(cef::cef_ui& cef_ui)
+	{
+		cef_ui.add_command<std::string>("launch-aw", [&cef_ui](const std::string& arg)
+		{
 			static const std::unordered_map<std::string, std::string> arg_mapping = {
 				{"aw-sp", "-singleplayer"},
 				{"aw-mp", "-multiplayer"},
@@ -142,23 +186,23 @@ namespace
 				return;
 			}
 
+			publish_launch_state(arg, "launching");
+
+			// The game reads its settings from the properties file
+			utils::properties::flush();
+
 			SetEnvironmentVariableA("XLABS_AW_INSTALL", aw_install->data());
 
 			const auto s1x_exe = utils::properties::get_appdata_path() / "data" / "s1x" / "s1x.exe";
 			utils::nt::launch_process(s1x_exe, get_launch_options(mapped_arg->second, "aw"));
 
+			publish_launch_state(arg, "launched");
+
 			cef_ui.close_browser();
 		});
 
-		cef_ui.add_command("launch-ghosts", [&cef_ui](const rapidjson::Value& value, auto&)
+		cef_ui.add_command<std::string>("launch-ghosts", [&cef_ui](const std::string& arg)
 		{
-			if (!value.IsString())
-			{
-				return;
-			}
-
-			const auto arg = std::string{ value.GetString() };
-
 			static const std::unordered_map<std::string, std::string> arg_mapping = {
 				{"ghosts-sp", "-singleplayer"},
 				{"ghosts-mp", "-multiplayer"},
@@ -181,23 +225,23 @@ namespace
 				return;
 			}
 
+			publish_launch_state(arg, "launching");
+
+			// The game reads its settings from the properties file
+			utils::properties::flush();
+
 			SetEnvironmentVariableA("XLABS_GHOSTS_INSTALL", ghosts_install->data());
 
 			const auto iw6x_exe = utils::properties::get_appdata_path() / "data" / "iw6x" / "iw6x.exe";
 			utils::nt::launch_process(iw6x_exe, get_launch_options(mapped_arg->second, "ghost"));
 
+			publish_launch_state(arg, "launched");
+
 			cef_ui.close_browser();
 		});
 
-		cef_ui.add_command("launch-mw2", [&cef_ui](const rapidjson::Value& value, auto&)
+		cef_ui.add_command<std::string>("launch-mw2", [&cef_ui](const std::string& arg)
 		{
-			if (!value.IsString())
-			{
-				return;
-			}
-
-			const auto arg = std::string{ value.GetString() };
-
 			static const std::unordered_map<std::string, std::string> arg_mapping = {
 				{"mw2-sp", "-singleplayer"},
 				{"mw2-mp", "-multiplayer"},
@@ -220,8 +264,14 @@ namespace
 				return;
 			}
 
+			publish_launch_state(arg, "updating");
 			updater::update_iw4x();
 
+			publish_launch_state(arg, "launching");
+
+			// The game reads its settings from the properties file
+			utils::properties::flush();
+
 			SetEnvironmentVariableA("XLABS_MW2_INSTALL", mw2_install->data());
 
 			// Until MP changes it way of loading this is the only way
@@ -241,6 +291,8 @@ namespace
 				utils::nt::launch_process(iw4x_exe, get_launch_options(mapped_arg->second, "mw2-sp"));
 			}
 
+			publish_launch_state(arg, "launched");
+
 			cef_ui.close_browser();
 		});
 
@@ -262,35 +314,27 @@ namespace
 
 		cef_ui.add_command("minimize", [&cef_ui](const auto&, auto&)
 		{
-			ShowWindow(cef_ui.get_window(), SW_MINIMIZE);
+			cef::cef_ui::post_to_ui([&cef_ui]()
+			{
+				ShowWindow(cef_ui.get_window(), SW_MINIMIZE);
+			});
 		});
 
 		cef_ui.add_command("show", [&cef_ui](const auto&, auto&)
 		{
-			auto* const window = cef_ui.get_window();
-			ShowWindow(window, SW_SHOWDEFAULT);
-			SetForegroundWindow(window);
+			cef::cef_ui::post_to_ui([&cef_ui]()
+			{
+				auto* const window = cef_ui.get_window();
+				ShowWindow(window, SW_SHOWDEFAULT);
+				SetForegroundWindow(window);
 
-			PostMessageA(window, WM_DELAYEDDPICHANGE, 0, 0);
+				PostMessageA(window, WM_DELAYEDDPICHANGE, 0, 0);
+			});
 		});
 
-		cef_ui.add_command("get-property", [](const rapidjson::Value& value, rapidjson::Document& response)
+		cef_ui.add_command<std::string>("get-property", [](const std::string& key)
 		{
-			response.SetNull();
-
-			if (!value.IsString())
-			{
-				return;
-			}
-
-			const auto key = std::string{ value.GetString() };
-			const auto property = utils::properties::load(key);
-			if (!property)
-			{
-				return;
-			}
-
-			response.SetString(*property, response.GetAllocator());
+			return utils::properties::load(key);
 		});
 
 		cef_ui.add_command("set-property", [](const rapidjson::Value& value, auto&)
@@ -300,20 +344,19 @@ namespace
 				return;
 			}
 
-			const auto _ = utils::properties::lock();
-
-			for (auto i = value.MemberBegin(); i != value.MemberEnd(); ++i)
+			// Values that are not strings are skipped, the rest is still stored
+			std::map<std::string, std::string> properties{};
+			for (const auto& member : value.GetObject())
 			{
-				if (!i->value.IsString())
+				if (member.value.IsString())
 				{
-					continue;
+					properties.insert_or_assign(
+						std::string{member.name.GetString(), member.name.GetStringLength()},
+						std::string{member.value.GetString(), member.value.GetStringLength()});
 				}
-
-				const auto key = std::string{ i->name.GetString() };
-				const auto val = std::string{ i->value.GetString() };
-
-				utils::properties::store(key, val);
 			}
+
+			utils::properties::store_many(properties);
 		});
 
 		cef_ui.add_command("get-channel", [](auto&, rapidjson::Document& response)
@@ -335,18 +378,28 @@ namespace
 
 			utils::at_exit([command_line]
 			{
+				utils::properties::flush();
 				utils::nt::relaunch_self(command_line);
 			});
 
 			cef_ui.close_browser();
 		});
+
+		cef_ui.add_command("get-metrics", [](auto&, rapidjson::Document& response)
+		{
+			utils::json::encode(utils::metrics::get_snapshot(), response);
+		});
 	}
 
 	void show_window(const utils::nt::library& process, const std::filesystem::path& path)
 	{
+		utils::tracing::span span{"show_window"};
+
 		cef::cef_ui cef_ui{process, path};
 		add_commands(cef_ui);
 		cef_ui.create(path / "data" / "launcher-ui", "main.html");
+
+		span.end();
 		cef::cef_ui::work();
 	}
 }
@@ -366,6 +419,8 @@ int CALLBACK WinMain(const HINSTANCE instance, HINSTANCE, LPSTR, int)
 			return run_subprocess(lib, path);
 		}
 
+		enable_tracing();
+		save_metrics_on_exit();
 		enable_dpi_awareness();
 
 #if defined(CI_BUILD) && !defined(DEBUG)
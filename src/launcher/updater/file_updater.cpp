@@ -5,10 +5,14 @@
 #include "file_updater.hpp"
 
 #include <utils/cryptography.hpp>
+#include <utils/file_cleanup.hpp>
+#include <utils/finally.hpp>
 #include <utils/http.hpp>
 #include <utils/io.hpp>
 #include <utils/logger.hpp>
 #include <utils/compression.hpp>
+#include <utils/scheduler.hpp>
+#include <utils/tracing.hpp>
 
 #include <rapidjson/writer.h>
 
@@ -23,6 +27,7 @@
 #define UPDATE_HOST_BINARY "xlabs.exe"
 
 #define IW4X_VERSION_FILE ".version.json"
+#define IW4X_RAWFILES_STAGING_FOLDER ".rawfiles-staging"
 #define IW4X_RAWFILES_UPDATE_FILE "release.zip"
 #define IW4X_RAWFILES_UPDATE_URL "https://github.com/XLabsProject/iw4x-rawfiles/releases/latest/download/" IW4X_RAWFILES_UPDATE_FILE
 #define IW4X_RAWFILES_TAGS "https://api.github.com/repos/XLabsProject/iw4x-rawfiles/releases/latest"
@@ -82,6 +87,8 @@ namespace updater
 
 		std::vector<file_info> get_file_infos()
 		{
+			const utils::tracing::span span{"get_file_infos"};
+
 			const auto json = utils::http::get_data(get_update_file() + get_cache_buster());
 			if (!json)
 			{
@@ -109,18 +116,77 @@ namespace updater
 			return nullptr;
 		}
 
-		size_t get_optimal_concurrent_download_count(const size_t file_count)
+		utils::file_cleanup::path_index build_path_index(const std::vector<file_info>& files)
+		{
+			std::vector<std::string> names{};
+			names.reserve(files.size());
+
+			for (const auto& file : files)
+			{
+				if (file.name != UPDATE_HOST_BINARY)
+				{
+					names.emplace_back(file.name);
+				}
+			}
+
+			return utils::file_cleanup::path_index{names};
+		}
+
+		std::filesystem::path get_trash_folder(const std::filesystem::path& base)
 		{
-			size_t cores = std::thread::hardware_concurrency();
-			cores = (cores * 2) / 3;
-			return std::max(1ull, std::min(cores, file_count));
+			return base / "user" / "trash";
 		}
 
-		bool is_inside_folder(const std::filesystem::path& file, const std::filesystem::path& folder)
+		std::string get_trash_session_name()
 		{
-			const auto relative = std::filesystem::relative(file, folder);
-			const auto start = relative.begin();
-			return start != relative.end() && start->string() != "..";
+			return std::format("{}-{}", GetCurrentProcessId(), GetTickCount64());
+		}
+
+		// Renames are cheap and rarely fail, should one fail anyway the revision file is not written
+		// and the next run deploys the archive again
+		void move_staged_files(const std::filesystem::path& staging, const std::filesystem::path& target)
+		{
+			// Collected first, the folder is not modified while it is enumerated
+			std::vector<std::filesystem::directory_entry> entries{};
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(staging))
+			{
+				entries.emplace_back(entry);
+			}
+
+			for (const auto& entry : entries)
+			{
+				const auto target_path = target / entry.path().lexically_relative(staging);
+				if (entry.is_directory())
+				{
+					std::filesystem::create_directories(target_path);
+					continue;
+				}
+
+				std::error_code code{};
+				std::filesystem::rename(entry.path(), target_path, code);
+				if (code)
+				{
+					throw std::runtime_error(std::format("Failed to move {} into place: {}", target_path.string(),
+					                                     code.message()));
+				}
+			}
+		}
+
+		void purge_trash_folder(const std::filesystem::path& trash_folder)
+		{
+			if (!utils::io::directory_exists(trash_folder))
+			{
+				return;
+			}
+
+			// Includes sessions of previous runs that were terminated before they finished purging
+			std::thread([trash_folder]()
+			{
+				SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+				std::error_code code{};
+				std::filesystem::remove_all(trash_folder, code);
+			}).detach();
 		}
 	}
 
@@ -130,6 +196,7 @@ namespace updater
 		  , base_(std::move(base))
 		  , process_file_(std::move(process_file))
 		  , dead_process_file_(process_file_)
+		  , trash_session_folder_(get_trash_folder(base_) / get_trash_session_name())
 	{
 		this->dead_process_file_.replace_extension(".exe.old");
 		this->delete_old_process_file();
@@ -143,6 +210,8 @@ namespace updater
 			this->cleanup_directories(files);
 		}
 
+		purge_trash_folder(get_trash_folder(this->base_));
+
 		const auto outdated_files = this->get_outdated_files(files);
 		if (outdated_files.empty())
 		{
@@ -153,57 +222,62 @@ namespace updater
 		this->update_files(outdated_files);
 	}
 
-	void file_updater::update_file(const file_info& file, const bool iw4x_file) const
+	void file_updater::update_file(const file_info& file) const
 	{
-		auto url = get_update_folder() + file.name + "?" + file.hash;
-		utils::logger::write("Updating file {}", url);
+		const utils::tracing::span span{"update_file"};
 
-		if (iw4x_file)
-		{
-			url = file.name;
-			utils::logger::write("This is an iw4x file, the url has been swapped to {}", url);
-		}
+		const auto url = get_update_folder() + file.name + "?" + file.hash;
+		utils::logger::write_deferred<"Updating file {}">(url);
 
+		const auto token = this->listener_.get_cancellation_token();
 		const auto data = utils::http::get_data(url, {}, [&](const size_t progress)
 		{
 			this->listener_.file_progress(file, progress);
-		});
+		}, 2, token);
 
-		// IW4x files have invalid hash and size for now
-		if (!data || (!iw4x_file && (data->size() != file.size || get_hash(*data) != file.hash)))
+		if (token.is_cancelled())
 		{
-			throw std::runtime_error("Failed to download: " + url);
+			throw update_cancelled();
 		}
 
-		auto out_file = this->get_drive_filename(file);
-
-		// IW4x hack to fetch release from github
-		if (iw4x_file)
+		if (!data || data->size() != file.size || get_hash(*data) != file.hash)
 		{
-			out_file = this->base_ / std::filesystem::path(file.name).filename().string();
+			throw std::runtime_error("Failed to download: " + url);
 		}
 
-		utils::logger::write("Writing file to {}", out_file.string());
+		const auto out_file = this->get_drive_filename(file);
+
+		utils::logger::log_deferred<utils::logger::level::debug, "Writing file to {}">(out_file.string());
 
-		if (!utils::io::write_file(out_file.string(), *data, false))
+		// Other launcher instances may still have the file open, the UI pack stays mapped for example
+		if (!utils::io::replace_file(out_file.string(), *data))
 		{
-			utils::logger::write("Failed to write {}. Error code: ", file.name,
+			utils::logger::error("Failed to write {}. Error code: ", file.name,
 			                     std::system_category().message(static_cast<int>(::GetLastError())));
 			throw std::runtime_error("Failed to write: " + file.name);
 		}
 
-		utils::logger::write("Done updating file {}", file.name);
+		utils::logger::log_deferred<utils::logger::level::debug, "Done updating file {}">(file.name);
 	}
 
 	std::vector<file_info> file_updater::get_outdated_files(const std::vector<file_info>& files) const
 	{
+		const utils::tracing::span span{"get_outdated_files"};
+
+		// Reading and hashing is spread over the I/O workers, the result keeps the order of the list
+		std::vector<char> outdated(files.size());
+		utils::concurrency::parallel_for(utils::concurrency::get_io_scheduler(), 0, files.size(), [&](const size_t index)
+		{
+			outdated[index] = this->is_outdated_file(files[index]);
+		}, 1);
+
 		std::vector<file_info> outdated_files{};
 
-		for (const auto& info : files)
+		for (size_t i = 0; i < files.size(); ++i)
 		{
-			if (this->is_outdated_file(info))
+			if (outdated[i])
 			{
-				outdated_files.emplace_back(info);
+				outdated_files.emplace_back(files[i]);
 			}
 		}
 
@@ -212,6 +286,8 @@ namespace updater
 
 	void file_updater::update_host_binary(const std::vector<file_info>& outdated_files) const
 	{
+		const utils::tracing::span span{"update_host_binary"};
+
 		const auto* host_file = find_host_file_info(outdated_files);
 		if (!host_file)
 		{
@@ -235,6 +311,8 @@ namespace updater
 
 	bool file_updater::does_iw4x_require_update(iw4x_update_state& update_state) const
 	{
+		const utils::tracing::span span{"does_iw4x_require_update"};
+
 		const std::filesystem::path iw4x_basegame_directory(this->base_);
 		const std::filesystem::path revision_file_path = iw4x_basegame_directory / IW4X_VERSION_FILE;
 
@@ -323,7 +401,7 @@ namespace updater
 		}
 		else
 		{
-			utils::logger::write("Error while writing file! {}",
+			utils::logger::error("Error while writing file! {}",
 			                     std::system_category().message(static_cast<int>(::GetLastError())));
 		}
 	}
@@ -334,16 +412,6 @@ namespace updater
 
 		if (does_iw4x_require_update(update_state))
 		{
-			std::vector<file_info> files_to_update{};
-
-			if (update_state.rawfile_requires_update)
-			{
-				files_to_update.emplace_back(IW4X_RAWFILES_UPDATE_URL);
-			}
-
-			utils::logger::write("Updating iw4x files");
-			update_files(files_to_update, true);
-
 			if (update_state.rawfile_requires_update)
 			{
 				utils::logger::write("Deploying iw4x rawfiles");
@@ -357,91 +425,74 @@ namespace updater
 
 	void file_updater::deploy_iw4x_rawfiles() const
 	{
-		const auto rawfiles_zip = base_ / IW4X_RAWFILES_UPDATE_FILE;
+		const utils::tracing::span span{"deploy_iw4x_rawfiles"};
 
-		if (!utils::io::file_exists(rawfiles_zip.string()))
-		{
-			// The zip was absent when it was expected, should we throw for this?
-			throw std::runtime_error(
-				"I'm supposed to deploy rawfiles from " + rawfiles_zip.generic_string() + ", but where is it?");
-		}
+		// The archive is extracted while it is still downloading, it never touches the disk as a whole.
+		// Extraction goes into a staging folder next to the game files, a failed or cancelled download leaves
+		// the game folder untouched. Staged files are only renamed into place once the archive is complete
+		const auto staging = this->base_ / IW4X_RAWFILES_STAGING_FOLDER;
 
-		// the goal is now to unzip rawfiles_zip into base_
-		utils::compression::decompress(rawfiles_zip, base_);
+		std::error_code code{};
+		std::filesystem::remove_all(staging, code);
 
-		const auto has_removed_file = utils::io::remove_file(rawfiles_zip);
-		if (has_removed_file)
+		const auto _ = utils::finally([&staging]()
 		{
-			utils::logger::write("Successfully removed file {}", rawfiles_zip.string());
-		}
-		else
-		{
-			throw std::runtime_error(
-				"Failed to remove " + rawfiles_zip.string() + ". Error code: " + std::to_string(::GetLastError()));
-		}
-	}
+			std::error_code remove_code{};
+			std::filesystem::remove_all(staging, remove_code);
+		});
 
-	void file_updater::update_files(const std::vector<file_info>& outdated_files, const bool iw4x_files) const
-	{
-		this->listener_.update_files(outdated_files);
+		file_info rawfiles{};
+		rawfiles.name = IW4X_RAWFILES_UPDATE_FILE;
 
-		const auto thread_count = get_optimal_concurrent_download_count(outdated_files.size());
+		this->listener_.update_files({rawfiles});
+		this->listener_.begin_file(rawfiles);
 
-		std::vector<std::thread> threads{};
-		std::atomic<size_t> current_index{0};
+		utils::compression::zip::stream_extractor extractor{staging};
 
-		utils::concurrency::container<std::exception_ptr> exception{};
+		const auto token = this->listener_.get_cancellation_token();
+		const auto downloaded = utils::http::download(IW4X_RAWFILES_UPDATE_URL, [&](const char* data, const size_t length)
+		{
+			extractor.write(data, length);
+		}, {}, [&](const size_t progress)
+		{
+			this->listener_.file_progress(rawfiles, progress);
+		}, token);
 
-		for (size_t i = 0; i < thread_count; ++i)
+		if (token.is_cancelled())
 		{
-			threads.emplace_back([&]()
-			{
-				while (!exception.access<bool>([](const std::exception_ptr& ptr)
-				{
-					return static_cast<bool>(ptr);
-				}))
-				{
-					const auto index = current_index++;
-					if (index >= outdated_files.size())
-					{
-						break;
-					}
-
-					try
-					{
-						const auto& file = outdated_files[index];
-						this->listener_.begin_file(file);
-						this->update_file(file, iw4x_files);
-						this->listener_.end_file(file);
-					}
-					catch (...)
-					{
-						exception.access([](std::exception_ptr& ptr)
-						{
-							ptr = std::current_exception();
-						});
-
-						return;
-					}
-				}
-			});
+			throw update_cancelled();
 		}
 
-		for (auto& thread : threads)
+		if (!downloaded)
 		{
-			if (thread.joinable())
-			{
-				thread.join();
-			}
+			throw std::runtime_error("Failed to download: " IW4X_RAWFILES_UPDATE_URL);
 		}
 
-		exception.access([](const std::exception_ptr& ptr)
+		extractor.finish();
+		move_staged_files(staging, this->base_);
+
+		this->listener_.end_file(rawfiles);
+		this->listener_.done_update();
+
+		utils::logger::write("Deployed iw4x rawfiles to {}", this->base_.string());
+	}
+
+	void file_updater::update_files(const std::vector<file_info>& outdated_files) const
+	{
+		const utils::tracing::span span{"update_files"};
+
+		this->listener_.update_files(outdated_files);
+
+		// Downloads block, so they run on the I/O workers. The first failure cancels the files
+		// that have not started yet and is rethrown here
+		utils::concurrency::parallel_for(utils::concurrency::get_io_scheduler(), 0, outdated_files.size(),
+		                                 [&](const size_t index)
 		{
-			if (ptr)
-			{
-				std::rethrow_exception(ptr);
-			}
-		});
+			const auto& file = outdated_files[index];
+			this->listener_.begin_file(file);
+			this->update_file(file);
+			this->listener_.end_file(file);
+		}, 1);
 
 		this->listener_.done_update();
 	}
@@ -493,6 +544,8 @@ namespace updater
 
 	void file_updater::delete_old_process_file() const
 	{
+		const utils::tracing::span span{"delete_old_process_file"};
+
 		// Wait for other process to die
 		for (auto i = 0; i < 4; ++i)
 		{
@@ -508,17 +561,27 @@ namespace updater
 
 	void file_updater::cleanup_directories(const std::vector<file_info>& files) const
 	{
+		const utils::tracing::span span{"cleanup_directories"};
+
 		if (!utils::io::directory_exists(this->base_))
 		{
 			return;
 		}
 
+		const auto start = std::chrono::steady_clock::now();
+
 		this->cleanup_root_directory();
 		this->cleanup_data_directory(files);
+
+		const auto duration = std::chrono::steady_clock::now() - start;
+		utils::logger::write("Cleaned up directories in {}",
+		                     std::chrono::duration_cast<std::chrono::milliseconds>(duration));
 	}
 
 	void file_updater::cleanup_root_directory() const
 	{
+		std::vector<std::filesystem::path> stale_files{};
+
 		const auto existing_files = utils::io::list_files(this->base_);
 		for (const auto& file : existing_files)
 		{
@@ -528,9 +591,10 @@ namespace updater
 				continue;
 			}
 
-			std::error_code code{};
-			std::filesystem::remove_all(file, code);
+			stale_files.emplace_back(file);
 		}
+
+		this->move_to_trash(stale_files);
 	}
 
 	void file_updater::cleanup_data_directory(const std::vector<file_info>& files) const
@@ -541,44 +605,11 @@ namespace updater
 			return;
 		}
 
-		std::vector<std::filesystem::path> legal_files{};
-		legal_files.reserve(files.size());
-		for (const auto& file : files)
-		{
-			if (file.name != UPDATE_HOST_BINARY)
-			{
-				legal_files.emplace_back(std::filesystem::absolute(base / file.name));
-			}
-		}
-
-		const auto existing_files = utils::io::list_files(base.string(), true);
-		for (auto& file : existing_files)
-		{
-			const auto is_file = std::filesystem::is_regular_file(file);
-			const auto is_folder = std::filesystem::is_directory(file);
-
-			if (is_file || is_folder)
-			{
-				bool is_legal = false;
-
-				for (const auto& legal_file : legal_files)
-				{
-					if ((is_folder && is_inside_folder(legal_file, file)) ||
-						(is_file && legal_file == file))
-					{
-						is_legal = true;
-						break;
-					}
-				}
-
-				if (is_legal)
-				{
-					continue;
-				}
-			}
+		this->move_to_trash(utils::file_cleanup::find_stale_entries(base, build_path_index(files)));
+	}
 
-			std::error_code code{};
-			std::filesystem::remove_all(file, code);
-		}
+	void file_updater::move_to_trash(const std::vector<std::filesystem::path>& files) const
+	{
+		utils::file_cleanup::move_to_trash(files, this->trash_session_folder_, this->trashed_files_);
 	}
 }
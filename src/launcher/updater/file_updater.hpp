@@ -16,7 +16,7 @@ namespace updater
 		void update_host_binary(const std::vector<file_info>& outdated_files) const;
 
 		void update_iw4x_if_necessary() const;
-		void update_files(const std::vector<file_info>& outdated_files, bool iw4x_files = false) const;
+		void update_files(const std::vector<file_info>& outdated_files) const;
 
 	private:
 
@@ -31,8 +31,10 @@ namespace updater
 		std::filesystem::path base_;
 		std::filesystem::path process_file_;
 		std::filesystem::path dead_process_file_;
+		std::filesystem::path trash_session_folder_;
+		mutable size_t trashed_files_{0};
 
-		void update_file(const file_info& file, bool iw4x_files = false) const;
+		void update_file(const file_info& file) const;
 
 		[[nodiscard]] bool is_outdated_file(const file_info& file) const;
 		[[nodiscard]] std::filesystem::path get_drive_filename(const file_info& file) const;
@@ -50,5 +52,6 @@ namespace updater
 		void cleanup_directories(const std::vector<file_info>& files) const;
 		void cleanup_root_directory() const;
 		void cleanup_data_directory(const std::vector<file_info>& files) const;
+		void move_to_trash(const std::vector<std::filesystem::path>& files) const;
 	};
 }
@@ -2,6 +2,8 @@
 
 #include "file_info.hpp"
 
+#include <utils/cancellation.hpp>
+
 namespace updater
 {
 	class progress_listener
@@ -16,5 +18,8 @@ namespace updater
 		virtual void end_file(const file_info& file) = 0;
 
 		virtual void file_progress(const file_info& file, size_t progress) = 0;
+
+		// Aborts running transfers once the update is cancelled
+		virtual utils::concurrency::cancellation_token get_cancellation_token() const = 0;
 	};
 }
@@ -7,6 +7,7 @@
 #include <version.hpp>
 
 #include <utils/properties.hpp>
+#include <utils/tracing.hpp>
 
 namespace updater
 {
@@ -36,6 +37,8 @@ namespace updater
 
 	void run(const std::filesystem::path& base)
 	{
+		const utils::tracing::span span{"updater::run"};
+
 		const utils::nt::library self;
 		const auto self_file = self.get_path();
 
@@ -44,11 +47,14 @@ namespace updater
 
 		file_updater.run();
 
+		const utils::tracing::span sleep_span{"sleep"};
 		std::this_thread::sleep_for(1s);
 	}
 
 	void update_iw4x()
 	{
+		const utils::tracing::span span{"update_iw4x"};
+
 		const auto mw2_install = utils::properties::load("mw2-install");
 		if (!mw2_install)
 		{
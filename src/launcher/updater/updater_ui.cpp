@@ -2,177 +2,293 @@
 #include "updater_ui.hpp"
 #include "update_cancelled.hpp"
 
+#include <utils/events.hpp>
 #include <utils/string.hpp>
+#include <utils/tracing.hpp>
 
 namespace updater
 {
+	namespace
+	{
+		constexpr auto refresh_interval = 100ms;
+
+		// Weight of the newest sample in the smoothed transfer rate
+		constexpr auto rate_smoothing = 0.2;
+
+		std::string format_size(const double size)
+		{
+			if (size >= 1024.0 * 1024.0)
+			{
+				return utils::string::va("%.1f MB", size / (1024.0 * 1024.0));
+			}
+
+			return utils::string::va("%.0f KB", size / 1024.0);
+		}
+	}
+
 	updater_ui::updater_ui() = default;
-	updater_ui::~updater_ui() = default;
+
+	updater_ui::~updater_ui()
+	{
+		this->stop_ui_thread();
+	}
 
 	void updater_ui::update_files(const std::vector<file_info>& files)
 	{
 		this->handle_cancellation();
+		this->stop_ui_thread();
 
-		std::lock_guard<std::recursive_mutex> _{this->mutex_};
-		this->total_files_ = files;
-		this->downloaded_files_.clear();
-		this->downloading_files_.clear();
+		this->files_ = files;
+		this->file_indices_.clear();
+		this->transfers_ = std::make_unique<transfer[]>(files.size());
+		this->total_size_ = 0;
+
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			this->file_indices_[files[i].name] = i;
+			this->total_size_ += files[i].size;
+		}
+
+		this->downloaded_size_ = 0;
+		this->downloaded_files_ = 0;
+		this->last_file_ = no_file;
 
 		this->progress_ui_ = {};
 		this->progress_ui_.set_title("X Labs Updater");
 		this->progress_ui_.show();
+
+		this->start_ui_thread();
 	}
 
 	void updater_ui::done_update()
 	{
-		std::lock_guard<std::recursive_mutex> _{this->mutex_};
+		this->stop_ui_thread();
+		this->render();
 
 		this->progress_ui_.set_progress(1, 1);
-		this->update_file_name();
 
-		this->total_files_.clear();
-		this->downloaded_files_.clear();
-		this->downloading_files_.clear();
+		rapidjson::Document event{};
+		event.SetObject();
+		utils::events::publish("update-done", event);
+
+		this->files_.clear();
+		this->file_indices_.clear();
+		this->transfers_ = {};
 	}
 
 	void updater_ui::begin_file(const file_info& file)
 	{
 		this->handle_cancellation();
 
-		std::lock_guard<std::recursive_mutex> _{this->mutex_};
-
-		this->file_progress(file, 0);
-		this->update_file_name();
+		if (auto* transfer = this->get_transfer(file))
+		{
+			transfer->active = true;
+		}
 	}
 
 	void updater_ui::end_file(const file_info& file)
 	{
-		std::lock_guard<std::recursive_mutex> _{this->mutex_};
-
-		this->downloaded_files_.emplace_back(file);
-		const auto entry = this->downloading_files_.find(file.name);
-		if (entry != this->downloading_files_.end())
+		auto* transfer = this->get_transfer(file);
+		if (!transfer)
 		{
-			this->downloading_files_.erase(entry);
-		}
-		else
-		{
-			assert(false && "Failed to erase file.");
+			assert(false && "Unknown file.");
+			return;
 		}
 
-		this->update_progress();
-		this->update_file_name();
+		this->add_progress(*transfer, file.size);
+		transfer->active = false;
+
+		this->last_file_ = static_cast<size_t>(transfer - this->transfers_.get());
+		++this->downloaded_files_;
 	}
 
 	void updater_ui::file_progress(const file_info& file, const size_t progress)
 	{
 		this->handle_cancellation();
 
-		std::lock_guard<std::recursive_mutex> _{this->mutex_};
+		if (auto* transfer = this->get_transfer(file))
+		{
+			this->add_progress(*transfer, progress);
+		}
+	}
 
-		this->downloading_files_[file.name] = {progress, file.size};
-		this->update_progress();
+	utils::concurrency::cancellation_token updater_ui::get_cancellation_token() const
+	{
+		return this->cancellation_.get_token();
 	}
 
 	void updater_ui::handle_cancellation() const
 	{
-		if (this->progress_ui_.is_cancelled())
+		if (this->cancellation_.is_cancelled())
 		{
 			throw update_cancelled();
 		}
 	}
 
-	void updater_ui::update_progress() const
+	updater_ui::transfer* updater_ui::get_transfer(const file_info& file) const
+	{
+		const auto entry = this->file_indices_.find(file.name);
+		if (entry == this->file_indices_.end())
+		{
+			return nullptr;
+		}
+
+		return &this->transfers_[entry->second];
+	}
+
+	void updater_ui::add_progress(transfer& transfer, const size_t progress)
 	{
-		std::lock_guard<std::recursive_mutex> _{this->mutex_};
-		this->progress_ui_.set_progress(this->get_downloaded_size(), this->get_total_size());
+		// Retries start over at 0, the wrapping difference then takes bytes back off the total
+		const auto previous = transfer.progress.exchange(progress, std::memory_order_relaxed);
+		this->downloaded_size_.fetch_add(progress - previous, std::memory_order_relaxed);
 	}
 
-	void updater_ui::update_file_name() const
+	void updater_ui::start_ui_thread()
 	{
-		std::lock_guard<std::recursive_mutex> _{this->mutex_};
+		this->stopping_ = false;
+		this->sample_time_ = std::chrono::steady_clock::now();
+		this->sample_size_ = 0;
+		this->rate_ = 0.0;
+		this->file_name_.clear();
+		this->rendered_files_ = no_file;
+
+		this->ui_thread_ = std::thread([this]()
+		{
+			this->run_ui_thread();
+		});
+	}
 
-		const auto downloaded_file_count = this->get_downloaded_files();
-		const auto total_file_count = this->get_total_files();
+	void updater_ui::stop_ui_thread()
+	{
+		{
+			std::lock_guard<std::mutex> _{this->mutex_};
+			this->stopping_ = true;
+		}
+
+		this->condition_variable_.notify_all();
 
-		if (downloaded_file_count == total_file_count)
+		if (this->ui_thread_.joinable())
 		{
-			this->progress_ui_.set_line(1, "Update successful.");
+			this->ui_thread_.join();
 		}
-		else
+	}
+
+	void updater_ui::run_ui_thread()
+	{
+		utils::tracing::set_thread_name("updater ui");
+
+		std::unique_lock<std::mutex> lock{this->mutex_};
+
+		while (!this->condition_variable_.wait_for(lock, refresh_interval, [this]()
 		{
-			this->progress_ui_.set_line(1, utils::string::va("Updating files... (%zu/%zu)", downloaded_file_count,
-			                                                 total_file_count));
+			return this->stopping_;
+		}))
+		{
+			lock.unlock();
+
+			// Transfers abort on their next progress tick once the source is cancelled
+			if (this->progress_ui_.is_cancelled())
+			{
+				this->cancellation_.cancel();
+			}
+
+			this->render();
+
+			lock.lock();
 		}
+	}
 
-		this->progress_ui_.set_line(2, this->get_relevant_file_name());
+	void updater_ui::render()
+	{
+		this->render_progress(this->downloaded_size_.load(std::memory_order_relaxed));
+		this->render_file_name(this->downloaded_files_.load(std::memory_order_relaxed));
 	}
 
-	size_t updater_ui::get_total_size() const
+	void updater_ui::render_progress(const size_t downloaded_size)
 	{
-		std::lock_guard<std::recursive_mutex> _{this->mutex_};
+		const auto now = std::chrono::steady_clock::now();
+		const auto elapsed = std::chrono::duration<double>(now - this->sample_time_).count();
 
-		size_t total_size = 0;
-		for (const auto& file : this->total_files_)
+		if (elapsed > 0.0)
 		{
-			total_size += file.size;
+			// Retried transfers take their bytes back off the total, the rate is clamped instead of wrapping
+			const auto delta = static_cast<int64_t>(downloaded_size) - static_cast<int64_t>(this->sample_size_);
+			const auto rate = static_cast<double>(std::max(delta, int64_t{0})) / elapsed;
+			this->rate_ = this->rate_ > 0.0 ? this->rate_ + rate_smoothing * (rate - this->rate_) : rate;
 		}
 
-		return total_size;
+		this->sample_time_ = now;
+		this->sample_size_ = downloaded_size;
+
+		this->progress_ui_.set_progress(downloaded_size, this->total_size_);
+
+		const auto remaining = this->total_size_ > downloaded_size ? this->total_size_ - downloaded_size : 0;
+		const auto eta = this->rate_ > 0.0 ? static_cast<double>(remaining) / this->rate_ : 0.0;
+
+		rapidjson::Document event{};
+		event.SetObject();
+		event.AddMember("downloaded", static_cast<uint64_t>(downloaded_size), event.GetAllocator());
+		event.AddMember("total", static_cast<uint64_t>(this->total_size_), event.GetAllocator());
+		event.AddMember("rate", this->rate_, event.GetAllocator());
+		event.AddMember("eta", eta, event.GetAllocator());
+
+		// Coalesced per subscriber, so frequent updates never queue up
+		utils::events::publish("update-progress", event);
 	}
 
-	size_t updater_ui::get_downloaded_size() const
+	void updater_ui::render_file_name(const size_t downloaded_files)
 	{
-		std::lock_guard<std::recursive_mutex> _{this->mutex_};
+		const auto total_files = this->files_.size();
 
-		size_t downloaded_size = 0;
-		for (const auto& file : this->downloaded_files_)
+		if (downloaded_files == total_files)
+		{
+			this->progress_ui_.set_line(1, "Update successful.");
+		}
+		else
 		{
-			downloaded_size += file.size;
+			this->progress_ui_.set_line(1, utils::string::va("Updating files... (%zu/%zu, %s/s)", downloaded_files,
+			                                                 total_files, format_size(this->rate_).data()));
 		}
 
-		for (const auto& file : this->downloading_files_)
+		auto file_name = this->get_relevant_file_name();
+		if (downloaded_files == this->rendered_files_ && file_name == this->file_name_)
 		{
-			downloaded_size += file.second.first;
+			return;
 		}
 
-		return downloaded_size;
-	}
+		this->progress_ui_.set_line(2, file_name);
 
-	size_t updater_ui::get_total_files() const
-	{
-		std::lock_guard<std::recursive_mutex> _{this->mutex_};
-		return this->total_files_.size();
-	}
+		rapidjson::Document event{};
+		event.SetObject();
+		event.AddMember("downloaded", static_cast<uint64_t>(downloaded_files), event.GetAllocator());
+		event.AddMember("total", static_cast<uint64_t>(total_files), event.GetAllocator());
+		event.AddMember("file", rapidjson::Value(file_name, event.GetAllocator()), event.GetAllocator());
 
-	size_t updater_ui::get_downloaded_files() const
-	{
-		std::lock_guard<std::recursive_mutex> _{this->mutex_};
-		return this->downloaded_files_.size();
+		utils::events::publish("update-files", event);
+
+		this->rendered_files_ = downloaded_files;
+		this->file_name_ = std::move(file_name);
 	}
 
 	std::string updater_ui::get_relevant_file_name() const
 	{
-		std::lock_guard<std::recursive_mutex> _{this->mutex_};
-
-		std::string name{};
 		auto smallest = std::numeric_limits<size_t>::max();
+		auto index = no_file;
 
-		for (const auto& file : this->downloading_files_)
+		for (size_t i = 0; i < this->files_.size(); ++i)
 		{
-			const auto max_size = file.second.second;
-			if (max_size < smallest)
+			if (this->transfers_[i].active.load(std::memory_order_relaxed) && this->files_[i].size < smallest)
 			{
-				smallest = max_size;
-				name = file.first;
+				smallest = this->files_[i].size;
+				index = i;
 			}
 		}
 
-		if (name.empty() && !this->downloaded_files_.empty())
+		if (index == no_file)
 		{
-			name = this->downloaded_files_.back().name;
+			index = this->last_file_.load(std::memory_order_relaxed);
 		}
 
-		return name;
+		return index == no_file ? std::string{} : this->files_[index].name;
 	}
 }
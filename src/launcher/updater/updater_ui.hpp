@@ -3,7 +3,8 @@
 #include "progress_ui.hpp"
 #include "progress_listener.hpp"
 
-#include <utils/concurrency.hpp>
+#include <condition_variable>
+#include <thread>
 
 namespace updater
 {
@@ -14,12 +15,38 @@ namespace updater
 		~updater_ui();
 
 	private:
-		mutable std::recursive_mutex mutex_;
-		std::vector<file_info> total_files_{};
-		std::vector<file_info> downloaded_files_{};
-		std::unordered_map<std::string, std::pair<size_t, size_t>> downloading_files_{};
+		static constexpr size_t no_file = std::numeric_limits<size_t>::max();
+
+		struct alignas(64) transfer
+		{
+			std::atomic<size_t> progress{0};
+			std::atomic_bool active{false};
+		};
 
 		progress_ui progress_ui_{};
+		utils::concurrency::cancellation_source cancellation_{};
+
+		// Set up by update_files before any transfer starts and only read while files are updating
+		std::vector<file_info> files_{};
+		std::unordered_map<std::string, size_t> file_indices_{};
+		std::unique_ptr<transfer[]> transfers_{};
+		size_t total_size_{};
+
+		std::atomic<size_t> downloaded_size_{0};
+		std::atomic<size_t> downloaded_files_{0};
+		std::atomic<size_t> last_file_{no_file};
+
+		std::mutex mutex_{};
+		std::condition_variable condition_variable_{};
+		bool stopping_{false};
+		std::thread ui_thread_{};
+
+		// Only touched by the UI thread, or while it is not running
+		std::chrono::steady_clock::time_point sample_time_{};
+		size_t sample_size_{};
+		double rate_{};
+		std::string file_name_{};
+		size_t rendered_files_{no_file};
 
 		void update_files(const std::vector<file_info>& files) override;
 		void done_update() override;
@@ -29,15 +56,19 @@ namespace updater
 
 		void file_progress(const file_info& file, size_t progress) override;
 
+		utils::concurrency::cancellation_token get_cancellation_token() const override;
+
 		void handle_cancellation() const;
-		void update_progress() const;
-		void update_file_name() const;
+		transfer* get_transfer(const file_info& file) const;
+		void add_progress(transfer& transfer, size_t progress);
 
-		size_t get_total_size() const;
-		size_t get_downloaded_size() const;
+		void start_ui_thread();
+		void stop_ui_thread();
+		void run_ui_thread();
 
-		size_t get_total_files() const;
-		size_t get_downloaded_files() const;
+		void render();
+		void render_progress(size_t downloaded_size);
+		void render_file_name(size_t downloaded_files);
 
 		std::string get_relevant_file_name() const;
 	};
@@ -0,0 +1,96 @@
+#include "test.hpp"
+
+#include <utils/asset_pack.hpp>
+#include <utils/io.hpp>
+
+namespace
+{
+	std::string build_pack(const std::filesystem::path& folder, const std::string& content)
+	{
+		utils::io::write_file((folder / "ui" / "main.html").string(), content);
+		return utils::asset_pack::build(folder / "ui");
+	}
+}
+
+TEST_CASE(asset_pack_can_be_replaced_while_mapped)
+{
+	const tests::temporary_folder folder{};
+	const auto file = folder.get_path() / "launcher-ui.pack";
+
+	EXPECT(utils::io::write_file(file.string(), build_pack(folder.get_path(), "old")));
+
+	// Like a launcher instance that is still running while another one updates the pack
+	const utils::asset_pack mapped{file};
+	EXPECT(utils::io::replace_file(file.string(), build_pack(folder.get_path(), "new")));
+
+	EXPECT(mapped.read(*mapped.find("main.html")) == "old");
+
+	const utils::asset_pack updated{file};
+	EXPECT(updated.read(*updated.find("main.html")) == "new");
+}
+
+TEST_CASE(asset_pack_round_trips_stored_and_compressed_entries)
+{
+	const tests::temporary_folder folder{};
+	const auto ui = folder.get_path() / "ui";
+
+	const std::string script(100000, 'j');
+	EXPECT(utils::io::write_file((ui / "main.html").string(), "<html>"));
+	EXPECT(utils::io::write_file((ui / "js/main.js").string(), script));
+	EXPECT(utils::io::write_file((ui / "empty.css").string(), {}));
+
+	for (const auto compress : {false, true})
+	{
+		const utils::asset_pack pack{utils::asset_pack::build(ui, compress)};
+		EXPECT(pack.get_entries().size() == 3);
+
+		const auto entry = pack.find("./js/../js/main.js");
+		EXPECT(entry && entry->path == "js/main.js" && entry->size == script.size());
+		EXPECT(pack.read(*entry) == script);
+		EXPECT((entry->compression == utils::asset_pack::compression_type::zstd) == compress);
+
+		EXPECT(pack.read(*pack.find("main.html")) == "<html>");
+		EXPECT(pack.read(*pack.find("empty.css")).empty());
+		EXPECT(!pack.find("js"));
+		EXPECT(!pack.find("missing.html"));
+	}
+}
+
+TEST_CASE(asset_pack_rejects_truncated_and_corrupt_data)
+{
+	const tests::temporary_folder folder{};
+	const auto pack = build_pack(folder.get_path(), "content");
+
+	const auto rejects = [](std::string data)
+	{
+		try
+		{
+			const utils::asset_pack parsed{std::move(data)};
+			for (const auto& entry : parsed.get_entries())
+			{
+				parsed.read(entry);
+			}
+
+			return false;
+		}
+		catch (const std::exception&)
+		{
+			return true;
+		}
+	};
+
+	EXPECT(!rejects(pack));
+	EXPECT(rejects({}));
+	EXPECT(rejects("not an asset pack"));
+
+	// Cut anywhere before the end of the entry data
+	const auto data_end = pack.find("content") + 7;
+	for (size_t size = 0; size < data_end; ++size)
+	{
+		EXPECT(rejects(pack.substr(0, size)));
+	}
+
+	auto corrupt = pack;
+	corrupt[0] ^= 1;
+	EXPECT(rejects(corrupt));
+}
@@ -0,0 +1,80 @@
+#include "test.hpp"
+
+#include <utils/byte_range.hpp>
+
+namespace
+{
+	utils::range_status parse(const std::string_view header, const uint64_t size, utils::byte_range& range)
+	{
+		range = {};
+		return utils::parse_range(header, size, range);
+	}
+}
+
+TEST_CASE(byte_range_parses_closed_range)
+{
+	utils::byte_range range{};
+	EXPECT(parse("bytes=10-19", 100, range) == utils::range_status::satisfiable);
+	EXPECT(range.offset == 10 && range.length == 10);
+
+	// The end is clamped to the resource
+	EXPECT(parse("bytes=90-200", 100, range) == utils::range_status::satisfiable);
+	EXPECT(range.offset == 90 && range.length == 10);
+}
+
+TEST_CASE(byte_range_parses_open_range)
+{
+	utils::byte_range range{};
+	EXPECT(parse("bytes=40-", 100, range) == utils::range_status::satisfiable);
+	EXPECT(range.offset == 40 && range.length == 60);
+
+	EXPECT(parse(" bytes=0- ", 100, range) == utils::range_status::satisfiable);
+	EXPECT(range.offset == 0 && range.length == 100);
+}
+
+TEST_CASE(byte_range_parses_suffix_range)
+{
+	utils::byte_range range{};
+	EXPECT(parse("bytes=-30", 100, range) == utils::range_status::satisfiable);
+	EXPECT(range.offset == 70 && range.length == 30);
+
+	// Suffixes longer than the resource select all of it
+	EXPECT(parse("bytes=-500", 100, range) == utils::range_status::satisfiable);
+	EXPECT(range.offset == 0 && range.length == 100);
+}
+
+TEST_CASE(byte_range_ignores_multiple_ranges)
+{
+	utils::byte_range range{};
+	EXPECT(parse("bytes=0-9,20-29", 100, range) == utils::range_status::none);
+	EXPECT(parse("bytes=-5, 10-", 100, range) == utils::range_status::none);
+}
+
+TEST_CASE(byte_range_ignores_malformed_headers)
+{
+	utils::byte_range range{};
+	EXPECT(parse("", 100, range) == utils::range_status::none);
+	EXPECT(parse("items=0-9", 100, range) == utils::range_status::none);
+	EXPECT(parse("bytes=9-0", 100, range) == utils::range_status::none);
+	EXPECT(parse("bytes=a-9", 100, range) == utils::range_status::none);
+	EXPECT(parse("bytes=-", 100, range) == utils::range_status::none);
+	EXPECT(parse("bytes=5", 100, range) == utils::range_status::none);
+}
+
+TEST_CASE(byte_range_detects_unsatisfiable_ranges)
+{
+	utils::byte_range range{};
+	EXPECT(parse("bytes=100-", 100, range) == utils::range_status::unsatisfiable);
+	EXPECT(parse("bytes=150-199", 100, range) == utils::range_status::unsatisfiable);
+	EXPECT(parse("bytes=-0", 100, range) == utils::range_status::unsatisfiable);
+	EXPECT(parse("bytes=0-", 0, range) == utils::range_status::unsatisfiable);
+
+	// Used for the 416 response
+	EXPECT(utils::get_content_range({}, 100) == "bytes */100");
+}
+
+TEST_CASE(byte_range_formats_content_range)
+{
+	EXPECT(utils::get_content_range({10, 10}, 100) == "bytes 10-19/100");
+	EXPECT(utils::get_content_range({0, 1}, 1) == "bytes 0-0/1");
+}
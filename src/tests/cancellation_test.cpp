@@ -0,0 +1,185 @@
+#include "test.hpp"
+
+#include <utils/cancellation.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+TEST_CASE(cancellation_default_token_is_never_cancelled)
+{
+	const utils::concurrency::cancellation_token token{};
+	EXPECT(!token.can_be_cancelled());
+	EXPECT(!token.is_cancelled());
+
+	auto called = false;
+	const auto registration = token.register_callback([&called]()
+	{
+		called = true;
+	});
+
+	EXPECT(!called);
+}
+
+TEST_CASE(cancellation_runs_callbacks_once_on_the_cancelling_thread)
+{
+	const utils::concurrency::cancellation_source source{};
+	const auto token = source.get_token();
+
+	std::thread::id callback_thread{};
+	auto calls = 0;
+
+	const auto registration = token.register_callback([&]()
+	{
+		callback_thread = std::this_thread::get_id();
+		++calls;
+	});
+
+	EXPECT(!token.is_cancelled());
+
+	std::thread([&source]()
+	{
+		source.cancel();
+		source.cancel();
+	}).join();
+
+	EXPECT(token.is_cancelled());
+	EXPECT(calls == 1);
+	EXPECT(callback_thread != std::this_thread::get_id());
+}
+
+TEST_CASE(cancellation_runs_late_callbacks_right_away)
+{
+	const utils::concurrency::cancellation_source source{};
+	source.cancel();
+
+	auto called = false;
+	const auto registration = source.get_token().register_callback([&called]()
+	{
+		called = true;
+	});
+
+	EXPECT(called);
+}
+
+TEST_CASE(cancellation_skips_reset_registrations)
+{
+	const utils::concurrency::cancellation_source source{};
+
+	auto called = false;
+	auto registration = source.get_token().register_callback([&called]()
+	{
+		called = true;
+	});
+
+	registration.reset();
+	source.cancel();
+
+	EXPECT(!called);
+}
+
+TEST_CASE(cancellation_reset_waits_for_running_callback)
+{
+	const utils::concurrency::cancellation_source source{};
+
+	std::atomic_bool started{false};
+	std::atomic_bool finished{false};
+
+	auto registration = source.get_token().register_callback([&]()
+	{
+		started = true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		finished = true;
+	});
+
+	std::thread canceller([&source]()
+	{
+		source.cancel();
+	});
+
+	while (!started)
+	{
+		std::this_thread::yield();
+	}
+
+	// Whatever the callback uses may be destroyed right after the registration
+	registration.reset();
+	EXPECT(finished);
+
+	canceller.join();
+}
+
+TEST_CASE(cancellation_callback_can_reset_its_own_registration)
+{
+	const utils::concurrency::cancellation_source source{};
+
+	utils::concurrency::cancellation_registration registration{};
+	registration = source.get_token().register_callback([&registration]()
+	{
+		registration.reset();
+	});
+
+	source.cancel();
+	EXPECT(source.is_cancelled());
+}
+
+BENCHMARK(cancellation_poll_and_notify)
+{
+	constexpr size_t iterations = 10000000;
+
+	const utils::concurrency::cancellation_source source{};
+	const auto token = source.get_token();
+
+	// What progress_ui::is_cancelled used to be: a flag behind a mutex
+	std::mutex mutex{};
+	auto flag = false;
+
+	size_t observed = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		observed += token.is_cancelled();
+	}
+
+	const auto token_time = std::chrono::steady_clock::now() - start;
+	start = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		std::lock_guard<std::mutex> _{mutex};
+		observed += flag;
+	}
+
+	const auto mutex_time = std::chrono::steady_clock::now() - start;
+
+	printf("poll: token %.2f ns, mutex flag %.2f ns\n",
+	       std::chrono::duration<double, std::nano>(token_time).count() / iterations,
+	       std::chrono::duration<double, std::nano>(mutex_time).count() / iterations);
+
+	constexpr size_t rounds = 1000;
+	std::vector<double> latencies{};
+	latencies.reserve(rounds);
+
+	for (size_t i = 0; i < rounds; ++i)
+	{
+		const utils::concurrency::cancellation_source round_source{};
+		std::atomic<int64_t> notified{0};
+
+		auto registration = round_source.get_token().register_callback([&notified]()
+		{
+			notified = std::chrono::steady_clock::now().time_since_epoch().count();
+		});
+
+		const auto cancel_time = std::chrono::steady_clock::now();
+		round_source.cancel();
+
+		const auto latency = std::chrono::steady_clock::duration(notified.load()) - cancel_time.time_since_epoch();
+		latencies.emplace_back(std::chrono::duration<double, std::nano>(latency).count());
+	}
+
+	printf("cancel to callback: p50 %.0f ns, p99 %.0f ns (%zu)\n", tests::get_percentile(latencies, 0.5),
+	       tests::get_percentile(latencies, 0.99), observed);
+}
@@ -0,0 +1,188 @@
+#include "test.hpp"
+
+#include <utils/commands.hpp>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+	// Shaped like the launcher's get-property and set-property commands, without touching the properties file
+	utils::commands::handlers make_handlers()
+	{
+		utils::commands::handlers handlers{};
+		handlers["get-property"] = [](const rapidjson::Value& request, rapidjson::Document& response)
+		{
+			response.SetNull();
+
+			if (request.IsString())
+			{
+				const auto value = "value:" + std::string{request.GetString(), request.GetStringLength()};
+				response.SetString(value, response.GetAllocator());
+			}
+		};
+
+		handlers["set-property"] = [](const rapidjson::Value& request, rapidjson::Document& response)
+		{
+			if (!request.IsObject())
+			{
+				response.SetNull();
+				return;
+			}
+
+			uint64_t stored = 0;
+			for (const auto& member : request.GetObject())
+			{
+				stored += member.value.IsString();
+			}
+
+			response.SetUint64(stored);
+		};
+
+		handlers["fail"] = [](const rapidjson::Value&, rapidjson::Document&)
+		{
+			throw std::runtime_error("failed");
+		};
+
+		return handlers;
+	}
+
+	std::string execute(const utils::commands::handlers& handlers, std::string json, const bool batch)
+	{
+		std::string response{};
+		utils::commands::execute(handlers, json, batch, response);
+		return response;
+	}
+
+	// What a command request did before: a DOM parse that copies every string, a std::string for the lookup
+	// and a StringBuffer that is copied into the response. Its two log lines per command are left out
+	using copied_handlers = std::unordered_map<std::string, utils::commands::handler>;
+
+	void execute_copied(const copied_handlers& handlers, const std::string& json, std::string& response)
+	{
+		rapidjson::Document doc{};
+		doc.Parse(json.data(), json.size());
+
+		rapidjson::Document command_response{};
+		command_response.SetObject();
+
+		if (doc.IsObject())
+		{
+			const auto command = doc.FindMember("command");
+			const auto data = doc.FindMember("data");
+
+			if (command != doc.MemberEnd() && command->value.IsString())
+			{
+				const std::string command_name{command->value.GetString(), command->value.GetStringLength()};
+
+				const auto handler = handlers.find(command_name);
+				if (handler != handlers.end())
+				{
+					const rapidjson::Value null_value{};
+					handler->second(data != doc.MemberEnd() ? data->value : null_value, command_response);
+				}
+			}
+		}
+
+		rapidjson::StringBuffer buffer{};
+		rapidjson::Writer<rapidjson::StringBuffer, rapidjson::Document::EncodingType, rapidjson::ASCII<>>
+			writer(buffer);
+		command_response.Accept(writer);
+
+		response.assign(buffer.GetString(), buffer.GetLength());
+	}
+}
+
+TEST_CASE(commands_answer_single_requests)
+{
+	const auto handlers = make_handlers();
+
+	EXPECT(execute(handlers, R"({"command":"get-property","data":"channel"})", false) == R"("value:channel")");
+	EXPECT(execute(handlers, R"({"command":"get-property"})", false) == "null");
+	EXPECT(execute(handlers, R"({"command":"set-property","data":{"a":"1","b":2,"c":"3"}})", false) == "2");
+
+	// Responses are plain ASCII
+	EXPECT(execute(handlers, "{\"command\":\"get-property\",\"data\":\"\xC3\xA9\"}", false) ==
+		R"("value:\u00E9")");
+
+	// Anything that does not reach a handler, or fails in it, is answered with an empty object
+	for (const auto* request : {R"({"command":"missing"})", R"({"command":5})", R"(["get-property"])", "{",
+	                            R"({"command":"fail"})", ""})
+	{
+		EXPECT(execute(handlers, request, false) == "{}");
+	}
+}
+
+TEST_CASE(command_batches_are_answered_in_order)
+{
+	const auto handlers = make_handlers();
+
+	const auto response = execute(handlers, R"([{"command":"get-property","data":"a"},{"command":"missing"},)"
+	                              R"({"command":"fail"},5,{"command":"get-property","data":"b"}])", true);
+	EXPECT(response == R"(["value:a",{},{},{},"value:b"])");
+
+	EXPECT(execute(handlers, "[]", true) == "[]");
+	EXPECT(execute(handlers, R"({"command":"get-property","data":"a"})", true) == "[]");
+}
+
+BENCHMARK(command_throughput)
+{
+	constexpr size_t command_count = 200000;
+	constexpr size_t batch_size = 10;
+
+	const auto handlers = make_handlers();
+	const copied_handlers old_handlers{handlers.begin(), handlers.end()};
+
+	// The UI reads and writes a few properties at a time
+	const std::string get_request = R"({"command":"get-property","data":"launcher.channel"})";
+	const std::string set_request = R"({"command":"set-property","data":{"launcher.channel":"main",)"
+		R"("launcher.language":"english","launcher.window-width":"1280","launcher.window-height":"720"}})";
+
+	std::string batch_request = "[";
+	for (size_t i = 0; i < batch_size; ++i)
+	{
+		batch_request += (i ? "," : "") + (i % 2 ? set_request : get_request);
+	}
+
+	batch_request += "]";
+
+	// Every request gets its own copy of the body, like the post data each one arrives with
+	const auto measure = [&](const char* name, const size_t commands_per_request, const auto& run)
+	{
+		std::string response{};
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < command_count; i += commands_per_request)
+		{
+			response.clear();
+			run(i, response);
+			EXPECT(!response.empty());
+		}
+
+		const auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("  %-28s %10.0f commands/s\n", name, static_cast<double>(command_count) / duration);
+	};
+
+	printf("%zu commands, half get-property and half set-property:\n", command_count);
+	measure("copied DOM, one per request", 1, [&](const size_t i, std::string& response)
+	{
+		const auto json = i % 2 ? set_request : get_request;
+		execute_copied(old_handlers, json, response);
+	});
+
+	measure("in situ, one per request", 1, [&](const size_t i, std::string& response)
+	{
+		auto json = i % 2 ? set_request : get_request;
+		utils::commands::execute(handlers, json, false, response);
+	});
+
+	measure("in situ, batches of 10", batch_size, [&](size_t, std::string& response)
+	{
+		auto json = batch_request;
+		utils::commands::execute(handlers, json, true, response);
+	});
+}
@@ -0,0 +1,342 @@
+#include "test.hpp"
+
+#include <utils/compression.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace
+{
+	struct zstd_codec
+	{
+		using compress_stream = utils::compression::zstd::compress_stream;
+		using decompress_stream = utils::compression::zstd::decompress_stream;
+
+		static std::string compress(const std::string_view data)
+		{
+			return utils::compression::zstd::compress(data);
+		}
+
+		static std::string decompress(const std::string_view data,
+		                              const size_t max_size = utils::compression::default_max_size)
+		{
+			return utils::compression::zstd::decompress(data, max_size);
+		}
+	};
+
+	struct lz4_codec
+	{
+		using compress_stream = utils::compression::lz4::compress_stream;
+		using decompress_stream = utils::compression::lz4::decompress_stream;
+
+		static std::string compress(const std::string_view data)
+		{
+			return utils::compression::lz4::compress(data);
+		}
+
+		static std::string decompress(const std::string_view data,
+		                              const size_t max_size = utils::compression::default_max_size)
+		{
+			return utils::compression::lz4::decompress(data, max_size);
+		}
+	};
+
+	std::string make_input(const size_t size)
+	{
+		std::string data(size, 'a');
+		for (size_t i = 0; i < size; i += 7)
+		{
+			data[i] = static_cast<char>(i * 31);
+		}
+
+		return data;
+	}
+
+	template <typename Stream>
+	std::string run_stream(const std::string& data, const size_t piece_size)
+	{
+		std::string result{};
+		Stream stream([&result](const char* chunk, const size_t length)
+		{
+			result.append(chunk, length);
+		});
+
+		for (size_t offset = 0; offset < data.size(); offset += piece_size)
+		{
+			stream.write(data.data() + offset, std::min(piece_size, data.size() - offset));
+		}
+
+		stream.finish();
+		return result;
+	}
+
+	template <typename Codec>
+	void check_round_trips()
+	{
+		// Outputs that exactly fill the streams' buffers (64 KB for lz4, 128 KB for zstd) used to lose the frame end
+		for (const size_t size : {0, 10, 64 * 1024, 128 * 1024, 300000, 1024 * 1024})
+		{
+			const auto input = make_input(size);
+			EXPECT(Codec::decompress(Codec::compress(input)) == input);
+
+			const auto compressed = run_stream<typename Codec::compress_stream>(input, 4096);
+			EXPECT(Codec::decompress(compressed) == input);
+			EXPECT(run_stream<typename Codec::decompress_stream>(compressed, 1000) == input);
+		}
+	}
+
+	template <typename Codec>
+	void check_truncation()
+	{
+		const auto compressed = Codec::compress(make_input(100000));
+		const auto truncated = compressed.substr(0, compressed.size() / 2);
+
+		auto rejected = false;
+		try
+		{
+			run_stream<typename Codec::decompress_stream>(truncated, truncated.size());
+		}
+		catch (const std::exception&)
+		{
+			rejected = true;
+		}
+
+		EXPECT(rejected);
+	}
+
+	template <typename Codec>
+	bool decompresses_within(const std::string& compressed, const size_t max_size)
+	{
+		try
+		{
+			Codec::decompress(compressed, max_size);
+			return true;
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+	}
+
+	template <typename Codec>
+	void check_output_limit()
+	{
+		const auto input = make_input(300000);
+
+		// The one-shot frame declares its size, the streamed one does not and is bounded while it is decoded
+		for (const auto& compressed : {Codec::compress(input), run_stream<typename Codec::compress_stream>(input, 4096)})
+		{
+			EXPECT(decompresses_within<Codec>(compressed, input.size()));
+			EXPECT(!decompresses_within<Codec>(compressed, input.size() - 1));
+			EXPECT(!decompresses_within<Codec>(compressed, 1000));
+		}
+	}
+}
+
+TEST_CASE(zstd_round_trips_at_buffer_boundaries)
+{
+	check_round_trips<zstd_codec>();
+}
+
+TEST_CASE(lz4_round_trips_at_buffer_boundaries)
+{
+	check_round_trips<lz4_codec>();
+}
+
+TEST_CASE(decompress_streams_reject_truncated_frames)
+{
+	check_truncation<zstd_codec>();
+	check_truncation<lz4_codec>();
+}
+
+TEST_CASE(decompress_rejects_output_beyond_limit)
+{
+	check_output_limit<zstd_codec>();
+	check_output_limit<lz4_codec>();
+}
+
+namespace
+{
+	constexpr size_t sample_size = 4 * 1024 * 1024;
+
+	// A file manifest like the one the updater downloads
+	std::string make_manifest(const size_t size, std::mt19937_64& random)
+	{
+		std::string data = "[";
+		for (size_t i = 0; data.size() < size; ++i)
+		{
+			char entry[256]{};
+			snprintf(entry, sizeof(entry),
+			         R"({"name":"data/folder-%zu/file-%zu.iwd","size":%llu,"hash":"%016llx%016llx%08llx"},)", i % 64, i,
+			         static_cast<unsigned long long>(random() % 100000000),
+			         static_cast<unsigned long long>(random()), static_cast<unsigned long long>(random()),
+			         static_cast<unsigned long long>(random() % 0x100000000));
+			data += entry;
+		}
+
+		data.resize(size);
+		return data;
+	}
+
+	// Launcher and game log lines
+	std::string make_log(const size_t size, std::mt19937_64& random)
+	{
+		constexpr std::array messages{
+			"Downloading file", "Verified hash of", "Loaded fastfile", "Connection to master server timed out for",
+			"Updated revision of",
+		};
+
+		std::string data{};
+		for (size_t i = 0; data.size() < size; ++i)
+		{
+			char line[256]{};
+			snprintf(line, sizeof(line), "[%02zu:%02zu:%02zu.%03zu] [%zu] %s data/folder-%zu/file-%zu.iwd\n", i / 3600000 % 24,
+			         i / 60000 % 60, i / 1000 % 60, i % 1000, static_cast<size_t>(random() % 8),
+			         messages[random() % messages.size()], static_cast<size_t>(random() % 64),
+			         static_cast<size_t>(random() % 100000));
+			data += line;
+		}
+
+		data.resize(size);
+		return data;
+	}
+
+	// Vertex positions and normals of a noisy height field, like the meshes in game assets
+	std::string make_mesh(const size_t size, std::mt19937_64& random)
+	{
+		std::uniform_real_distribution<float> noise{-0.05f, 0.05f};
+
+		std::string data{};
+		for (size_t i = 0; data.size() < size; ++i)
+		{
+			const auto x = static_cast<float>(i % 512);
+			const auto y = static_cast<float>(i / 512);
+			const std::array<float, 6> vertex{
+				x, y, std::sin(x * 0.05f) * std::cos(y * 0.05f) * 32.0f + noise(random), noise(random), noise(random), 1.0f,
+			};
+
+			data.append(reinterpret_cast<const char*>(vertex.data()), sizeof(vertex));
+		}
+
+		data.resize(size);
+		return data;
+	}
+
+	// Already compressed content, such as images and audio
+	std::string make_noise(const size_t size, std::mt19937_64& random)
+	{
+		std::string data(size, '\0');
+		for (auto& c : data)
+		{
+			c = static_cast<char>(random());
+		}
+
+		return data;
+	}
+
+	double get_throughput(const size_t size, const std::chrono::steady_clock::duration duration)
+	{
+		return static_cast<double>(size) / (1024.0 * 1024.0) / std::chrono::duration<double>(duration).count();
+	}
+
+	template <typename Codec, typename Compress>
+	void measure_codec(const std::string& name, const std::string& data, const Compress& compress)
+	{
+		auto start = std::chrono::steady_clock::now();
+		const auto compressed = compress(data);
+		const auto compress_time = std::chrono::steady_clock::now() - start;
+
+		start = std::chrono::steady_clock::now();
+		const auto decompressed = Codec::decompress(compressed);
+		const auto decompress_time = std::chrono::steady_clock::now() - start;
+
+		EXPECT(decompressed == data);
+		printf("  %-7s ratio %6.2f, compress %7.1f MB/s, decompress %7.1f MB/s\n", name.c_str(),
+		       static_cast<double>(data.size()) / static_cast<double>(compressed.size()),
+		       get_throughput(data.size(), compress_time), get_throughput(data.size(), decompress_time));
+	}
+}
+
+BENCHMARK(codec_throughput_and_ratio)
+{
+	std::mt19937_64 random{1};
+
+	for (const auto& [name, data] : {
+		     std::pair{"manifest", make_manifest(sample_size, random)}, std::pair{"log", make_log(sample_size, random)},
+		     std::pair{"mesh", make_mesh(sample_size, random)}, std::pair{"noise", make_noise(sample_size, random)},
+	     })
+	{
+		printf("%s, %zu bytes:\n", name, data.size());
+
+		for (const auto level : {1, 3, 9, 19})
+		{
+			measure_codec<zstd_codec>("zstd " + std::to_string(level), data, [level](const std::string& input)
+			{
+				return utils::compression::zstd::compress(input, level);
+			});
+		}
+
+		for (const auto level : {0, 9})
+		{
+			measure_codec<lz4_codec>("lz4 " + std::to_string(level), data, [level](const std::string& input)
+			{
+				return utils::compression::lz4::compress(input, level);
+			});
+		}
+	}
+
+	// Inputs of 8 MB and more are compressed on all hardware threads
+	const auto large = make_log(4 * sample_size, random);
+	printf("log, %zu bytes, %u hardware threads:\n", large.size(), std::thread::hardware_concurrency());
+	measure_codec<zstd_codec>("zstd 3", large, zstd_codec::compress);
+}
+
+BENCHMARK(dictionary_ratio_on_small_records)
+{
+	std::mt19937_64 random{2};
+
+	// Single manifest entries, compressed one by one as a cache would store them
+	std::vector<std::string> records{};
+	for (size_t i = 0; i < 10000; ++i)
+	{
+		records.emplace_back(make_manifest(200, random));
+	}
+
+	const std::vector<std::string> samples{records.begin(), records.begin() + 2000};
+	const utils::compression::zstd::dictionary zstd_dictionary{utils::compression::zstd::dictionary::train(samples)};
+	const utils::compression::lz4::dictionary lz4_dictionary{zstd_dictionary.get_data()};
+
+	size_t input_size = 0;
+	size_t plain_size = 0;
+	size_t zstd_size = 0;
+	size_t lz4_size = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+	for (const auto& record : records)
+	{
+		input_size += record.size();
+		plain_size += utils::compression::zstd::compress(record).size();
+
+		const auto compressed = utils::compression::zstd::compress(record, zstd_dictionary);
+		EXPECT(utils::compression::zstd::decompress(compressed, zstd_dictionary) == record);
+		zstd_size += compressed.size();
+
+		const auto lz4_compressed = utils::compression::lz4::compress(record, lz4_dictionary);
+		EXPECT(utils::compression::lz4::decompress(lz4_compressed, lz4_dictionary) == record);
+		lz4_size += lz4_compressed.size();
+	}
+
+	const auto duration = std::chrono::steady_clock::now() - start;
+
+	printf("%zu records of %zu bytes: zstd ratio %.2f, with dictionary %.2f, lz4 with dictionary %.2f (%.0f ms)\n",
+	       records.size(), records.front().size(), static_cast<double>(input_size) / static_cast<double>(plain_size),
+	       static_cast<double>(input_size) / static_cast<double>(zstd_size),
+	       static_cast<double>(input_size) / static_cast<double>(lz4_size),
+	       std::chrono::duration<double, std::milli>(duration).count());
+}
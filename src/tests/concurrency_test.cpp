@@ -0,0 +1,121 @@
+#include "test.hpp"
+
+#include <utils/concurrency.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+	// Shaped like the updater's progress state, wider than one atomic word
+	struct progress
+	{
+		uint64_t downloaded{};
+		uint64_t total{};
+		uint64_t files{};
+	};
+
+	bool is_consistent(const progress& value)
+	{
+		return value.total == value.downloaded && value.files == value.downloaded;
+	}
+
+	void advance(progress& value)
+	{
+		++value.downloaded;
+		value.total = value.downloaded;
+		value.files = value.downloaded;
+	}
+
+	// One writer keeps advancing the value while the readers check every copy they get
+	template <typename Container>
+	double run_contention(const size_t readers, const size_t reads, bool& consistent)
+	{
+		Container container{};
+		std::atomic_size_t remaining_readers{readers};
+		std::atomic_bool torn{false};
+
+		const auto seconds = tests::run_on_threads(readers + 1, [&](const size_t index)
+		{
+			if (index == readers)
+			{
+				while (remaining_readers)
+				{
+					container.access([](progress& value)
+					{
+						advance(value);
+					});
+
+					std::this_thread::yield();
+				}
+
+				return;
+			}
+
+			const auto& const_container = container;
+			for (size_t i = 0; i < reads; ++i)
+			{
+				if (!const_container.template access<bool>(is_consistent))
+				{
+					torn = true;
+				}
+			}
+
+			--remaining_readers;
+		});
+
+		consistent &= !torn;
+		return static_cast<double>(readers * reads) / seconds / 1e6;
+	}
+}
+
+TEST_CASE(seqlock_container_never_returns_torn_values)
+{
+	auto consistent = true;
+	run_contention<utils::concurrency::seqlock_container<progress>>(4, 100000, consistent);
+	EXPECT(consistent);
+}
+
+TEST_CASE(snapshot_container_never_returns_torn_values)
+{
+	auto consistent = true;
+	run_contention<utils::concurrency::snapshot_container<progress>>(4, 100000, consistent);
+	EXPECT(consistent);
+}
+
+TEST_CASE(snapshot_container_keeps_old_snapshots_alive)
+{
+	utils::concurrency::snapshot_container<progress> container{};
+	const auto before = container.get_snapshot();
+
+	container.access([](progress& value)
+	{
+		advance(value);
+	});
+
+	EXPECT(before->downloaded == 0);
+	EXPECT(container.get_snapshot()->downloaded == 1);
+}
+
+BENCHMARK(container_read_contention)
+{
+	constexpr size_t reads = 200000;
+	auto consistent = true;
+
+	printf("readers  mutex  shared_mutex  seqlock  snapshot  (M reads/s, one writer)\n");
+
+	for (const size_t readers : {1, 2, 4, 8, 16, 32, 64})
+	{
+		const auto mutex = run_contention<utils::concurrency::container<progress>>(readers, reads, consistent);
+		const auto shared = run_contention<utils::concurrency::shared_container<progress>>(readers, reads, consistent);
+		const auto seqlock = run_contention<utils::concurrency::seqlock_container<progress>>(
+			readers, reads, consistent);
+		const auto snapshot = run_contention<utils::concurrency::snapshot_container<progress>>(
+			readers, reads, consistent);
+
+		printf("%7zu  %5.1f  %12.1f  %7.1f  %8.1f\n", readers, mutex, shared, seqlock, snapshot);
+	}
+
+	EXPECT(consistent);
+}
@@ -0,0 +1,215 @@
+#include "test.hpp"
+
+#include <utils/file_cache.hpp>
+#include <utils/io.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+	void write_file(const std::filesystem::path& file, const std::string& data)
+	{
+		EXPECT(utils::io::write_file(file.string(), data));
+	}
+
+	bool wait_for_size(const utils::file_cache& cache, const size_t size)
+	{
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (cache.get_size() != size)
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+			{
+				return false;
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		return true;
+	}
+}
+
+TEST_CASE(file_cache_shares_one_buffer_between_requests)
+{
+	const tests::temporary_folder folder{};
+	write_file(folder.get_path() / "ui/main.html", "<html>");
+
+	utils::file_cache cache{folder.get_path()};
+
+	std::filesystem::file_time_type write_time{};
+	const auto first = cache.get("ui/main.html", &write_time);
+	const auto second = cache.get("./ui/../ui/main.html");
+
+	EXPECT(first && *first == "<html>");
+	EXPECT(first == second);
+	EXPECT(write_time == std::filesystem::last_write_time(folder.get_path() / "ui/main.html"));
+	EXPECT(cache.get_size() == 6);
+}
+
+TEST_CASE(file_cache_revalidates_against_size_and_write_time)
+{
+	const tests::temporary_folder folder{};
+	const auto file = folder.get_path() / "main.js";
+	write_file(file, "old");
+
+	utils::file_cache cache{folder.get_path()};
+	const auto old_content = cache.get("main.js");
+	EXPECT(old_content && *old_content == "old");
+
+	// Same size, only the write time tells the versions apart
+	const auto write_time = std::filesystem::last_write_time(file);
+	write_file(file, "new");
+	std::filesystem::last_write_time(file, write_time + std::chrono::seconds(1));
+
+	const auto new_content = cache.get("main.js");
+	EXPECT(new_content && *new_content == "new");
+	EXPECT(*old_content == "old");
+
+	write_file(file, "newer");
+	EXPECT(*cache.get("main.js") == "newer");
+	EXPECT(cache.get_size() == 5);
+
+	std::filesystem::remove(file);
+	EXPECT(!cache.get("main.js"));
+}
+
+TEST_CASE(file_cache_rejects_paths_outside_the_folder)
+{
+	const tests::temporary_folder folder{};
+	write_file(folder.get_path() / "ui/main.html", "inside");
+	write_file(folder.get_path() / "secret.txt", "outside");
+
+	utils::file_cache cache{folder.get_path() / "ui"};
+
+	for (const auto* path : {"../secret.txt", "a/../../secret.txt", ""})
+	{
+		EXPECT(!cache.get(path));
+		EXPECT(!cache.resolve(path));
+	}
+
+	// The folder itself resolves, but is not served
+	EXPECT(!cache.get("."));
+	EXPECT(!cache.get("ui/.."));
+
+	EXPECT(!cache.get("missing.html"));
+	EXPECT(cache.resolve("main.html") == folder.get_path() / "ui" / "main.html");
+}
+
+TEST_CASE(file_cache_evicts_least_recently_used_files)
+{
+	const tests::temporary_folder folder{};
+	for (const auto* name : {"a", "b", "c"})
+	{
+		write_file(folder.get_path() / name, std::string(40, *name));
+	}
+
+	write_file(folder.get_path() / "large", std::string(200, 'l'));
+
+	utils::file_cache cache{folder.get_path(), 100};
+	const auto a = cache.get("a");
+	const auto b = cache.get("b");
+	EXPECT(cache.get("a") == a);
+
+	// b was used least recently and makes room for c
+	const auto c = cache.get("c");
+	EXPECT(cache.get_size() == 80);
+	EXPECT(cache.get("a") == a);
+	EXPECT(cache.get("c") == c);
+	EXPECT(cache.get("b") != b);
+
+	// Files beyond the capacity are served without being cached
+	const auto large = cache.get("large");
+	EXPECT(large && large->size() == 200);
+	EXPECT(cache.get("large") != large);
+	EXPECT(cache.get_size() <= 100);
+}
+
+TEST_CASE(file_cache_loads_other_data_once_per_version)
+{
+	const tests::temporary_folder folder{};
+	utils::file_cache cache{folder.get_path()};
+
+	size_t loads = 0;
+	const auto load = [&loads]()
+	{
+		++loads;
+		return std::make_shared<const std::string>("packed");
+	};
+
+	const std::filesystem::file_time_type time{};
+	const auto first = cache.get("?pack/main.html", time, 6, load);
+	EXPECT(cache.get("?pack/main.html", time, 6, load) == first);
+	EXPECT(loads == 1);
+
+	cache.get("?pack/main.html", time + std::chrono::seconds(1), 6, load);
+	EXPECT(loads == 2);
+}
+
+TEST_CASE(file_cache_preload_stays_within_capacity)
+{
+	const tests::temporary_folder folder{};
+	for (size_t i = 0; i < 10; ++i)
+	{
+		write_file(folder.get_path() / ("assets/file-" + std::to_string(i)), std::string(10, 'x'));
+	}
+
+	utils::file_cache cache{folder.get_path(), 55};
+	const auto requested = cache.get("assets/file-9");
+
+	cache.preload();
+	cache.preload();
+
+	// Preloading must never push out files that were actually requested
+	EXPECT(wait_for_size(cache, 50));
+	EXPECT(cache.get("assets/file-9") == requested);
+}
+
+BENCHMARK(file_cache_request_throughput)
+{
+	constexpr size_t asset_count = 50;
+	constexpr size_t request_count = 200000;
+
+	// Sizes of the launcher UI's HTML, scripts, styles and images
+	const tests::temporary_folder folder{};
+	std::vector<std::string> assets{};
+	for (size_t i = 0; i < asset_count; ++i)
+	{
+		assets.emplace_back("ui/asset-" + std::to_string(i));
+		write_file(folder.get_path() / assets.back(), std::string(1024 << (i % 8), 'a'));
+	}
+
+	utils::file_cache cache{folder.get_path()};
+
+	for (const size_t threads : {1, 4, 16})
+	{
+		std::atomic<size_t> bytes{0};
+		const auto cached_time = tests::run_on_threads(threads, [&](const size_t index)
+		{
+			size_t served = 0;
+			for (size_t i = index; i < request_count; i += threads)
+			{
+				served += cache.get(assets[i % asset_count])->size();
+			}
+
+			bytes += served;
+		});
+
+		// What every request did before the cache: read the file and copy it into the response
+		const auto read_time = tests::run_on_threads(threads, [&](const size_t index)
+		{
+			for (size_t i = index; i < request_count; i += threads)
+			{
+				const auto data = utils::io::read_file((folder.get_path() / assets[i % asset_count]).string());
+				const std::string response{data};
+				EXPECT(response.size() == data.size());
+			}
+		});
+
+		printf("%2zu threads, %zu requests of %.0f KB on average: cached %.0f/s, read %.0f/s\n", threads,
+		       request_count, static_cast<double>(bytes) / request_count / 1024.0, request_count / cached_time,
+		       request_count / read_time);
+	}
+}
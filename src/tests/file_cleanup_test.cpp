@@ -0,0 +1,268 @@
+#include "test.hpp"
+
+#include <utils/file_cleanup.hpp>
+#include <utils/io.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+	std::vector<std::string> get_relative_keys(const std::vector<std::filesystem::path>& entries,
+	                                           const std::filesystem::path& folder)
+	{
+		std::vector<std::string> keys{};
+		for (const auto& entry : entries)
+		{
+			keys.emplace_back(utils::file_cleanup::path_index::get_key(entry.lexically_relative(folder)));
+		}
+
+		std::ranges::sort(keys);
+		return keys;
+	}
+
+	// Spread over 100 folders of 10 subfolders each, like the game's data folder
+	std::string get_file_name(const size_t index)
+	{
+		return "folder-" + std::to_string(index % 100) + "/sub-" + std::to_string(index / 100 % 10) + "/file-" +
+			std::to_string(index) + ".bin";
+	}
+
+	// What cleanup_data_directory did before the index: every entry on disk against every manifest entry
+	size_t count_stale_entries_by_scanning(const std::filesystem::path& folder, const std::vector<std::string>& files)
+	{
+		std::vector<std::filesystem::path> legal_files{};
+		for (const auto& file : files)
+		{
+			legal_files.emplace_back(std::filesystem::absolute(folder / file));
+		}
+
+		size_t stale_entries = 0;
+		for (const auto& file : utils::io::list_files(folder, true))
+		{
+			const auto is_file = std::filesystem::is_regular_file(file);
+			const auto is_folder = std::filesystem::is_directory(file);
+
+			const auto is_legal = std::ranges::any_of(legal_files, [&](const std::filesystem::path& legal_file)
+			{
+				if (is_file)
+				{
+					return legal_file == std::filesystem::absolute(file);
+				}
+
+				const auto relative = std::filesystem::relative(legal_file, file);
+				return is_folder && relative.begin() != relative.end() && relative.begin()->string() != "..";
+			});
+
+			stale_entries += !is_legal;
+		}
+
+		return stale_entries;
+	}
+
+	// Writes the stale entries: loose files in one folder, or folders holding the given number of files each
+	std::vector<std::filesystem::path> create_stale_entries(const std::filesystem::path& folder, const size_t count,
+	                                                        const size_t files_per_entry)
+	{
+		std::vector<std::filesystem::path> entries{};
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto entry = folder / ("entry-" + std::to_string(i));
+			if (files_per_entry == 1)
+			{
+				utils::io::write_file(entry.string(), {});
+			}
+
+			for (size_t j = 0; files_per_entry > 1 && j < files_per_entry; ++j)
+			{
+				utils::io::write_file((entry / ("file-" + std::to_string(j) + ".bin")).string(), {});
+			}
+
+			entries.emplace_back(std::move(entry));
+		}
+
+		return entries;
+	}
+
+	// What the update path did before the trash: every stale entry removed in place on 8 threads
+	double remove_in_place(const std::vector<std::filesystem::path>& entries)
+	{
+		std::atomic<size_t> current_index{0};
+		return tests::run_on_threads(8, [&](size_t)
+		{
+			for (auto index = current_index++; index < entries.size(); index = current_index++)
+			{
+				std::error_code code{};
+				std::filesystem::remove_all(entries[index], code);
+			}
+		});
+	}
+}
+
+TEST_CASE(path_index_lists_files_and_their_folders)
+{
+	const utils::file_cleanup::path_index index{{"a/b/c.txt", "./a/d/../e.txt", "top.txt"}};
+
+	EXPECT(index.contains_file("a/b/c.txt"));
+	EXPECT(index.contains_file("a/e.txt"));
+	EXPECT(index.contains_file("top.txt"));
+	EXPECT(!index.contains_file("a/b"));
+
+	EXPECT(index.contains_folder("a"));
+	EXPECT(index.contains_folder("a/b"));
+	EXPECT(!index.contains_folder("a/d"));
+	EXPECT(!index.contains_folder("a/b/c.txt"));
+	EXPECT(!index.contains_folder(""));
+}
+
+TEST_CASE(find_stale_entries_returns_unlisted_entries_once)
+{
+	const tests::temporary_folder folder{};
+	const auto& base = folder.get_path();
+
+	for (const auto* file : {"a/b/keep.txt", "a/b/stale.txt", "a/stale/x.txt", "a/stale/y/z.txt", "stale.txt",
+	                         "c.txt/nested.txt", "keep.txt"})
+	{
+		EXPECT(utils::io::write_file((base / file).string(), "data"));
+	}
+
+	std::filesystem::create_directories(base / "empty");
+
+	// c.txt is listed as a file but is a folder on disk
+	const utils::file_cleanup::path_index index{{"a/b/keep.txt", "keep.txt", "c.txt"}};
+	const auto stale = get_relative_keys(utils::file_cleanup::find_stale_entries(base, index), base);
+
+	EXPECT((stale == std::vector<std::string>{"a/b/stale.txt", "a/stale", "c.txt", "empty", "stale.txt"}));
+	EXPECT(utils::file_cleanup::find_stale_entries(base / "missing", index).empty());
+}
+
+TEST_CASE(move_to_trash_keeps_entries_sharing_a_name)
+{
+	const tests::temporary_folder folder{};
+	const auto& base = folder.get_path();
+
+	EXPECT(utils::io::write_file((base / "a/stale.txt").string(), "a"));
+	EXPECT(utils::io::write_file((base / "b/stale.txt").string(), "b"));
+	EXPECT(utils::io::write_file((base / "c/stale/x.txt").string(), "c"));
+
+	const auto session = base / "trash" / "session";
+	size_t trashed_entries = 3;
+	utils::file_cleanup::move_to_trash({base / "a/stale.txt", base / "b/stale.txt", base / "c/stale"}, session,
+	                                   trashed_entries);
+
+	EXPECT(trashed_entries == 6);
+	EXPECT(!std::filesystem::exists(base / "a/stale.txt"));
+	EXPECT(!std::filesystem::exists(base / "b/stale.txt"));
+	EXPECT(!std::filesystem::exists(base / "c/stale"));
+
+	std::string data{};
+	EXPECT(utils::io::read_file((session / "3").string(), &data) && data == "a");
+	EXPECT(utils::io::read_file((session / "4").string(), &data) && data == "b");
+	EXPECT(utils::io::read_file((session / "5/x.txt").string(), &data) && data == "c");
+
+	// Nothing to move does not create the session
+	utils::file_cleanup::move_to_trash({}, base / "trash" / "empty", trashed_entries);
+	EXPECT(!std::filesystem::exists(base / "trash" / "empty"));
+}
+
+BENCHMARK(stale_entry_removal)
+{
+	// Loose stale files and whole stale folders, with the same number of files each
+	for (const auto& [count, files_per_entry] : {std::pair<size_t, size_t>{50000, 1}, std::pair<size_t, size_t>{500, 100}})
+	{
+		const tests::temporary_folder folder{};
+
+		const auto removed_entries = create_stale_entries(folder.get_path() / "removed", count, files_per_entry);
+		const auto remove_time = remove_in_place(removed_entries);
+
+		const auto trashed_entries = create_stale_entries(folder.get_path() / "trashed", count, files_per_entry);
+
+		size_t trashed = 0;
+		const auto start = std::chrono::steady_clock::now();
+		utils::file_cleanup::move_to_trash(trashed_entries, folder.get_path() / "trash", trashed);
+		const auto trash_time = std::chrono::steady_clock::now() - start;
+
+		const auto purge_start = std::chrono::steady_clock::now();
+		std::error_code code{};
+		std::filesystem::remove_all(folder.get_path() / "trash", code);
+		const auto purge_time = std::chrono::steady_clock::now() - purge_start;
+
+		EXPECT(trashed == count);
+		printf("%zu entries of %zu files: removed in place %.0f ms, trashed %.0f ms and purged %.0f ms after\n", count,
+		       files_per_entry, remove_time * 1000.0, std::chrono::duration<double, std::milli>(trash_time).count(),
+		       std::chrono::duration<double, std::milli>(purge_time).count());
+	}
+}
+
+BENCHMARK(stale_file_cleanup)
+{
+	constexpr size_t file_count = 100000;
+
+	const tests::temporary_folder folder{};
+	const auto& base = folder.get_path();
+
+	// Every tenth file on disk is stale, the rest is listed in the manifest
+	std::vector<std::string> manifest{};
+	for (size_t i = 0; i < file_count; ++i)
+	{
+		const auto name = get_file_name(i);
+		utils::io::write_file((base / name).string(), {});
+
+		if (i % 10)
+		{
+			manifest.emplace_back(name);
+		}
+	}
+
+	for (size_t i = file_count; manifest.size() < file_count; ++i)
+	{
+		manifest.emplace_back(get_file_name(i));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	const utils::file_cleanup::path_index index{manifest};
+	const auto index_time = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	const auto stale = utils::file_cleanup::find_stale_entries(base, index);
+	const auto walk_time = std::chrono::steady_clock::now() - start;
+
+	EXPECT(stale.size() == file_count / 10);
+	printf("%zu manifest entries, %zu files: index %.0f ms, walk %.0f ms, %zu stale\n", manifest.size(), file_count,
+	       std::chrono::duration<double, std::milli>(index_time).count(),
+	       std::chrono::duration<double, std::milli>(walk_time).count(), stale.size());
+
+	// The scan is quadratic, it only runs on smaller trees of the same shape
+	for (const size_t count : {1000, 2000, 4000})
+	{
+		const tests::temporary_folder scan_folder{};
+
+		std::vector<std::string> scan_manifest{};
+		for (size_t i = 0; i < count; ++i)
+		{
+			const auto name = get_file_name(i);
+			utils::io::write_file((scan_folder.get_path() / name).string(), {});
+
+			if (i % 10)
+			{
+				scan_manifest.emplace_back(name);
+			}
+		}
+
+		start = std::chrono::steady_clock::now();
+		const auto scanned = count_stale_entries_by_scanning(scan_folder.get_path(), scan_manifest);
+		const auto scan_time = std::chrono::steady_clock::now() - start;
+
+		start = std::chrono::steady_clock::now();
+		const auto indexed = utils::file_cleanup::find_stale_entries(scan_folder.get_path(),
+		                                                             utils::file_cleanup::path_index{scan_manifest});
+		const auto indexed_time = std::chrono::steady_clock::now() - start;
+
+		// The scan also reports the contents of stale folders, the walk only the folders themselves
+		printf("  %zu files: old scan %.0f ms (%zu stale), index and walk %.1f ms (%zu stale)\n", count,
+		       std::chrono::duration<double, std::milli>(scan_time).count(), scanned,
+		       std::chrono::duration<double, std::milli>(indexed_time).count(), indexed.size());
+	}
+}
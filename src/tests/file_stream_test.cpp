@@ -0,0 +1,80 @@
+#include "test.hpp"
+
+#include <utils/file_stream.hpp>
+#include <utils/io.hpp>
+
+namespace
+{
+	std::filesystem::path write_test_file(const tests::temporary_folder& folder, const std::string& data)
+	{
+		const auto file = folder.get_path() / "stream.bin";
+		tests::expect(utils::io::write_file(file.string(), data), "write_test_file");
+		return file;
+	}
+}
+
+TEST_CASE(file_stream_reads_in_pieces)
+{
+	const tests::temporary_folder folder{};
+	utils::file_stream stream{write_test_file(folder, "0123456789")};
+
+	EXPECT(stream.get_size() == 10);
+
+	char buffer[4]{};
+	EXPECT(stream.read(buffer, sizeof(buffer)) == 4);
+	EXPECT(std::string(buffer, 4) == "0123");
+	EXPECT(stream.read(buffer, sizeof(buffer)) == 4);
+	EXPECT(std::string(buffer, 4) == "4567");
+	EXPECT(stream.read(buffer, sizeof(buffer)) == 2);
+	EXPECT(std::string(buffer, 2) == "89");
+	EXPECT(stream.read(buffer, sizeof(buffer)) == 0);
+	EXPECT(stream.get_position() == 10);
+}
+
+TEST_CASE(file_stream_seeks)
+{
+	const tests::temporary_folder folder{};
+	utils::file_stream stream{write_test_file(folder, "0123456789")};
+
+	char buffer[3]{};
+	stream.seek(7);
+	EXPECT(stream.read(buffer, sizeof(buffer)) == 3);
+	EXPECT(std::string(buffer, 3) == "789");
+
+	// Seeking back works after reaching the end
+	stream.seek(2);
+	EXPECT(stream.read(buffer, sizeof(buffer)) == 3);
+	EXPECT(std::string(buffer, 3) == "234");
+
+	// Positions past the end are clamped
+	stream.seek(50);
+	EXPECT(stream.get_position() == 10);
+	EXPECT(stream.read(buffer, sizeof(buffer)) == 0);
+}
+
+TEST_CASE(file_stream_handles_empty_files)
+{
+	const tests::temporary_folder folder{};
+	utils::file_stream stream{write_test_file(folder, "")};
+
+	char buffer[1]{};
+	EXPECT(stream.get_size() == 0);
+	EXPECT(stream.read(buffer, sizeof(buffer)) == 0);
+}
+
+TEST_CASE(file_stream_throws_for_missing_files)
+{
+	const tests::temporary_folder folder{};
+
+	auto thrown = false;
+	try
+	{
+		utils::file_stream stream{folder.get_path() / "missing.bin"};
+	}
+	catch (const std::exception&)
+	{
+		thrown = true;
+	}
+
+	EXPECT(thrown);
+}
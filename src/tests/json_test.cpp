@@ -0,0 +1,150 @@
+#include "test.hpp"
+
+#include <utils/json.hpp>
+
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+	struct launch_event
+	{
+		std::string game{};
+		std::optional<std::string> arguments{};
+		std::vector<uint16_t> ports{};
+
+		static constexpr auto fields = std::make_tuple(
+			utils::json::make_field("game", &launch_event::game),
+			utils::json::make_field("arguments", &launch_event::arguments),
+			utils::json::make_field("ports", &launch_event::ports));
+	};
+
+	rapidjson::Document parse(const std::string& json)
+	{
+		rapidjson::Document document{};
+		document.Parse(json.data(), json.size());
+		EXPECT(!document.HasParseError());
+		return document;
+	}
+
+	template <typename T>
+	bool decode(const std::string& json, T& out)
+	{
+		return utils::json::decode(parse(json), out);
+	}
+
+	template <typename F>
+	double get_nanoseconds_per_call(const size_t count, const F& function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < count; ++i)
+		{
+			function();
+		}
+
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+			static_cast<double>(count);
+	}
+}
+
+TEST_CASE(json_decodes_described_structs)
+{
+	launch_event event{};
+	EXPECT(decode(R"({"game":"iw6x","ports":[28960,28961],"unknown":true})", event));
+	EXPECT(event.game == "iw6x");
+	EXPECT(!event.arguments);
+	EXPECT((event.ports == std::vector<uint16_t>{28960, 28961}));
+
+	EXPECT(decode(R"({"game":"s1x","arguments":"-dedicated","ports":[]})", event));
+	EXPECT(event.arguments == "-dedicated");
+
+	// Missing required members, wrong types and numbers out of range are rejected
+	for (const auto* json : {R"({"ports":[]})", R"({"game":5,"ports":[]})", R"({"game":"a","ports":[70000]})",
+	                         R"({"game":"a","ports":[-1]})", R"({"game":"a","arguments":1,"ports":[]})", "[]"})
+	{
+		EXPECT(!decode(json, event));
+	}
+}
+
+TEST_CASE(json_encodes_what_it_decodes)
+{
+	const std::map<std::string, std::string> properties{{"launcher.channel", "main"}, {"launcher.language", "en"}};
+
+	rapidjson::Document document{};
+	utils::json::encode(properties, document);
+
+	std::map<std::string, std::string> decoded{};
+	EXPECT(utils::json::decode(document, decoded));
+	EXPECT(decoded == properties);
+
+	EXPECT(!decode(R"({"launcher.channel":"main","launcher.width":1280})", decoded));
+
+	const launch_event event{"iw6x", std::nullopt, {28960}};
+	utils::json::encode(event, document);
+
+	launch_event decoded_event{};
+	EXPECT(utils::json::decode(document, decoded_event));
+	EXPECT(decoded_event.game == "iw6x" && !decoded_event.arguments && decoded_event.ports == event.ports);
+	EXPECT(document["arguments"].IsNull());
+}
+
+BENCHMARK(typed_and_dom_decoding)
+{
+	constexpr size_t count = 1000000;
+
+	const auto key = parse(R"("launcher.channel")");
+	const auto properties = parse(R"({"launcher.channel":"main","launcher.language":"english",)"
+		R"("launcher.window-width":"1280","launcher.window-height":"720"})");
+	const std::optional<std::string> property = "main";
+
+	printf("Per command, decoding the parsed request and encoding the response:\n");
+
+	// get-property, typed: a string in, an optional string out
+	const auto typed_get = get_nanoseconds_per_call(count, [&]()
+	{
+		std::string name{};
+		EXPECT(utils::json::decode(key, name));
+
+		rapidjson::Document response{};
+		utils::json::encode(property, response);
+	});
+
+	// get-property as it was written against the DOM before
+	const auto dom_get = get_nanoseconds_per_call(count, [&]()
+	{
+		rapidjson::Document response{};
+		response.SetNull();
+
+		EXPECT(key.IsString());
+		const std::string name{key.GetString()};
+
+		response.SetString(*property, response.GetAllocator());
+	});
+
+	printf("  %-14s typed %6.1f ns, DOM %6.1f ns\n", "get-property", typed_get, dom_get);
+
+	// set-property as a typed map, which rejects the whole request for one value that is not a string
+	const auto typed_set = get_nanoseconds_per_call(count, [&]()
+	{
+		std::map<std::string, std::string> values{};
+		EXPECT(utils::json::decode(properties, values));
+	});
+
+	// set-property as it is now: checked member by member, skipping values that are not strings
+	const auto dom_set = get_nanoseconds_per_call(count, [&]()
+	{
+		std::map<std::string, std::string> values{};
+		EXPECT(properties.IsObject());
+
+		for (const auto& member : properties.GetObject())
+		{
+			if (member.value.IsString())
+			{
+				values.insert_or_assign(std::string{member.name.GetString(), member.name.GetStringLength()},
+				                        std::string{member.value.GetString(), member.value.GetStringLength()});
+			}
+		}
+	});
+
+	printf("  %-14s typed %6.1f ns, DOM %6.1f ns\n", "set-property", typed_set, dom_set);
+}
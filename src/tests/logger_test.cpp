@@ -0,0 +1,202 @@
+#include "test.hpp"
+
+#include <utils/logger.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// What utils::logger::write did before: format on the caller, then write and flush under a global lock
+	class locked_log
+	{
+	public:
+		explicit locked_log(const std::filesystem::path& file)
+			: stream_(file, std::ios_base::out | std::ios_base::trunc)
+		{
+		}
+
+		template <typename... Args>
+		void write(const std::string_view& fmt, const Args&... args)
+		{
+			const auto line = std::vformat(fmt, std::make_format_args(args...));
+
+			std::unique_lock _(this->mutex_);
+			this->stream_ << line << std::endl;
+		}
+
+	private:
+		std::mutex mutex_{};
+		std::ofstream stream_{};
+	};
+
+	// Times every call on every thread, the logging itself is up to the function
+	template <typename Log>
+	void measure_calls(const char* name, const size_t thread_count, const size_t call_count, const Log& log)
+	{
+		std::vector<std::vector<double>> thread_samples(thread_count);
+		const auto duration = tests::run_on_threads(thread_count, [&](const size_t index)
+		{
+			auto& samples = thread_samples[index];
+			samples.reserve(call_count);
+
+			for (size_t i = 0; i < call_count; ++i)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				log(index, i);
+				samples.emplace_back(std::chrono::duration<double, std::nano>(
+					std::chrono::steady_clock::now() - start).count());
+			}
+		});
+
+		std::vector<double> samples{};
+		for (const auto& entry : thread_samples)
+		{
+			samples.insert(samples.end(), entry.begin(), entry.end());
+		}
+
+		printf("  %-20s %10.0f calls/s, p50 %6.0f ns, p99 %8.0f ns\n", name,
+		       static_cast<double>(samples.size()) / duration, tests::get_percentile(samples, 0.5),
+		       tests::get_percentile(samples, 0.99));
+	}
+
+	// The text of every line in the log that starts with the marker, in the order the lines were written
+	std::vector<std::string> read_log_lines(const std::string& marker)
+	{
+		std::vector<std::string> lines{};
+		std::ifstream stream{"xlabs.log", std::ios_base::binary};
+
+		std::string line{};
+		while (std::getline(stream, line))
+		{
+			const auto position = line.find("] " + marker);
+			if (position != std::string::npos)
+			{
+				lines.emplace_back(line.substr(position + 2));
+			}
+		}
+
+		return lines;
+	}
+}
+
+TEST_CASE(deferred_records_survive_binary_ring_wraparound)
+{
+	constexpr uint64_t record_count = 3000;
+	utils::logger::set_level(utils::logger::level::info);
+
+	const auto get_filler = [](const uint64_t index)
+	{
+		return std::string(index % 251, static_cast<char>('a' + index % 26));
+	};
+
+	// A new thread starts with an empty ring. Fillers of 0 to 250 bytes wrap the 64 KB ring about 7 times:
+	// right at its end, with too little room left for a skip header, and with a skip header
+	tests::run_on_threads(1, [&](size_t)
+	{
+		for (uint64_t i = 0; i < record_count; ++i)
+		{
+			utils::logger::write_deferred<"ring-wraparound {} {}">(i, get_filler(i));
+		}
+
+		// Records larger than half the ring are formatted right away instead
+		utils::logger::flush();
+		utils::logger::write_deferred<"ring-wraparound {} {}">(record_count, std::string(40000, 'x'));
+	});
+
+	utils::logger::flush();
+
+	const auto lines = read_log_lines("ring-wraparound ");
+	EXPECT(lines.size() == record_count + 1);
+
+	for (uint64_t i = 0; i < lines.size() && i < record_count; ++i)
+	{
+		EXPECT(lines[i] == "ring-wraparound " + std::to_string(i) + " " + get_filler(i));
+	}
+
+	EXPECT(lines.back() == "ring-wraparound " + std::to_string(record_count) + " " + std::string(40000, 'x'));
+}
+
+BENCHMARK(logger_contention)
+{
+	constexpr size_t thread_count = 32;
+	constexpr size_t call_count = 10000;
+
+	const tests::temporary_folder folder{};
+	locked_log old_log{folder.get_path() / "xlabs.log"};
+
+	// Lines like the ones the updater writes per file. The logger writes to xlabs.log in the working directory
+	const std::string path = "data/images/loadscreen_mp_rust.iwi";
+	utils::logger::set_level(utils::logger::level::info);
+
+	printf("%zu threads, %zu calls each:\n", thread_count, call_count);
+	measure_calls("locked and flushed", thread_count, call_count, [&](const size_t thread, const size_t i)
+	{
+		old_log.write("Thread {}: downloading {} ({} of {})", thread, path, i, call_count);
+	});
+
+	measure_calls("logger::write", thread_count, call_count, [&](const size_t thread, const size_t i)
+	{
+		utils::logger::write("Thread {}: downloading {} ({} of {})", thread, path, i, call_count);
+	});
+
+	// The writer may still be behind, what it has left is not part of the callers' time
+	const auto start = std::chrono::steady_clock::now();
+	utils::logger::flush();
+	printf("  writer caught up %.1f ms after the last call\n",
+	       std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+BENCHMARK(deferred_logging_cost)
+{
+	// Batches stay well below the thread buffers, so callers never wait for the writer
+	constexpr size_t batch_size = 256;
+	constexpr size_t batch_count = 400;
+
+	const std::string url = "https://cdn.xlabs.dev/updater/data/images/loadscreen_mp_rust.iwi";
+	constexpr uint64_t size = 1024 * 1024;
+
+	utils::logger::set_level(utils::logger::level::info);
+
+	const auto measure = [](const char* name, const auto& log)
+	{
+		std::chrono::steady_clock::duration duration{};
+		for (size_t batch = 0; batch < batch_count; ++batch)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < batch_size; ++i)
+			{
+				log(i);
+			}
+
+			duration += std::chrono::steady_clock::now() - start;
+			utils::logger::flush();
+		}
+
+		printf("  %-24s %6.1f ns per call\n", name,
+		       std::chrono::duration<double, std::nano>(duration).count() / (batch_size * batch_count));
+	};
+
+	size_t formatted = 0;
+	printf("Per call on the logging thread:\n");
+	measure("std::format alone", [&](const size_t i)
+	{
+		formatted += std::format("Downloading {} ({} bytes, attempt {})", url, size, i).size();
+	});
+
+	measure("logger::write", [&](const size_t i)
+	{
+		utils::logger::write("Downloading {} ({} bytes, attempt {})", url, size, i);
+	});
+
+	measure("logger::write_deferred", [&](const size_t i)
+	{
+		utils::logger::write_deferred<"Downloading {} ({} bytes, attempt {})">(url, size, i);
+	});
+
+	EXPECT(formatted > 0);
+}
@@ -0,0 +1,282 @@
+#include "test.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string_view>
+#include <thread>
+
+#ifdef _WIN32
+#include <utils/nt.hpp>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
+#endif
+
+using namespace std::literals;
+
+namespace tests
+{
+	namespace
+	{
+		const char* executable{};
+
+		std::map<std::string, child_function>& get_child_functions()
+		{
+			static std::map<std::string, child_function> child_functions{};
+			return child_functions;
+		}
+
+#ifdef _WIN32
+		using process_handle = HANDLE;
+
+		process_handle start_process(const std::vector<std::string>& arguments)
+		{
+			std::string command_line{};
+			for (const auto& argument : arguments)
+			{
+				command_line += "\"" + argument + "\" ";
+			}
+
+			STARTUPINFOA startup_info{};
+			startup_info.cb = sizeof(startup_info);
+
+			PROCESS_INFORMATION process_info{};
+			if (!CreateProcessA(nullptr, command_line.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr,
+			                    &startup_info, &process_info))
+			{
+				throw failure("Failed to start " + command_line);
+			}
+
+			CloseHandle(process_info.hThread);
+			return process_info.hProcess;
+		}
+
+		bool wait_for_process(const process_handle process)
+		{
+			WaitForSingleObject(process, INFINITE);
+
+			DWORD exit_code{};
+			const auto result = GetExitCodeProcess(process, &exit_code) && exit_code == 0;
+			CloseHandle(process);
+
+			return result;
+		}
+#else
+		using process_handle = pid_t;
+
+		process_handle start_process(const std::vector<std::string>& arguments)
+		{
+			std::vector<char*> argv{};
+			for (const auto& argument : arguments)
+			{
+				argv.emplace_back(const_cast<char*>(argument.data()));
+			}
+
+			argv.emplace_back(nullptr);
+
+			process_handle process{};
+			if (posix_spawnp(&process, argv.front(), nullptr, nullptr, argv.data(), environ) != 0)
+			{
+				throw failure("Failed to start " + arguments.front());
+			}
+
+			return process;
+		}
+
+		bool wait_for_process(const process_handle process)
+		{
+			int status{};
+			return waitpid(process, &status, 0) == process && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+		}
+#endif
+	}
+
+	std::vector<test_case>& get_test_cases()
+	{
+		static std::vector<test_case> test_cases{};
+		return test_cases;
+	}
+
+	registration::registration(const char* name, const test_function function, const bool benchmark)
+	{
+		get_test_cases().emplace_back(test_case{name, function, benchmark});
+	}
+
+	child_registration::child_registration(const char* name, const child_function function)
+	{
+		get_child_functions()[name] = function;
+	}
+
+	void expect(const bool condition, const char* expression, const std::source_location& location)
+	{
+		if (!condition)
+		{
+			throw failure(std::string(location.file_name()) + "(" + std::to_string(location.line()) + "): " +
+				expression);
+		}
+	}
+
+	double run_on_threads(const size_t count, const std::function<void(size_t index)>& function)
+	{
+		std::atomic<size_t> ready{0};
+		std::atomic_bool start{false};
+
+		std::vector<std::thread> threads{};
+		threads.reserve(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			threads.emplace_back([&, i]()
+			{
+				++ready;
+				while (!start.load(std::memory_order_acquire))
+				{
+					std::this_thread::yield();
+				}
+
+				function(i);
+			});
+		}
+
+		while (ready != count)
+		{
+			std::this_thread::yield();
+		}
+
+		const auto start_time = std::chrono::steady_clock::now();
+		start = true;
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	}
+
+	void run_in_processes(const size_t count, const char* child, const std::string& argument)
+	{
+		std::vector<process_handle> processes{};
+		std::string error{};
+
+		for (size_t i = 0; i < count && error.empty(); ++i)
+		{
+			try
+			{
+				processes.emplace_back(start_process({executable, "--child", child, std::to_string(i), argument}));
+			}
+			catch (const failure& e)
+			{
+				error = e.what();
+			}
+		}
+
+		// Processes that did start are waited for either way
+		size_t failed = 0;
+		for (const auto& process : processes)
+		{
+			failed += !wait_for_process(process);
+		}
+
+		if (!error.empty())
+		{
+			throw failure(error);
+		}
+
+		if (failed)
+		{
+			throw failure(std::to_string(failed) + " of " + std::to_string(count) + " " + child + " processes failed");
+		}
+	}
+
+	double get_percentile(std::vector<double>& samples, const double share)
+	{
+		if (samples.empty())
+		{
+			return 0.0;
+		}
+
+		std::sort(samples.begin(), samples.end());
+
+		const auto index = static_cast<size_t>(share * static_cast<double>(samples.size() - 1) + 0.5);
+		return samples[std::min(index, samples.size() - 1)];
+	}
+
+	temporary_folder::temporary_folder()
+	{
+		static std::atomic<size_t> counter{0};
+
+		this->path_ = std::filesystem::temp_directory_path() / ("xlabs-tests-" + std::to_string(counter++));
+		std::filesystem::remove_all(this->path_);
+		std::filesystem::create_directories(this->path_);
+	}
+
+	temporary_folder::~temporary_folder()
+	{
+		std::error_code ec{};
+		std::filesystem::remove_all(this->path_, ec);
+	}
+
+	const std::filesystem::path& temporary_folder::get_path() const
+	{
+		return this->path_;
+	}
+}
+
+int main(const int argc, char** argv)
+{
+	tests::executable = argv[0];
+
+	if (argc == 5 && argv[1] == "--child"sv)
+	{
+		const auto child = tests::get_child_functions().find(argv[2]);
+		if (child == tests::get_child_functions().end())
+		{
+			return 1;
+		}
+
+		try
+		{
+			return child->second(std::stoull(argv[3]), argv[4]);
+		}
+		catch (const std::exception& e)
+		{
+			printf("[FAIL] %s %s: %s\n", argv[2], argv[3], e.what());
+			return 1;
+		}
+	}
+
+	const auto benchmark = argc > 1 && argv[1] == "--benchmark"sv;
+
+	size_t failed = 0;
+	size_t run = 0;
+
+	for (const auto& test_case : tests::get_test_cases())
+	{
+		if (test_case.benchmark != benchmark)
+		{
+			continue;
+		}
+
+		++run;
+
+		try
+		{
+			test_case.function();
+			printf("[ OK ] %s\n", test_case.name);
+		}
+		catch (const std::exception& e)
+		{
+			++failed;
+			printf("[FAIL] %s: %s\n", test_case.name, e.what());
+		}
+	}
+
+	printf("%zu of %zu passed\n", run - failed, run);
+	return failed ? 1 : 0;
+}
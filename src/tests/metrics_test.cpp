@@ -0,0 +1,120 @@
+#include "test.hpp"
+
+#include <utils/metrics.hpp>
+
+#include <cstdio>
+#include <mutex>
+
+TEST_CASE(metrics_sharing_a_name_are_reported_as_one)
+{
+	utils::metrics::counter first_counter{"test.shared.counter"};
+	utils::metrics::counter second_counter{"test.shared.counter"};
+	first_counter.add(3);
+	second_counter.add(4);
+
+	utils::metrics::histogram fast{"test.shared.histogram"};
+	utils::metrics::histogram slow{"test.shared.histogram"};
+
+	for (uint64_t i = 0; i < 90; ++i)
+	{
+		fast.record(10);
+	}
+
+	for (uint64_t i = 0; i < 10; ++i)
+	{
+		slow.record(1000);
+	}
+
+	const auto snapshot = utils::metrics::get_snapshot();
+	EXPECT(snapshot.counters.at("test.shared.counter") == 7);
+
+	// Percentiles come from the merged buckets, not from whichever histogram was registered last
+	const auto& histogram = snapshot.histograms.at("test.shared.histogram");
+	EXPECT(histogram.count == 100);
+	EXPECT(histogram.sum == 90 * 10 + 10 * 1000);
+	EXPECT(histogram.max == 1000);
+	EXPECT(histogram.p50 == 10);
+	EXPECT(histogram.p90 >= 1000 - 1000 / 16 && histogram.p90 <= 1000);
+	EXPECT(histogram.p99 >= 1000 - 1000 / 16 && histogram.p99 <= 1000);
+}
+
+TEST_CASE(histogram_percentiles_stay_within_bucket_precision)
+{
+	utils::metrics::histogram histogram{"test.precision"};
+
+	for (uint64_t i = 1; i <= 100000; ++i)
+	{
+		histogram.record(i);
+	}
+
+	const auto snapshot = histogram.get_snapshot();
+	EXPECT(snapshot.count == 100000);
+	EXPECT(snapshot.max == 100000);
+
+	for (const auto& [value, expected] : {
+		     std::pair{snapshot.p50, 50000.0}, std::pair{snapshot.p90, 90000.0}, std::pair{snapshot.p99, 99000.0}
+	     })
+	{
+		EXPECT(static_cast<double>(value) >= expected * (1.0 - 1.0 / 16));
+		EXPECT(static_cast<double>(value) <= expected * (1.0 + 1.0 / 16));
+	}
+}
+
+TEST_CASE(counter_counts_every_concurrent_increment)
+{
+	utils::metrics::counter counter{"test.concurrent"};
+
+	tests::run_on_threads(8, [&counter](size_t)
+	{
+		for (auto i = 0; i < 100000; ++i)
+		{
+			counter.increment();
+		}
+	});
+
+	EXPECT(counter.get() == 800000);
+}
+
+BENCHMARK(counter_contention)
+{
+	constexpr size_t increments = 2000000;
+
+	// The alternatives the sharded counter was measured against
+	std::atomic<uint64_t> single{0};
+	std::mutex mutex{};
+	uint64_t locked = 0;
+
+	for (const size_t threads : {1, 2, 4, 8, 16})
+	{
+		utils::metrics::counter sharded{"test.contention"};
+
+		const auto sharded_time = tests::run_on_threads(threads, [&](size_t)
+		{
+			for (size_t i = 0; i < increments; ++i)
+			{
+				sharded.increment();
+			}
+		});
+
+		const auto single_time = tests::run_on_threads(threads, [&](size_t)
+		{
+			for (size_t i = 0; i < increments; ++i)
+			{
+				single.fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+
+		const auto locked_time = tests::run_on_threads(threads, [&](size_t)
+		{
+			for (size_t i = 0; i < increments; ++i)
+			{
+				std::lock_guard<std::mutex> _{mutex};
+				++locked;
+			}
+		});
+
+		const auto total = static_cast<double>(threads * increments);
+		printf("%2zu threads: sharded %.2f ns, single atomic %.2f ns, mutex %.2f ns per increment\n", threads,
+		       sharded_time / total * 1e9, single_time / total * 1e9, locked_time / total * 1e9);
+	}
+}
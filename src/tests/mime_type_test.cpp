@@ -0,0 +1,169 @@
+#include "test.hpp"
+
+#include <utils/mime_type.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+	// The lookup the launcher used before the table became a perfect hash
+	class baseline_lookup
+	{
+	public:
+		baseline_lookup()
+		{
+			for (const auto& entry : utils::mime_type::get_entries())
+			{
+				this->mime_types_.emplace(entry.first, entry.second);
+			}
+		}
+
+		const std::string& get_mime_type(const std::string& file) const
+		{
+			auto extension = std::filesystem::path(file).extension().string();
+			if (!extension.empty() && extension.front() == '.')
+			{
+				extension.erase(extension.begin());
+			}
+
+			const auto entry = this->mime_types_.find(extension);
+			if (entry != this->mime_types_.end())
+			{
+				return entry->second;
+			}
+
+			return this->default_type_;
+		}
+
+		size_t size() const
+		{
+			return this->mime_types_.size();
+		}
+
+	private:
+		std::unordered_map<std::string, std::string> mime_types_{};
+		std::string default_type_{"application/octet-stream"};
+	};
+
+	std::string to_upper(std::string text)
+	{
+		for (auto& c : text)
+		{
+			c = c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+		}
+
+		return text;
+	}
+
+	// Upper-cases every other letter, e.g. jPeG
+	std::string to_mixed_case(std::string text)
+	{
+		for (size_t i = 1; i < text.size(); i += 2)
+		{
+			text[i] = to_upper(std::string(1, text[i]))[0];
+		}
+
+		return text;
+	}
+}
+
+TEST_CASE(mime_type_agrees_with_baseline_for_every_extension)
+{
+	const baseline_lookup baseline{};
+	EXPECT(baseline.size() == 346);
+	EXPECT(utils::mime_type::get_entries().size() == 346);
+
+	auto agrees = true;
+	for (const auto& entry : utils::mime_type::get_entries())
+	{
+		const auto path = "dist/assets/file." + std::string(entry.first);
+		agrees &= utils::mime_type::get(path) == baseline.get_mime_type(path);
+		agrees &= utils::mime_type::get(path) == entry.second;
+	}
+
+	EXPECT(agrees);
+}
+
+TEST_CASE(mime_type_agrees_with_baseline_for_misses)
+{
+	const baseline_lookup baseline{};
+
+	for (const std::string path : {
+		     "", "index", ".htaccess", "dist/.png", "file.", "file.unknown", "file.htmlx", "file.htm_", "assets.d/readme",
+		     "assets.png/readme", "dir\\file", "file.png.bak", "file.-", "file.3gpp2"
+	     })
+	{
+		EXPECT(utils::mime_type::get(path) == baseline.get_mime_type(path));
+		EXPECT(utils::mime_type::get(path) == "application/octet-stream");
+	}
+}
+
+TEST_CASE(mime_type_ignores_extension_case)
+{
+	const baseline_lookup baseline{};
+
+	// The baseline only matched lower case extensions, the table matches any case
+	auto agrees = true;
+	for (const auto& entry : utils::mime_type::get_entries())
+	{
+		const auto lower = "file." + std::string(entry.first);
+		const auto expected = baseline.get_mime_type(lower);
+
+		agrees &= utils::mime_type::get(to_upper(lower)) == expected;
+		agrees &= utils::mime_type::get(to_mixed_case(lower)) == expected;
+	}
+
+	EXPECT(agrees);
+	EXPECT(baseline.get_mime_type("file.PNG") == "application/octet-stream");
+	EXPECT(utils::mime_type::get("dist\\Main.JS") == "application/javascript");
+}
+
+BENCHMARK(mime_type_lookup)
+{
+	constexpr size_t rounds = 2000;
+
+	const baseline_lookup baseline{};
+
+	std::vector<std::string> paths{};
+	for (const auto& entry : utils::mime_type::get_entries())
+	{
+		paths.emplace_back("dist/assets/main.3f2a9c1b." + std::string(entry.first));
+	}
+
+	paths.emplace_back("dist/assets/main.unknown");
+	paths.emplace_back("dist/.htaccess");
+
+	size_t checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	for (size_t round = 0; round < rounds; ++round)
+	{
+		for (const auto& path : paths)
+		{
+			checksum += baseline.get_mime_type(path).size();
+		}
+	}
+
+	const auto baseline_time = std::chrono::steady_clock::now() - start;
+	start = std::chrono::steady_clock::now();
+
+	for (size_t round = 0; round < rounds; ++round)
+	{
+		for (const auto& path : paths)
+		{
+			checksum -= utils::mime_type::get(path).size();
+		}
+	}
+
+	const auto table_time = std::chrono::steady_clock::now() - start;
+	const auto lookups = static_cast<double>(rounds * paths.size());
+
+	EXPECT(checksum == 0);
+	printf("baseline %.1f ns/lookup, perfect hash %.1f ns/lookup\n",
+	       std::chrono::duration<double, std::nano>(baseline_time).count() / lookups,
+	       std::chrono::duration<double, std::nano>(table_time).count() / lookups);
+}
@@ -0,0 +1,174 @@
+#include "test.hpp"
+
+#include <utils/compression.hpp>
+#include <utils/file_cache.hpp>
+#include <utils/io.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace
+{
+	constexpr size_t request_count = 1000;
+
+	struct asset
+	{
+		std::string path{};
+		std::string variant{};
+	};
+
+	// Minified UI code: few distinct identifiers and keywords repeated all over
+	std::string make_text(const size_t size, const std::vector<std::string>& words, std::mt19937_64& random)
+	{
+		std::string data{};
+		while (data.size() < size)
+		{
+			data += words[random() % words.size()];
+			data += std::to_string(random() % 100);
+		}
+
+		data.resize(size);
+		return data;
+	}
+
+	// The build writes .br and .gz variants, neither encoder is part of the tree. zstd at its highest level
+	// stands in for them when no built UI folder is given
+	std::vector<asset> create_assets(const std::filesystem::path& folder)
+	{
+		std::mt19937_64 random{1};
+		const std::vector<std::string> script_words{
+			"function(e,t){return ", "var n=", "this.state.", ".push(", "})}", "document.getElementById(\"",
+			"if(e===null)", "=>{", "const r=", "addEventListener(\"click\",",
+		};
+		const std::vector<std::string> style_words{
+			".button-", "{display:flex;", "margin:0 auto;", "color:#", "}\n", "padding:", "px;", "font-size:",
+		};
+		const std::vector<std::string> markup_words{
+			"<div class=\"server-", "\">", "</div>", "<span>", "</span>\n", "<button id=\"play-", "<img src=\"",
+		};
+
+		const std::vector<std::pair<std::string, std::string>> files{
+			{"main.html", make_text(8 * 1024, markup_words, random)},
+			{"assets/main.3f2a9c1b.js", make_text(1024 * 1024, script_words, random)},
+			{"assets/vendor.7d41e0a2.js", make_text(400 * 1024, script_words, random)},
+			{"assets/main.5b7c90de.css", make_text(120 * 1024, style_words, random)},
+		};
+
+		std::vector<asset> assets{};
+		for (const auto& [path, data] : files)
+		{
+			utils::io::write_file((folder / path).string(), data);
+			utils::io::write_file((folder / (path + ".zst")).string(), utils::compression::zstd::compress(data, 19));
+			assets.emplace_back(asset{path, path + ".zst"});
+		}
+
+		// Images are already compressed and have no variant
+		std::string image(200 * 1024, '\0');
+		for (auto& c : image)
+		{
+			c = static_cast<char>(random());
+		}
+
+		utils::io::write_file((folder / "assets/background.png").string(), image);
+		assets.emplace_back(asset{"assets/background.png", {}});
+
+		return assets;
+	}
+
+	std::vector<asset> find_assets(const std::filesystem::path& folder)
+	{
+		std::vector<asset> assets{};
+		for (const auto& file : std::filesystem::recursive_directory_iterator(folder))
+		{
+			const auto extension = file.path().extension();
+			if (!file.is_regular_file() || extension == ".br" || extension == ".gz")
+			{
+				continue;
+			}
+
+			asset asset{file.path().lexically_relative(folder).generic_string(), {}};
+			for (const auto* variant_extension : {".br", ".gz"})
+			{
+				if (std::filesystem::exists(folder / (asset.path + variant_extension)))
+				{
+					asset.variant = asset.path + variant_extension;
+					break;
+				}
+			}
+
+			assets.emplace_back(std::move(asset));
+		}
+
+		return assets;
+	}
+
+	// Takes the content from the cache and hands it to Chromium the way the resource handler's Read does
+	size_t serve(utils::file_cache& cache, const std::string& path)
+	{
+		constexpr size_t read_size = 64 * 1024;
+		static char output[read_size]{};
+
+		const auto content = cache.get(path);
+		EXPECT(content);
+
+		for (size_t offset = 0; offset < content->size(); offset += read_size)
+		{
+			std::memcpy(output, content->data() + offset, std::min(read_size, content->size() - offset));
+		}
+
+		return content->size();
+	}
+
+	struct measurement
+	{
+		size_t size{};
+		double first_response{};
+		double response{};
+	};
+
+	// The first response reads the file from disk, the others come from the cache
+	measurement measure(const std::filesystem::path& folder, const std::string& path)
+	{
+		utils::file_cache cache{folder};
+
+		auto start = std::chrono::steady_clock::now();
+		const auto size = serve(cache, path);
+		const auto first_response = std::chrono::steady_clock::now() - start;
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < request_count; ++i)
+		{
+			EXPECT(serve(cache, path) == size);
+		}
+
+		const auto responses = std::chrono::steady_clock::now() - start;
+
+		return {
+			size, std::chrono::duration<double, std::micro>(first_response).count(),
+			std::chrono::duration<double, std::micro>(responses).count() / static_cast<double>(request_count),
+		};
+	}
+}
+
+BENCHMARK(precompressed_asset_responses)
+{
+	// Set UI_ASSETS to a UI folder that went through scripts/precompress-ui.ps1 to measure the real variants
+	const tests::temporary_folder temporary{};
+	const auto* ui_assets = std::getenv("UI_ASSETS");
+	const std::filesystem::path folder = ui_assets ? std::filesystem::path{ui_assets} : temporary.get_path();
+	const auto assets = ui_assets ? find_assets(folder) : create_assets(folder);
+
+	printf("Bytes per response, first response from disk and average of %zu cached ones:\n", request_count);
+	for (const auto& asset : assets)
+	{
+		const auto original = measure(folder, asset.path);
+		const auto variant = asset.variant.empty() ? original : measure(folder, asset.variant);
+
+		printf("  %-26s original %8zu bytes, %6.1f / %5.1f us, variant %8zu bytes, %6.1f / %5.1f us\n",
+		       asset.path.c_str(), original.size, original.first_response, original.response, variant.size,
+		       variant.first_response, variant.response);
+	}
+}
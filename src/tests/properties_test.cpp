@@ -0,0 +1,142 @@
+#include "test.hpp"
+
+#include <utils/io.hpp>
+#include <utils/properties.hpp>
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+	constexpr size_t property_count = 50;
+
+	std::string get_name(const size_t index)
+	{
+		return "launcher.setting-" + std::to_string(index);
+	}
+
+	rapidjson::Document read_properties(const std::filesystem::path& file)
+	{
+		rapidjson::Document doc{};
+		doc.SetObject();
+
+		std::string data{};
+		if (utils::io::read_file(file.string(), &data))
+		{
+			doc.Parse(data);
+		}
+
+		return doc;
+	}
+
+	// What load did before the cache: take the lock, then read and parse the whole file for every call
+	std::optional<std::string> load_uncached(const std::filesystem::path& file, const std::string& name)
+	{
+		const auto _ = utils::properties::lock();
+		const auto doc = read_properties(file);
+
+		const auto member = doc.FindMember(name);
+		if (member == doc.MemberEnd() || !member->value.IsString())
+		{
+			return {};
+		}
+
+		return {std::string{member->value.GetString(), member->value.GetStringLength()}};
+	}
+
+	// What store did before: the same, and then write all of it back
+	void store_uncached(const std::filesystem::path& file, const std::string& name, const std::string& value)
+	{
+		const auto _ = utils::properties::lock();
+		auto doc = read_properties(file);
+
+		while (doc.HasMember(name))
+		{
+			doc.RemoveMember(name);
+		}
+
+		rapidjson::Value key{};
+		key.SetString(name, doc.GetAllocator());
+
+		rapidjson::Value member{};
+		member.SetString(value, doc.GetAllocator());
+
+		doc.AddMember(key, member, doc.GetAllocator());
+
+		rapidjson::StringBuffer buffer{};
+		rapidjson::Writer<rapidjson::StringBuffer, rapidjson::Document::EncodingType, rapidjson::ASCII<>>
+			writer(buffer);
+		doc.Accept(writer);
+
+		utils::io::write_file(file.string(), {buffer.GetString(), buffer.GetLength()});
+	}
+
+	template <typename F>
+	double measure_milliseconds(const size_t count, const F& function)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < count; ++i)
+		{
+			function(i);
+		}
+
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+BENCHMARK(properties_get_and_set)
+{
+	constexpr size_t call_count = 100;
+
+	// Keeps the user's properties out of it, the lock and the snapshot are still shared with a running launcher
+	const tests::temporary_folder folder{};
+	utils::properties::set_appdata_path(folder.get_path());
+	const auto file = folder.get_path() / "user" / "properties.json";
+
+	std::map<std::string, std::string> values{};
+	for (size_t i = 0; i < property_count; ++i)
+	{
+		values.emplace(get_name(i), "value-" + std::to_string(i));
+	}
+
+	utils::properties::store_many(values);
+	utils::properties::flush();
+
+	const auto get_time = measure_milliseconds(call_count, [](const size_t i)
+	{
+		EXPECT(utils::properties::load(get_name(i % property_count)) == "value-" + std::to_string(i % property_count));
+	});
+
+	const auto set_time = measure_milliseconds(call_count, [](const size_t i)
+	{
+		utils::properties::store(get_name(i % property_count), "new-value-" + std::to_string(i));
+	});
+
+	// The coalesced write the stores end up in
+	const auto flush_time = measure_milliseconds(1, [](size_t)
+	{
+		utils::properties::flush();
+	});
+
+	const auto last_name = get_name((call_count - 1) % property_count);
+	EXPECT(load_uncached(file, last_name) == "new-value-" + std::to_string(call_count - 1));
+
+	const auto uncached_get_time = measure_milliseconds(call_count, [&file](const size_t i)
+	{
+		EXPECT(load_uncached(file, get_name(i % property_count)).has_value());
+	});
+
+	const auto uncached_set_time = measure_milliseconds(call_count, [&file](const size_t i)
+	{
+		store_uncached(file, get_name(i % property_count), "old-value-" + std::to_string(i));
+	});
+
+	printf("%zu calls each on %zu properties:\n", call_count, property_count);
+	printf("  get: cached %.2f ms, read and parsed every time %.2f ms\n", get_time, uncached_get_time);
+	printf("  set: cached %.2f ms and %.2f ms for the coalesced write, written every time %.2f ms\n", set_time,
+	       flush_time, uncached_set_time);
+}
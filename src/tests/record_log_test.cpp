@@ -0,0 +1,155 @@
+#include "test.hpp"
+
+#include <utils/cryptography.hpp>
+#include <utils/io.hpp>
+#include <utils/record_log.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	size_t replay(const std::string& data, utils::record_log::entries& entries)
+	{
+		size_t record_count = 0;
+		return utils::record_log::replay(data, entries, record_count);
+	}
+
+	// Batch with a correct checksum around an arbitrary payload
+	std::string make_batch(const std::string& payload)
+	{
+		const auto payload_size = static_cast<uint32_t>(payload.size());
+		const auto checksum = utils::cryptography::crc32::compute(payload);
+
+		std::string batch(sizeof(uint32_t) * 2, '\0');
+		std::memcpy(batch.data(), &payload_size, sizeof(payload_size));
+		std::memcpy(batch.data() + sizeof(uint32_t), &checksum, sizeof(checksum));
+
+		return batch + payload;
+	}
+}
+
+TEST_CASE(record_log_replays_batches_in_order)
+{
+	const auto data = utils::record_log::serialize({{"a", "1"}, {"b", "2"}}) +
+		utils::record_log::serialize({{"a", "3"}});
+
+	utils::record_log::entries entries{};
+	size_t record_count = 0;
+
+	EXPECT(utils::record_log::replay(data, entries, record_count) == data.size());
+	EXPECT(record_count == 3);
+	EXPECT(entries == (utils::record_log::entries{{"a", "3"}, {"b", "2"}}));
+}
+
+TEST_CASE(record_log_cuts_off_torn_tail)
+{
+	const auto first = utils::record_log::serialize({{"a", "1"}});
+	const auto second = utils::record_log::serialize({{"b", "2"}, {"c", "3"}});
+
+	// Every possible crash point within the second batch
+	for (size_t length = 0; length < second.size(); ++length)
+	{
+		utils::record_log::entries entries{};
+		EXPECT(replay(first + second.substr(0, length), entries) == first.size());
+		EXPECT(entries == (utils::record_log::entries{{"a", "1"}}));
+	}
+}
+
+TEST_CASE(record_log_stops_at_checksum_mismatch)
+{
+	const auto first = utils::record_log::serialize({{"a", "1"}});
+	auto second = utils::record_log::serialize({{"b", "2"}});
+	const auto third = utils::record_log::serialize({{"c", "3"}});
+
+	second.back() ^= 0x20;
+
+	// Batches behind a corrupt one are not trusted either
+	utils::record_log::entries entries{};
+	EXPECT(replay(first + second + third, entries) == first.size());
+	EXPECT(entries == (utils::record_log::entries{{"a", "1"}}));
+}
+
+TEST_CASE(record_log_rejects_truncated_record_header)
+{
+	const auto first = utils::record_log::serialize({{"a", "1"}});
+
+	// The checksum matches, but the payload ends within the sizes of a record
+	const uint32_t key_size = 1;
+	std::string payload(sizeof(key_size), '\0');
+	std::memcpy(payload.data(), &key_size, sizeof(key_size));
+
+	utils::record_log::entries entries{};
+	EXPECT(replay(first + make_batch(payload), entries) == first.size());
+	EXPECT(entries == (utils::record_log::entries{{"a", "1"}}));
+}
+
+TEST_CASE(record_log_applies_batches_as_a_whole)
+{
+	// The second record claims more data than the payload holds
+	auto payload = utils::record_log::serialize({{"a", "2"}}).substr(sizeof(uint32_t) * 2);
+	const uint32_t sizes[] = {1, 100};
+	payload.append(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+	payload.append("b");
+
+	utils::record_log::entries entries{{"a", "1"}};
+	EXPECT(replay(make_batch(payload), entries) == 0);
+	EXPECT(entries == (utils::record_log::entries{{"a", "1"}}));
+}
+
+TEST_CASE(record_log_truncates_torn_file_on_open)
+{
+	const tests::temporary_folder folder{};
+	const auto file = folder.get_path() / "test.log";
+
+	{
+		utils::record_log log{file};
+		log.append({{"a", "1"}});
+		log.append({{"b", "2"}});
+	}
+
+	const auto intact_size = std::filesystem::file_size(file);
+
+	// A crash in the middle of writing the next batch
+	const auto torn = utils::record_log::serialize({{"c", "3"}});
+	EXPECT(utils::io::write_file(file.string(), torn.substr(0, torn.size() / 2), true));
+
+	{
+		utils::record_log log{file};
+		EXPECT(log.get_entries() == (utils::record_log::entries{{"a", "1"}, {"b", "2"}}));
+		EXPECT(std::filesystem::file_size(file) == intact_size);
+
+		// New batches directly follow the intact ones
+		log.append({{"c", "3"}});
+	}
+
+	const utils::record_log log{file};
+	EXPECT(log.get_entries() == (utils::record_log::entries{{"a", "1"}, {"b", "2"}, {"c", "3"}}));
+}
+
+BENCHMARK(record_log_append_latency)
+{
+	const tests::temporary_folder folder{};
+	utils::record_log log{folder.get_path() / "benchmark.log"};
+
+	constexpr size_t iterations = 500;
+
+	std::vector<double> latencies{};
+	latencies.reserve(iterations);
+
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		log.append({{"property-" + std::to_string(i % 16), std::string(64, 'x')}});
+		const auto duration = std::chrono::steady_clock::now() - start;
+
+		latencies.emplace_back(std::chrono::duration<double, std::micro>(duration).count());
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+
+	printf("record_log::append: p50 %.1f us, p99 %.1f us, max %.1f us\n", latencies[iterations / 2],
+	       latencies[iterations * 99 / 100], latencies.back());
+}
@@ -0,0 +1,292 @@
+#include "test.hpp"
+
+#include <utils/ring_queue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace
+{
+	// What the queues replace: a bounded deque behind a mutex
+	template <typename T>
+	class mutex_queue
+	{
+	public:
+		explicit mutex_queue(const size_t capacity)
+			: capacity_(capacity)
+		{
+		}
+
+		template <typename U>
+		bool try_push(U&& value)
+		{
+			std::lock_guard<std::mutex> _{this->mutex_};
+			if (this->values_.size() >= this->capacity_)
+			{
+				return false;
+			}
+
+			this->values_.emplace_back(std::forward<U>(value));
+			return true;
+		}
+
+		std::optional<T> try_pop()
+		{
+			std::lock_guard<std::mutex> _{this->mutex_};
+			if (this->values_.empty())
+			{
+				return {};
+			}
+
+			std::optional<T> value{std::move(this->values_.front())};
+			this->values_.pop_front();
+			return value;
+		}
+
+	private:
+		std::mutex mutex_{};
+		std::deque<T> values_{};
+		size_t capacity_{};
+	};
+
+	template <typename Queue, typename T>
+	void push(Queue& queue, T value)
+	{
+		while (!queue.try_push(value))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	template <typename Queue>
+	auto pop(Queue& queue)
+	{
+		while (true)
+		{
+			if (auto value = queue.try_pop())
+			{
+				return std::move(*value);
+			}
+
+			std::this_thread::yield();
+		}
+	}
+
+	constexpr size_t thread_count = 4;
+	constexpr uint64_t items_per_thread = 20000;
+
+	// Items carry their producer in the upper bits and a running number below
+	uint64_t make_item(const size_t producer, const uint64_t index)
+	{
+		return static_cast<uint64_t>(producer) << 32 | index;
+	}
+
+	template <typename Queue>
+	double run_many_producers(Queue& queue, const size_t producers, const uint64_t items)
+	{
+		return tests::run_on_threads(producers + 1, [&](const size_t index)
+		{
+			if (index == producers)
+			{
+				for (uint64_t i = 0; i < producers * items; ++i)
+				{
+					pop(queue);
+				}
+
+				return;
+			}
+
+			for (uint64_t i = 0; i < items; ++i)
+			{
+				push(queue, make_item(index, i));
+			}
+		});
+	}
+
+	template <typename Queue>
+	double run_many_consumers(Queue& queue, const size_t consumers, const uint64_t items)
+	{
+		return tests::run_on_threads(consumers + 1, [&](const size_t index)
+		{
+			if (index == consumers)
+			{
+				for (uint64_t i = 0; i < consumers * items; ++i)
+				{
+					push(queue, i);
+				}
+
+				return;
+			}
+
+			for (uint64_t i = 0; i < items; ++i)
+			{
+				pop(queue);
+			}
+		});
+	}
+
+	template <typename Queue>
+	void report_latency(const char* name)
+	{
+		constexpr size_t iterations = 20000;
+
+		Queue queue{1024};
+		std::vector<double> latencies{};
+		latencies.reserve(iterations);
+
+		tests::run_on_threads(2, [&](const size_t index)
+		{
+			for (size_t i = 0; i < iterations; ++i)
+			{
+				if (index == 0)
+				{
+					push(queue, std::chrono::steady_clock::now().time_since_epoch().count());
+				}
+				else
+				{
+					const auto sent = std::chrono::steady_clock::duration(pop(queue));
+					const auto latency = std::chrono::steady_clock::now().time_since_epoch() - sent;
+					latencies.emplace_back(std::chrono::duration<double, std::nano>(latency).count());
+				}
+			}
+		});
+
+		const auto p50 = tests::get_percentile(latencies, 0.5);
+		printf("%s: push to pop p50 %.0f ns, p99 %.0f ns\n", name, p50, tests::get_percentile(latencies, 0.99));
+	}
+}
+
+TEST_CASE(ring_queue_rounds_capacity_up)
+{
+	EXPECT(utils::concurrency::spsc_queue<int>{1}.get_capacity() == 2);
+	EXPECT(utils::concurrency::spsc_queue<int>{3}.get_capacity() == 4);
+	EXPECT(utils::concurrency::mpsc_queue<int>{64}.get_capacity() == 64);
+}
+
+TEST_CASE(ring_queue_keeps_order_across_laps)
+{
+	utils::concurrency::spsc_queue<std::string> queue{4};
+
+	for (int lap = 0; lap < 3; ++lap)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			EXPECT(queue.try_push(std::to_string(lap * 4 + i)));
+		}
+
+		// A rejected value is not moved from
+		std::string rejected = "rejected";
+		EXPECT(!queue.try_push(std::move(rejected)));
+		EXPECT(rejected == "rejected");
+
+		for (int i = 0; i < 4; ++i)
+		{
+			EXPECT(queue.try_pop() == std::to_string(lap * 4 + i));
+		}
+
+		EXPECT(!queue.try_pop());
+	}
+}
+
+TEST_CASE(mpsc_queue_delivers_every_item_once_in_producer_order)
+{
+	utils::concurrency::mpsc_queue<uint64_t> queue{64};
+	std::vector<uint64_t> next(thread_count, 0);
+	auto in_order = true;
+
+	tests::run_on_threads(thread_count + 1, [&](const size_t index)
+	{
+		if (index < thread_count)
+		{
+			for (uint64_t i = 0; i < items_per_thread; ++i)
+			{
+				push(queue, make_item(index, i));
+			}
+
+			return;
+		}
+
+		for (uint64_t i = 0; i < thread_count * items_per_thread; ++i)
+		{
+			const auto item = pop(queue);
+			auto& expected = next[item >> 32];
+
+			in_order &= (item & 0xFFFFFFFF) == expected;
+			++expected;
+		}
+	});
+
+	EXPECT(in_order);
+	EXPECT(!queue.try_pop());
+}
+
+TEST_CASE(spmc_queue_delivers_every_item_once)
+{
+	constexpr uint64_t item_count = thread_count * items_per_thread;
+
+	utils::concurrency::spmc_queue<uint64_t> queue{64};
+	std::vector<std::atomic<uint32_t>> seen(item_count);
+
+	tests::run_on_threads(thread_count + 1, [&](const size_t index)
+	{
+		if (index == thread_count)
+		{
+			for (uint64_t i = 0; i < item_count; ++i)
+			{
+				push(queue, i);
+			}
+
+			return;
+		}
+
+		for (uint64_t i = 0; i < items_per_thread; ++i)
+		{
+			++seen[pop(queue)];
+		}
+	});
+
+	auto once = true;
+	for (const auto& count : seen)
+	{
+		once &= count == 1;
+	}
+
+	EXPECT(once);
+	EXPECT(!queue.try_pop());
+}
+
+BENCHMARK(ring_queue_throughput)
+{
+	constexpr uint64_t items = 200000;
+
+	for (const size_t threads : {1, 2, 4, 8})
+	{
+		utils::concurrency::mpsc_queue<uint64_t> mpsc{1024};
+		mutex_queue<uint64_t> mpsc_mutex{1024};
+		utils::concurrency::spmc_queue<uint64_t> spmc{1024};
+		mutex_queue<uint64_t> spmc_mutex{1024};
+
+		const auto total = static_cast<double>(threads * items) / 1e6;
+
+		printf("%zu producers: mpsc_queue %.1f M items/s, mutex %.1f M items/s\n", threads,
+		       total / run_many_producers(mpsc, threads, items),
+		       total / run_many_producers(mpsc_mutex, threads, items));
+
+		printf("%zu consumers: spmc_queue %.1f M items/s, mutex %.1f M items/s\n", threads,
+		       total / run_many_consumers(spmc, threads, items),
+		       total / run_many_consumers(spmc_mutex, threads, items));
+	}
+}
+
+BENCHMARK(ring_queue_latency)
+{
+	report_latency<utils::concurrency::spsc_queue<int64_t>>("spsc_queue");
+	report_latency<utils::concurrency::mpsc_queue<int64_t>>("mpsc_queue");
+	report_latency<mutex_queue<int64_t>>("mutex queue");
+}
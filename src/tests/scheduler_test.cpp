@@ -0,0 +1,270 @@
+#include "test.hpp"
+
+#include <utils/scheduler.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	template <typename F>
+	bool throws(const F& function)
+	{
+		try
+		{
+			function();
+			return false;
+		}
+		catch (const std::runtime_error&)
+		{
+			return true;
+		}
+	}
+
+	// Burns CPU for roughly the given number of iterations without the compiler dropping it
+	void spin(const size_t iterations)
+	{
+		volatile size_t sink = 0;
+		for (size_t i = 0; i < iterations; ++i)
+		{
+			sink = sink + i;
+		}
+	}
+
+	size_t fibonacci(utils::concurrency::scheduler& scheduler, const size_t n)
+	{
+		if (n < 16)
+		{
+			return n < 2 ? n : fibonacci(scheduler, n - 1) + fibonacci(scheduler, n - 2);
+		}
+
+		size_t first{}, second{};
+
+		utils::concurrency::task_group group{scheduler};
+		group.run([&]()
+		{
+			first = fibonacci(scheduler, n - 1);
+		});
+
+		second = fibonacci(scheduler, n - 2);
+		group.wait();
+
+		return first + second;
+	}
+}
+
+TEST_CASE(task_group_rethrows_the_first_exception_and_skips_the_rest)
+{
+	utils::concurrency::scheduler scheduler{1};
+	utils::concurrency::task_group group{scheduler};
+
+	std::atomic<size_t> run{0};
+	for (size_t i = 0; i < 1000; ++i)
+	{
+		group.run([&run, i]()
+		{
+			++run;
+			if (i == 10)
+			{
+				throw std::runtime_error("failed");
+			}
+		});
+	}
+
+	EXPECT(throws([&group]()
+	{
+		group.wait();
+	}));
+
+	EXPECT(group.is_cancelled());
+	EXPECT(run < 1000);
+
+	// The exception is only rethrown once
+	group.wait();
+}
+
+TEST_CASE(task_group_cancel_skips_pending_tasks)
+{
+	utils::concurrency::scheduler scheduler{1};
+	utils::concurrency::task_group group{scheduler};
+
+	std::mutex mutex{};
+	std::unique_lock<std::mutex> blocker{mutex};
+
+	std::atomic<size_t> run{0};
+	group.run([&mutex]()
+	{
+		std::lock_guard<std::mutex> _{mutex};
+	});
+
+	for (size_t i = 0; i < 100; ++i)
+	{
+		group.run([&run]()
+		{
+			++run;
+		});
+	}
+
+	group.cancel();
+	blocker.unlock();
+	group.wait();
+
+	EXPECT(run == 0);
+}
+
+TEST_CASE(task_groups_can_be_waited_on_from_within_tasks)
+{
+	// A single worker would deadlock if waiting blocked instead of running the nested tasks
+	utils::concurrency::scheduler scheduler{1};
+	EXPECT(fibonacci(scheduler, 24) == 46368);
+}
+
+TEST_CASE(parallel_for_visits_every_index_once_and_propagates_exceptions)
+{
+	utils::concurrency::scheduler scheduler{4};
+
+	std::vector<std::atomic<size_t>> visits(10007);
+	utils::concurrency::parallel_for(scheduler, 0, visits.size(), [&visits](const size_t index)
+	{
+		++visits[index];
+	}, 13);
+
+	EXPECT(std::all_of(visits.begin(), visits.end(), [](const std::atomic<size_t>& count)
+	{
+		return count == 1;
+	}));
+
+	EXPECT(throws([&scheduler]()
+	{
+		utils::concurrency::parallel_for(scheduler, 0, 1000, [](const size_t index)
+		{
+			if (index == 500)
+			{
+				throw std::runtime_error("failed");
+			}
+		});
+	}));
+
+	utils::concurrency::parallel_for(scheduler, 5, 5, [](size_t)
+	{
+		throw std::runtime_error("empty ranges run nothing");
+	});
+}
+
+BENCHMARK(scheduling_overhead)
+{
+	constexpr size_t task_count = 1000000;
+	constexpr size_t thread_task_count = 2000;
+
+	utils::concurrency::scheduler scheduler{};
+	std::atomic<size_t> run{0};
+
+	auto start = std::chrono::steady_clock::now();
+	{
+		utils::concurrency::task_group group{scheduler};
+		for (size_t i = 0; i < task_count; ++i)
+		{
+			group.run([&run]()
+			{
+				run.fetch_add(1, std::memory_order_relaxed);
+			});
+		}
+
+		group.wait();
+	}
+
+	const auto group_time = std::chrono::steady_clock::now() - start;
+	EXPECT(run == task_count);
+
+	// What the updater and the HTTP code did before: a thread or an async call per piece of work
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < thread_task_count; ++i)
+	{
+		std::thread([&run]()
+		{
+			run.fetch_add(1, std::memory_order_relaxed);
+		}).join();
+	}
+
+	const auto thread_time = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	std::vector<std::future<void>> futures{};
+	for (size_t i = 0; i < thread_task_count; ++i)
+	{
+		futures.emplace_back(std::async(std::launch::async, [&run]()
+		{
+			run.fetch_add(1, std::memory_order_relaxed);
+		}));
+	}
+
+	for (auto& future : futures)
+	{
+		future.get();
+	}
+
+	const auto async_time = std::chrono::steady_clock::now() - start;
+
+	const auto per_task = [](const std::chrono::steady_clock::duration duration, const size_t count)
+	{
+		return std::chrono::duration<double, std::nano>(duration).count() / static_cast<double>(count);
+	};
+
+	printf("%zu workers, per empty task: task group %.0f ns, thread %.0f ns, async %.0f ns\n",
+	       scheduler.get_thread_count(), per_task(group_time, task_count), per_task(thread_time, thread_task_count),
+	       per_task(async_time, thread_task_count));
+
+	start = std::chrono::steady_clock::now();
+	const auto result = fibonacci(scheduler, 30);
+	printf("Nested fibonacci(30), a task per call above 16: %.1f ms (%zu)\n",
+	       std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), result);
+}
+
+BENCHMARK(scheduling_load_balance)
+{
+	constexpr size_t item_count = 4096;
+
+	for (const size_t thread_count : {2, 4, 8})
+	{
+		utils::concurrency::scheduler scheduler{thread_count};
+
+		// Costs grow with the index, so static chunks per worker would leave most of them idle at the end
+		std::mutex mutex{};
+		std::unordered_map<std::thread::id, size_t> work{};
+
+		const auto start = std::chrono::steady_clock::now();
+		utils::concurrency::parallel_for(scheduler, 0, item_count, [&](const size_t index)
+		{
+			spin(index * 20);
+
+			std::lock_guard<std::mutex> _{mutex};
+			work[std::this_thread::get_id()] += index;
+		});
+
+		const auto duration = std::chrono::steady_clock::now() - start;
+
+		size_t total = 0;
+		size_t busiest = 0;
+		for (const auto& [thread, amount] : work)
+		{
+			total += amount;
+			busiest = std::max(busiest, amount);
+		}
+
+		EXPECT(total == item_count * (item_count - 1) / 2);
+
+		// 1.0 means the busiest thread did exactly its share of the work. The waiting thread helps as well
+		const auto share = static_cast<double>(total) / static_cast<double>(thread_count + 1);
+		printf("%zu workers: %.1f ms, %zu threads took part, busiest did %.2fx its share\n", thread_count,
+		       std::chrono::duration<double, std::milli>(duration).count(), work.size(),
+		       static_cast<double>(busiest) / share);
+	}
+}
@@ -0,0 +1,317 @@
+#include "test.hpp"
+
+#include <utils/io.hpp>
+#include <utils/shared_snapshot.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#ifdef _WIN32
+#include <utils/named_mutex.hpp>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// Like the properties snapshot: a few hundred short properties in a 256 KB mapping
+	constexpr size_t snapshot_capacity = 256 * 1024;
+	constexpr size_t properties_size = 4 * 1024;
+	constexpr size_t read_count = 20000;
+
+	std::string get_snapshot_name(const std::filesystem::path& folder)
+	{
+		return "xlabs-snapshot-" + folder.filename().string();
+	}
+
+	// Every byte holds the same value, a torn read shows up as mixed bytes
+	std::string make_properties(const size_t size, const uint64_t version)
+	{
+		return std::string(size, static_cast<char>('a' + version % 26));
+	}
+
+	bool is_consistent(const std::string& data)
+	{
+		return data.find_first_not_of(data.front()) == std::string::npos;
+	}
+
+	// Children report that they are ready and wait for the others, so all of them start reading at once
+	void wait_for_start(const std::filesystem::path& folder, const size_t index)
+	{
+		utils::io::write_file((folder / ("ready-" + std::to_string(index))).string(), {});
+		while (!std::filesystem::exists(folder / "start"))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// Publishes new versions while the children read, waiting the interval between them
+	template <typename Publish>
+	void run_with_writer(const std::filesystem::path& folder, const size_t count, const char* child,
+	                     const std::chrono::microseconds interval, const Publish& publish)
+	{
+		std::atomic_bool done{false};
+		std::thread writer([&]()
+		{
+			for (size_t ready = 0; ready < count && !done;)
+			{
+				ready = 0;
+				for (size_t i = 0; i < count; ++i)
+				{
+					ready += std::filesystem::exists(folder / ("ready-" + std::to_string(i)));
+				}
+
+				std::this_thread::yield();
+			}
+
+			utils::io::write_file((folder / "start").string(), {});
+
+			for (uint64_t version = 1; !done; ++version)
+			{
+				publish(version);
+				std::this_thread::sleep_for(interval);
+			}
+		});
+
+		try
+		{
+			tests::run_in_processes(count, child, folder.string());
+		}
+		catch (...)
+		{
+			done = true;
+			writer.join();
+			throw;
+		}
+
+		done = true;
+		writer.join();
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			std::filesystem::remove(folder / ("ready-" + std::to_string(i)));
+		}
+
+		std::filesystem::remove(folder / "start");
+	}
+
+	// The cross-process lock every properties reader took before the snapshot
+	class properties_lock
+	{
+	public:
+		explicit properties_lock(const std::filesystem::path& folder)
+#ifdef _WIN32
+			: mutex_(get_snapshot_name(folder) + "-lock")
+#else
+			: file_(open((folder / "properties.lock").c_str(), O_CREAT | O_RDWR, 0600))
+#endif
+		{
+		}
+
+		~properties_lock()
+		{
+#ifndef _WIN32
+			close(this->file_);
+#endif
+		}
+
+		properties_lock(properties_lock&&) = delete;
+		properties_lock(const properties_lock&) = delete;
+		properties_lock& operator=(properties_lock&&) = delete;
+		properties_lock& operator=(const properties_lock&) = delete;
+
+		void lock() const
+		{
+#ifdef _WIN32
+			this->mutex_.lock();
+#else
+			flock(this->file_, LOCK_EX);
+#endif
+		}
+
+		void unlock() const
+		{
+#ifdef _WIN32
+			this->mutex_.unlock();
+#else
+			flock(this->file_, LOCK_UN);
+#endif
+		}
+
+	private:
+#ifdef _WIN32
+		utils::named_mutex mutex_;
+#else
+		int file_{};
+#endif
+	};
+
+	// Times every read and writes the total time, median and 99th percentile to the child's result file
+	template <typename Read>
+	int measure_reads(const size_t index, const std::filesystem::path& folder, const Read& read)
+	{
+		std::vector<double> samples{};
+		samples.reserve(read_count);
+
+		std::string data{};
+		wait_for_start(folder, index);
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < read_count; ++i)
+		{
+			const auto read_start = std::chrono::steady_clock::now();
+			if (!read(data) || data.size() != properties_size)
+			{
+				return 1;
+			}
+
+			samples.emplace_back(std::chrono::duration<double, std::nano>(
+				std::chrono::steady_clock::now() - read_start).count());
+		}
+
+		const auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		const auto result = std::to_string(duration) + " " + std::to_string(tests::get_percentile(samples, 0.5)) + " " +
+			std::to_string(tests::get_percentile(samples, 0.99));
+		return utils::io::write_file((folder / ("result-" + std::to_string(index))).string(), result) ? 0 : 1;
+	}
+
+	void print_results(const char* name, const std::filesystem::path& folder, const size_t count)
+	{
+		double duration = 0.0;
+		double median = 0.0;
+		double p99 = 0.0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			double child_duration{}, child_median{}, child_p99{};
+			const auto result = utils::io::read_file((folder / ("result-" + std::to_string(i))).string());
+			EXPECT(sscanf(result.data(), "%lf %lf %lf", &child_duration, &child_median, &child_p99) == 3);
+
+			duration = std::max(duration, child_duration);
+			median = std::max(median, child_median);
+			p99 = std::max(p99, child_p99);
+		}
+
+		printf("  %-28s %10.0f reads/s, p50 %8.0f ns, p99 %8.0f ns\n", name,
+		       static_cast<double>(count * read_count) / duration, median, p99);
+	}
+}
+
+CHILD_PROCESS(snapshot_consistency_reader)
+{
+	const std::filesystem::path folder{argument};
+	const utils::shared_snapshot snapshot{get_snapshot_name(folder), snapshot_capacity};
+
+	wait_for_start(folder, index);
+
+	// Reads may give up while the writer keeps writing, but must never return a mix of two versions
+	size_t successful_reads = 0;
+	std::string data{};
+	for (size_t i = 0; i < read_count * 10; ++i)
+	{
+		if (!snapshot.read(data))
+		{
+			continue;
+		}
+
+		if (data.empty() || !is_consistent(data))
+		{
+			return 1;
+		}
+
+		++successful_reads;
+	}
+
+	return successful_reads ? 0 : 1;
+}
+
+CHILD_PROCESS(snapshot_reader)
+{
+	const std::filesystem::path folder{argument};
+	const utils::shared_snapshot snapshot{get_snapshot_name(folder), snapshot_capacity};
+
+	return measure_reads(index, folder, [&snapshot](std::string& data)
+	{
+		return snapshot.read(data);
+	});
+}
+
+// properties::load also checks that the snapshot still reflects the file, which costs a file status
+CHILD_PROCESS(checked_snapshot_reader)
+{
+	const std::filesystem::path folder{argument};
+	const utils::shared_snapshot snapshot{get_snapshot_name(folder), snapshot_capacity};
+	const auto file = folder / "properties.json";
+
+	return measure_reads(index, folder, [&](std::string& data)
+	{
+		std::error_code ec{};
+		return snapshot.read(data) && std::filesystem::last_write_time(file, ec) !=
+			std::filesystem::file_time_type{};
+	});
+}
+
+// What properties::load did before: take the lock and read the file. It also parsed the JSON, which is left out
+CHILD_PROCESS(locked_file_reader)
+{
+	const std::filesystem::path folder{argument};
+	const properties_lock lock{folder};
+	const auto file = (folder / "properties.json").string();
+
+	return measure_reads(index, folder, [&](std::string& data)
+	{
+		std::lock_guard<const properties_lock> _{lock};
+		return utils::io::read_file(file, &data);
+	});
+}
+
+TEST_CASE(shared_snapshot_is_never_torn_across_processes)
+{
+	const tests::temporary_folder folder{};
+	utils::shared_snapshot snapshot{get_snapshot_name(folder.get_path()), snapshot_capacity};
+	EXPECT(snapshot.publish(make_properties(properties_size, 0)));
+
+	// Sizes change with every version, so a torn read also mixes the data of different sizes
+	run_with_writer(folder.get_path(), 4, "snapshot_consistency_reader", std::chrono::microseconds(0),
+	                [&snapshot](const uint64_t version)
+	{
+		snapshot.publish(make_properties(properties_size / 2 + version % properties_size, version));
+	});
+}
+
+BENCHMARK(shared_snapshot_contention)
+{
+	const tests::temporary_folder folder{};
+	const auto& base = folder.get_path();
+
+	utils::shared_snapshot snapshot{get_snapshot_name(base), snapshot_capacity};
+	const properties_lock lock{base};
+
+	const auto publish = [&](const uint64_t version)
+	{
+		const auto properties = make_properties(properties_size, version);
+
+		std::lock_guard<const properties_lock> _{lock};
+		utils::io::replace_file((base / "properties.json").string(), properties);
+		snapshot.publish(properties);
+	};
+
+	publish(0);
+
+	for (const size_t count : {1, 2, 4, 8})
+	{
+		printf("%zu reader processes, %zu reads each:\n", count, read_count);
+
+		// Like the UI storing a setting every millisecond
+		for (const auto* child : {"locked_file_reader", "checked_snapshot_reader", "snapshot_reader"})
+		{
+			run_with_writer(base, count, child, std::chrono::milliseconds(1), publish);
+			print_results(child, base, count);
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <source_location>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace tests
+{
+	using test_function = void (*)();
+
+	struct test_case
+	{
+		const char* name{};
+		test_function function{};
+		bool benchmark{};
+	};
+
+	std::vector<test_case>& get_test_cases();
+
+	struct registration
+	{
+		registration(const char* name, test_function function, bool benchmark = false);
+	};
+
+	// Entry point of a child process, gets its index and the argument it was started with. Returns the exit code
+	using child_function = int (*)(size_t index, const std::string& argument);
+
+	struct child_registration
+	{
+		child_registration(const char* name, child_function function);
+	};
+
+	class failure : public std::runtime_error
+	{
+	public:
+		using std::runtime_error::runtime_error;
+	};
+
+	void expect(bool condition, const char* expression,
+	            const std::source_location& location = std::source_location::current());
+
+	// Starts the function on the given number of threads at once, each one gets its index.
+	// Returns the seconds until all of them finished
+	double run_on_threads(size_t count, const std::function<void(size_t index)>& function);
+
+	// Starts the test executable the given number of times to run the child function and waits for all of them.
+	// Throws if one of them fails
+	void run_in_processes(size_t count, const char* child, const std::string& argument);
+
+	// Share between 0 and 1, sorts the samples
+	double get_percentile(std::vector<double>& samples, double share);
+
+	// Empty folder that is removed again once the test finished
+	class temporary_folder
+	{
+	public:
+		temporary_folder();
+		~temporary_folder();
+
+		temporary_folder(temporary_folder&&) = delete;
+		temporary_folder(const temporary_folder&) = delete;
+		temporary_folder& operator=(temporary_folder&&) = delete;
+		temporary_folder& operator=(const temporary_folder&) = delete;
+
+		const std::filesystem::path& get_path() const;
+
+	private:
+		std::filesystem::path path_{};
+	};
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static const tests::registration name##_registration{#name, &name}; \
+	static void name()
+
+// Benchmarks only run with --benchmark and report their numbers instead of checking them
+#define BENCHMARK(name) \
+	static void name(); \
+	static const tests::registration name##_registration{#name, &name, true}; \
+	static void name()
+
+// Runs in its own process of the test executable, started through tests::run_in_processes
+#define CHILD_PROCESS(name) \
+	static int name(size_t index, const std::string& argument); \
+	static const tests::child_registration name##_registration{#name, &name}; \
+	static int name(const size_t index, const std::string& argument)
+
+#define EXPECT(condition) tests::expect(static_cast<bool>(condition), #condition)
@@ -0,0 +1,85 @@
+#include "test.hpp"
+
+#include <utils/tracing.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+TEST_CASE(tracing_exports_spans_of_every_thread)
+{
+	utils::tracing::enable();
+
+	{
+		utils::tracing::span outer{"outer \"quoted\""};
+		utils::tracing::span inner{"inner"};
+		inner.end();
+		inner.end();
+	}
+
+	std::thread([]()
+	{
+		utils::tracing::set_thread_name("worker");
+		utils::tracing::span _{"on worker"};
+	}).join();
+
+	const auto trace = utils::tracing::export_chrome_trace();
+
+	EXPECT(trace.starts_with("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+	EXPECT(trace.ends_with("\n]}\n"));
+	EXPECT(trace.find(R"("name":"outer \"quoted\"")") != std::string::npos);
+	EXPECT(trace.find(R"("args":{"name":"worker"})") != std::string::npos);
+	EXPECT(trace.find(R"("name":"on worker")") != std::string::npos);
+
+	// Ending a span twice records it once
+	const auto first = trace.find(R"("name":"inner")");
+	EXPECT(first != std::string::npos && trace.find(R"("name":"inner")", first + 1) == std::string::npos);
+}
+
+BENCHMARK(span_overhead)
+{
+	constexpr size_t span_count = 200000;
+	constexpr size_t thread_count = 8;
+
+	const auto measure = [](const char* name, const size_t threads, const auto& record)
+	{
+		const auto duration = tests::run_on_threads(threads, [&](size_t)
+		{
+			for (size_t i = 0; i < span_count; ++i)
+			{
+				record();
+			}
+		});
+
+		printf("  %-30s %6.1f ns per span\n", name, duration * 1e9 / static_cast<double>(span_count));
+	};
+
+	// Tracing cannot be disabled again, the disabled spans go first
+	printf("%zu spans per thread:\n", span_count);
+	measure("disabled", 1, []()
+	{
+		utils::tracing::span _{"disabled"};
+	});
+
+	measure("steady_clock::now, twice", 1, []()
+	{
+		const auto start = std::chrono::steady_clock::now();
+		EXPECT(std::chrono::steady_clock::now() >= start);
+	});
+
+	utils::tracing::enable();
+	measure("enabled", 1, []()
+	{
+		utils::tracing::span _{"enabled"};
+	});
+
+	measure("enabled, 8 threads at once", thread_count, []()
+	{
+		utils::tracing::span _{"concurrent"};
+	});
+
+	const auto start = std::chrono::steady_clock::now();
+	const auto trace = utils::tracing::export_chrome_trace();
+	printf("Exported %.1f MB in %.0f ms\n", static_cast<double>(trace.size()) / (1024.0 * 1024.0),
+	       std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
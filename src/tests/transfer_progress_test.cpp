@@ -0,0 +1,133 @@
+#include "test.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+	// The updater UI lives in the launcher and cannot be built here.
+	// These mirror its old locked progress bookkeeping and the lock-free one that replaced it
+	constexpr size_t transfer_count = 64;
+	constexpr size_t tick_count = 10001;
+	constexpr size_t file_size = tick_count * 1000;
+
+	std::string get_file_name(const size_t transfer)
+	{
+		return "file-" + std::to_string(transfer);
+	}
+
+	// Every tick takes the lock, stores the progress by name and sums all transfers again
+	class locked_progress
+	{
+	public:
+		void file_progress(const std::string& name, const size_t progress)
+		{
+			std::lock_guard<std::recursive_mutex> _{this->mutex_};
+			this->downloading_files_[name] = progress;
+			this->rendered_size_ = this->get_downloaded_size();
+		}
+
+		size_t get_downloaded_size() const
+		{
+			std::lock_guard<std::recursive_mutex> _{this->mutex_};
+
+			size_t downloaded_size = 0;
+			for (const auto& file : this->downloading_files_)
+			{
+				downloaded_size += file.second;
+			}
+
+			return downloaded_size;
+		}
+
+	private:
+		mutable std::recursive_mutex mutex_{};
+		std::unordered_map<std::string, size_t> downloading_files_{};
+		size_t rendered_size_{};
+	};
+
+	// Every tick swaps the transfer's own counter and adds the difference to the total
+	class atomic_progress
+	{
+	public:
+		atomic_progress()
+			: transfers_(std::make_unique<transfer[]>(transfer_count))
+		{
+			for (size_t i = 0; i < transfer_count; ++i)
+			{
+				this->file_indices_[get_file_name(i)] = i;
+			}
+		}
+
+		void file_progress(const std::string& name, const size_t progress)
+		{
+			auto& transfer = this->transfers_[this->file_indices_.at(name)];
+			const auto previous = transfer.progress.exchange(progress, std::memory_order_relaxed);
+			this->downloaded_size_.fetch_add(progress - previous, std::memory_order_relaxed);
+		}
+
+		size_t get_downloaded_size() const
+		{
+			return this->downloaded_size_.load(std::memory_order_relaxed);
+		}
+
+	private:
+		struct alignas(64) transfer
+		{
+			std::atomic<size_t> progress{0};
+		};
+
+		std::unordered_map<std::string, size_t> file_indices_{};
+		std::unique_ptr<transfer[]> transfers_{};
+		std::atomic<size_t> downloaded_size_{0};
+	};
+
+	// Every transfer fails half way once and starts over, like a retried download
+	template <typename Progress>
+	double run_transfers(Progress& progress)
+	{
+		return tests::run_on_threads(transfer_count, [&progress](const size_t index)
+		{
+			const auto name = get_file_name(index);
+
+			for (size_t i = 0; i < tick_count / 2; ++i)
+			{
+				progress.file_progress(name, i * 1000);
+			}
+
+			for (size_t i = 0; i < tick_count; ++i)
+			{
+				progress.file_progress(name, i * 1000);
+			}
+
+			progress.file_progress(name, file_size);
+		});
+	}
+}
+
+TEST_CASE(transfer_progress_survives_retries)
+{
+	atomic_progress progress{};
+	run_transfers(progress);
+
+	EXPECT(progress.get_downloaded_size() == transfer_count * file_size);
+}
+
+BENCHMARK(transfer_progress_64_transfers)
+{
+	locked_progress locked{};
+	atomic_progress atomic{};
+
+	const auto locked_time = run_transfers(locked);
+	const auto atomic_time = run_transfers(atomic);
+
+	EXPECT(locked.get_downloaded_size() == atomic.get_downloaded_size());
+
+	const auto ticks = static_cast<double>(transfer_count * (tick_count + tick_count / 2 + 1));
+	printf("%zu transfers: locked %.3f s (%.0f ns/tick), atomic %.3f s (%.0f ns/tick)\n", transfer_count,
+	       locked_time, locked_time / ticks * 1e9, atomic_time, atomic_time / ticks * 1e9);
+}
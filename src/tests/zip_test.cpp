@@ -0,0 +1,313 @@
+#include "test.hpp"
+
+#include <utils/compression.hpp>
+#include <utils/cryptography.hpp>
+#include <utils/io.hpp>
+
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+	constexpr uint16_t method_stored = 0;
+	constexpr uint16_t method_deflate = 8;
+
+	// Raw deflate streams written by zlib, one with fixed and one with dynamic Huffman codes
+	constexpr uint8_t fixed_deflate[] =
+	{
+		0xCB, 0x48, 0xCD, 0xC9, 0xC9, 0x57, 0xC8, 0x40, 0x27, 0xB9, 0x00
+	};
+
+	constexpr uint8_t dynamic_deflate[] =
+	{
+		0x9D, 0xD8, 0x4B, 0x36, 0x04, 0x31, 0x18, 0x80, 0xD1, 0xB9, 0x55, 0x64, 0x09, 0xF2, 0x4E, 0xEC,
+		0x06, 0x5D, 0x68, 0x4A, 0x17, 0x4D, 0x6B, 0xAC, 0xDE, 0x61, 0x07, 0xEE, 0x38, 0xE7, 0x1B, 0xE5,
+		0x9E, 0x3C, 0xFE, 0x75, 0x7F, 0x58, 0xC2, 0xE5, 0x55, 0x78, 0x7F, 0x58, 0xC2, 0xEB, 0x69, 0x7F,
+		0xFB, 0x14, 0x6E, 0x8E, 0xDB, 0xF9, 0x10, 0xEE, 0xB6, 0xCF, 0xF0, 0x78, 0x7A, 0x7E, 0x79, 0x0B,
+		0xDB, 0xC7, 0x72, 0xFC, 0x5B, 0x5E, 0xAF, 0xBF, 0xBF, 0xC2, 0x6E, 0xBB, 0xBF, 0x58, 0x7F, 0x9B,
+		0x08, 0x4D, 0x82, 0x26, 0x43, 0x53, 0xA0, 0xA9, 0xD0, 0x34, 0x68, 0x3A, 0x34, 0x03, 0x9A, 0x29,
+		0x7B, 0x4A, 0x10, 0x44, 0x42, 0x14, 0x0A, 0x51, 0x2C, 0x44, 0xC1, 0x10, 0x45, 0x43, 0x14, 0x0E,
+		0x51, 0x3C, 0x44, 0x01, 0x11, 0x45, 0x44, 0x12, 0x11, 0x89, 0xCE, 0x06, 0x11, 0x91, 0x44, 0x44,
+		0x12, 0x11, 0x49, 0x44, 0x24, 0x11, 0x91, 0x44, 0x44, 0x12, 0x11, 0x49, 0x44, 0x64, 0x11, 0x91,
+		0x45, 0x44, 0xA6, 0xEB, 0x42, 0x44, 0x64, 0x11, 0x91, 0x45, 0x44, 0x16, 0x11, 0x59, 0x44, 0x64,
+		0x11, 0x91, 0x45, 0x44, 0x11, 0x11, 0x45, 0x44, 0x14, 0x11, 0x51, 0xE8, 0x05, 0x21, 0x22, 0x8A,
+		0x88, 0x28, 0x22, 0xA2, 0x88, 0x88, 0x22, 0x22, 0x8A, 0x88, 0xA8, 0x22, 0xA2, 0x8A, 0x88, 0x2A,
+		0x22, 0xAA, 0x88, 0xA8, 0xF4, 0xA8, 0x14, 0x11, 0x55, 0x44, 0x54, 0x11, 0x51, 0x45, 0x44, 0x15,
+		0x11, 0x4D, 0x44, 0x34, 0x11, 0xD1, 0x44, 0x44, 0x13, 0x11, 0x4D, 0x44, 0x34, 0xFA, 0x67, 0x88,
+		0x88, 0x26, 0x22, 0x9A, 0x88, 0x68, 0x22, 0xA2, 0x8B, 0x88, 0x2E, 0x22, 0xBA, 0x88, 0xE8, 0x22,
+		0xA2, 0x8B, 0x88, 0x2E, 0x22, 0x3A, 0x7D, 0x3D, 0x45, 0x44, 0x17, 0x11, 0x5D, 0x44, 0x0C, 0x11,
+		0x31, 0x44, 0xC4, 0x10, 0x11, 0x43, 0x44, 0x0C, 0x11, 0x31, 0x44, 0xC4, 0x10, 0x11, 0x83, 0xA6,
+		0x11, 0x22, 0x62, 0x88, 0x88, 0x29, 0x22, 0xA6, 0x88, 0x98, 0x22, 0x62, 0x8A, 0x88, 0x29, 0x22,
+		0xA6, 0x88, 0x98, 0x22, 0x62, 0x8A, 0x88, 0x49, 0x03, 0xAA, 0x7F, 0x8A, 0xF8, 0x01
+	};
+
+	const std::string fixed_text = "hello hello hello hello\n";
+
+	std::string get_dynamic_text()
+	{
+		std::string text{};
+		for (auto i = 0; i < 100; ++i)
+		{
+			text += "line " + std::to_string(i) + ": the quick brown fox jumps over the lazy dog\n";
+		}
+
+		return text;
+	}
+
+	struct zip_entry
+	{
+		std::string name{};
+		std::string data{};
+		uint16_t method{method_stored};
+		uint32_t crc{};
+		uint32_t uncompressed_size{};
+	};
+
+	zip_entry make_stored(std::string name, std::string content)
+	{
+		zip_entry entry{};
+		entry.name = std::move(name);
+		entry.crc = utils::cryptography::crc32::compute(content);
+		entry.uncompressed_size = static_cast<uint32_t>(content.size());
+		entry.data = std::move(content);
+		return entry;
+	}
+
+	template <size_t Size>
+	zip_entry make_deflated(std::string name, const uint8_t (&data)[Size], const std::string& content)
+	{
+		zip_entry entry{};
+		entry.name = std::move(name);
+		entry.data.assign(reinterpret_cast<const char*>(data), Size);
+		entry.method = method_deflate;
+		entry.crc = utils::cryptography::crc32::compute(content);
+		entry.uncompressed_size = static_cast<uint32_t>(content.size());
+		return entry;
+	}
+
+	void write_u16(std::string& out, const uint32_t value)
+	{
+		out.push_back(static_cast<char>(value & 0xFF));
+		out.push_back(static_cast<char>(value >> 8 & 0xFF));
+	}
+
+	void write_u32(std::string& out, const uint32_t value)
+	{
+		write_u16(out, value & 0xFFFF);
+		write_u16(out, value >> 16);
+	}
+
+	// Version needed, flags, method, time, date, CRC and sizes, shared by local and central headers
+	void write_entry_fields(std::string& out, const zip_entry& entry)
+	{
+		write_u16(out, 20);
+		write_u16(out, 0);
+		write_u16(out, entry.method);
+		write_u32(out, 0);
+		write_u32(out, entry.crc);
+		write_u32(out, static_cast<uint32_t>(entry.data.size()));
+		write_u32(out, entry.uncompressed_size);
+		write_u16(out, static_cast<uint32_t>(entry.name.size()));
+		write_u16(out, 0);
+	}
+
+	std::string build_zip(const std::vector<zip_entry>& entries)
+	{
+		std::string archive{};
+		std::vector<uint32_t> offsets{};
+
+		for (const auto& entry : entries)
+		{
+			offsets.emplace_back(static_cast<uint32_t>(archive.size()));
+
+			write_u32(archive, 0x04034B50);
+			write_entry_fields(archive, entry);
+			archive += entry.name;
+			archive += entry.data;
+		}
+
+		const auto directory_offset = static_cast<uint32_t>(archive.size());
+
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			write_u32(archive, 0x02014B50);
+			write_u16(archive, 20);
+			write_entry_fields(archive, entries[i]);
+			write_u16(archive, 0);
+			write_u16(archive, 0);
+			write_u16(archive, 0);
+			write_u32(archive, 0);
+			write_u32(archive, offsets[i]);
+			archive += entries[i].name;
+		}
+
+		const auto directory_size = static_cast<uint32_t>(archive.size()) - directory_offset;
+
+		write_u32(archive, 0x06054B50);
+		write_u16(archive, 0);
+		write_u16(archive, 0);
+		write_u16(archive, static_cast<uint32_t>(entries.size()));
+		write_u16(archive, static_cast<uint32_t>(entries.size()));
+		write_u32(archive, directory_size);
+		write_u32(archive, directory_offset);
+		write_u16(archive, 0);
+
+		return archive;
+	}
+
+	void extract_streamed(const std::string& archive, const std::filesystem::path& into, const size_t piece_size)
+	{
+		utils::compression::zip::stream_extractor extractor{into};
+		for (size_t offset = 0; offset < archive.size(); offset += piece_size)
+		{
+			extractor.write(archive.data() + offset, std::min(piece_size, archive.size() - offset));
+		}
+
+		extractor.finish();
+	}
+
+	template <typename F>
+	bool throws(F&& function)
+	{
+		try
+		{
+			function();
+			return false;
+		}
+		catch (const std::exception&)
+		{
+			return true;
+		}
+	}
+
+	std::string read_file(const std::filesystem::path& file)
+	{
+		std::string data{};
+		return utils::io::read_file(file.string(), &data) ? data : std::string{"<missing>"};
+	}
+
+	size_t count_files(const std::filesystem::path& folder)
+	{
+		size_t count = 0;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(folder))
+		{
+			count += entry.is_regular_file();
+		}
+
+		return count;
+	}
+}
+
+TEST_CASE(zip_extracts_stored_and_deflated_entries)
+{
+	const auto archive = build_zip({
+		make_stored("data/", {}),
+		make_stored("data/stored.txt", "stored content"),
+		make_stored("data/empty.txt", {}),
+		make_deflated("data/fixed.txt", fixed_deflate, fixed_text),
+		make_deflated("dynamic.txt", dynamic_deflate, get_dynamic_text()),
+	});
+
+	const tests::temporary_folder folder{};
+	const auto whole = folder.get_path() / "whole";
+	const auto streamed = folder.get_path() / "streamed";
+
+	utils::compression::zip::extract(archive, whole);
+	extract_streamed(archive, streamed, 7);
+
+	for (const auto& into : {whole, streamed})
+	{
+		EXPECT(std::filesystem::is_directory(into / "data"));
+		EXPECT(read_file(into / "data" / "stored.txt") == "stored content");
+		EXPECT(read_file(into / "data" / "empty.txt").empty());
+		EXPECT(read_file(into / "data" / "fixed.txt") == fixed_text);
+		EXPECT(read_file(into / "dynamic.txt") == get_dynamic_text());
+	}
+}
+
+TEST_CASE(zip_rejects_corrupted_entries)
+{
+	auto corrupted = make_deflated("dynamic.txt", dynamic_deflate, get_dynamic_text());
+	corrupted.crc ^= 1;
+
+	auto truncated = make_deflated("dynamic.txt", dynamic_deflate, get_dynamic_text());
+	truncated.data.resize(truncated.data.size() / 2);
+
+	const tests::temporary_folder folder{};
+	EXPECT(throws([&] { utils::compression::zip::extract(build_zip({corrupted}), folder.get_path()); }));
+	EXPECT(throws([&] { utils::compression::zip::extract(build_zip({truncated}), folder.get_path()); }));
+	EXPECT(throws([&] { extract_streamed(build_zip({corrupted}), folder.get_path(), 64); }));
+}
+
+TEST_CASE(zip_refuses_entries_outside_the_target_folder)
+{
+	const tests::temporary_folder folder{};
+	const auto into = folder.get_path() / "into";
+
+	for (const auto* name : {"../escaped.txt", "data/../../escaped.txt", "..\\escaped.txt", "/escaped.txt", "C:/escaped.txt"})
+	{
+		const auto archive = build_zip({make_stored("valid.txt", "valid"), make_stored(name, "escaped")});
+
+		// Paths are checked before anything is written, the stream extractor can only check them as they arrive
+		EXPECT(throws([&] { utils::compression::zip::extract(archive, into); }));
+		EXPECT(!std::filesystem::exists(into / "valid.txt"));
+
+		EXPECT(throws([&] { extract_streamed(archive, into, 16); }));
+		std::filesystem::remove_all(into);
+	}
+
+	EXPECT(!std::filesystem::exists(folder.get_path() / "escaped.txt"));
+	EXPECT(!std::filesystem::exists(into / "escaped.txt"));
+}
+
+TEST_CASE(zip_rejects_sizes_the_data_cannot_produce)
+{
+	// Such headers would otherwise allocate up to 4 GB before the data is even looked at
+	auto deflated = make_deflated("dynamic.txt", dynamic_deflate, get_dynamic_text());
+	deflated.uncompressed_size = 0xFFFFFFF0;
+
+	auto stored = make_stored("stored.txt", "stored content");
+	stored.uncompressed_size = 0x7FFFFFFF;
+
+	const tests::temporary_folder folder{};
+
+	for (const auto& entry : {deflated, stored})
+	{
+		const auto archive = build_zip({entry});
+		EXPECT(throws([&] { utils::compression::zip::extract(archive, folder.get_path()); }));
+		EXPECT(throws([&] { extract_streamed(archive, folder.get_path(), 64); }));
+	}
+
+	EXPECT(count_files(folder.get_path()) == 0);
+}
+
+BENCHMARK(zip_extraction)
+{
+	constexpr size_t entry_count = 2000;
+
+	const auto text = get_dynamic_text();
+
+	std::vector<zip_entry> entries{};
+	for (size_t i = 0; i < entry_count; ++i)
+	{
+		const auto name = "folder-" + std::to_string(i % 20) + "/file-" + std::to_string(i) + ".txt";
+		entries.emplace_back(make_deflated(name, dynamic_deflate, text));
+	}
+
+	const auto archive = build_zip(entries);
+	const auto size = static_cast<double>(entry_count * text.size()) / (1024.0 * 1024.0);
+
+	const tests::temporary_folder folder{};
+
+	auto start = std::chrono::steady_clock::now();
+	utils::compression::zip::extract(archive, folder.get_path() / "whole");
+	const auto whole = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	extract_streamed(archive, folder.get_path() / "streamed", 64 * 1024);
+	const auto streamed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	EXPECT(count_files(folder.get_path()) == entry_count * 2);
+	printf("%zu entries, %.1f MB: extract %.3f s (%.1f MB/s), stream_extractor %.3f s (%.1f MB/s)\n", entry_count,
+	       size, whole, size / whole, streamed, size / streamed);
+}